@@ -1,11 +1,1898 @@
 
 #include "fir_filter.h"
+#include "fir_cli.h"
+#include "fir_batch.h"
+#include "fir_cic.h"
+#include "fir_ddc.h"
+#include "fir_farrow.h"
+#include "fir_ffa.h"
+#include "fir_filtfilt.h"
+#include "fir_fracdelay.h"
+#include "fir_hilbert.h"
+#include "fir_mc.h"
+#include "fir_numa.h"
+#include "fir_sample.h"
+#include "fir_service.h"
+#include "fir_shm.h"
+#include "fir_stream.h"
+#include "fir_sweep.h"
+#include "fir_tune.h"
+#include "fir_wav.h"
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+// Behaviour checks of the filter engines, run with "auto_test check [name ...]".
+// Each check returns the number of failures and reports them on stderr.
+
+// Deterministic test signal in [-1, 1)
+static void check_signal(float* x, int n, unsigned seed) {
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        x[i] = (float)(seed >> 8) / 8388608.0f - 1.0f;
+    }
+}
+
+// Reference: direct convolution in double, starting from silence
+static void check_convolve(const float* h, int numtaps, const float* x, double* y, int n) {
+    for (int i = 0; i < n; i++) {
+        double acc = 0.0;
+        for (int k = 0; k < numtaps && k <= i; k++) {
+            acc += (double)h[k] * x[i - k];
+        }
+        y[i] = acc;
+    }
+}
+
+// Largest difference between an output and the reference
+static double check_error(const float* y, const double* ref, int n) {
+    double err = 0.0;
+    for (int i = 0; i < n; i++) {
+        double d = fabs(y[i] - ref[i]);
+        if (d > err) err = d;
+    }
+    return err;
+}
+
+// Filter x in blocks of the given size with a new stream
+static int check_stream_blocks(const float* h, int numtaps, int flags, const float* x, float* y,
+                               int n, int block) {
+    struct fir_stream* stream = fir_stream_create_flags(h, numtaps, flags);
+    if (!stream) {
+        return -1;
+    }
+    for (int pos = 0; pos < n; pos += block) {
+        int len = n - pos < block ? n - pos : block;
+        fir_stream_process(stream, x + pos, y + pos, len);
+    }
+    fir_stream_destroy(stream);
+    return 0;
+}
+
+// Default streams give the same output, bit for bit, however the signal is
+// split into blocks
+static int check_stream(void) {
+    static const int taps_list[] = { 1, 5, 31, 32, 100, 512, 513, 1000 };
+    const int n = 4000;
+    const int blocks[] = { 1, 7, 64, 333 };
+    float* h = (float*)malloc(1000 * sizeof(float));
+    float* x = (float*)malloc(n * sizeof(float));
+    float* whole = (float*)malloc(n * sizeof(float));
+    float* y = (float*)malloc(n * sizeof(float));
+    double* ref = (double*)malloc(n * sizeof(double));
+    int failures = 0;
+    if (!h || !x || !whole || !y || !ref) {
+        fprintf(stderr, "stream: memory allocation failed\n");
+        failures = 1;
+    }
+    check_signal(x, n, 51);
+
+    for (size_t t = 0; !failures && t < sizeof(taps_list) / sizeof(taps_list[0]); t++) {
+        const int numtaps = taps_list[t];
+        float cutoffs[2] = { 0.0f, 0.2f };
+        firwin(numtaps, 2, cutoffs, 2.0f, HAMMING, h);
+        check_convolve(h, numtaps, x, ref, n);
+        if (check_stream_blocks(h, numtaps, 0, x, whole, n, n) != 0) {
+            fprintf(stderr, "stream: %d taps: stream creation failed\n", numtaps);
+            failures++;
+            continue;
+        }
+        double err = check_error(whole, ref, n);
+        if (err > 1e-4) {
+            fprintf(stderr, "stream: %d taps: error %g\n", numtaps, err);
+            failures++;
+        }
+
+        for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+            if (check_stream_blocks(h, numtaps, 0, x, y, n, blocks[b]) != 0 ||
+                memcmp(y, whole, n * sizeof(float)) != 0) {
+                fprintf(stderr, "stream: %d taps, blocks of %d: output differs from one block\n",
+                        numtaps, blocks[b]);
+                failures++;
+            }
+        }
+    }
+
+    free(h);
+    free(x);
+    free(whole);
+    free(y);
+    free(ref);
+    return failures;
+}
+
+// The fast FIR algorithm against direct convolution, fed in blocks of odd
+// sizes so output pairs straddle block boundaries
+static int check_ffa(void) {
+    static const int taps_list[] = { 64, 65, 127, 256, 300, 511, 512, 513 };
+    const int n = 4000;
+    const int blocks[] = { 1, 7, 64, 333, n };
+    float* h = (float*)malloc(513 * sizeof(float));
+    float* x = (float*)malloc(n * sizeof(float));
+    float* y = (float*)malloc(n * sizeof(float));
+    double* ref = (double*)malloc(n * sizeof(double));
+    int failures = 0;
+    if (!h || !x || !y || !ref) {
+        fprintf(stderr, "ffa: memory allocation failed\n");
+        failures = 1;
+    }
+    check_signal(x, n, 73);
+
+    for (size_t t = 0; !failures && t < sizeof(taps_list) / sizeof(taps_list[0]); t++) {
+        const int numtaps = taps_list[t];
+        float cutoffs[2] = { 0.0f, 0.2f };
+        firwin(numtaps, 2, cutoffs, 2.0f, HAMMING, h);
+        check_convolve(h, numtaps, x, ref, n);
+
+        for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+            if (check_stream_blocks(h, numtaps, FIR_STREAM_FFA, x, y, n, blocks[b]) != 0) {
+                fprintf(stderr, "ffa: %d taps: stream creation failed\n", numtaps);
+                failures++;
+                continue;
+            }
+            double err = check_error(y, ref, n);
+            if (err > 1e-4) {
+                fprintf(stderr, "ffa: %d taps, blocks of %d: error %g\n", numtaps, blocks[b], err);
+                failures++;
+            }
+        }
+    }
+
+    // The engine itself with 2- and 3-parallel stages and their nestings,
+    // called on pieces of odd lengths
+    static const int parallels[] = { 2, 3, 4, 6, 8, 9, 12 };
+    static const int engine_taps[] = { 5, 64, 100, 301, 513 };
+    float* rtaps = (float*)malloc(513 * sizeof(float));
+    float* xp = (float*)malloc((512 + n) * sizeof(float));
+    if (!failures && (!rtaps || !xp)) {
+        fprintf(stderr, "ffa: memory allocation failed\n");
+        failures = 1;
+    }
+    for (size_t t = 0; !failures && t < sizeof(engine_taps) / sizeof(engine_taps[0]); t++) {
+        const int numtaps = engine_taps[t];
+        float cutoffs[2] = { 0.0f, 0.3f };
+        firwin(numtaps, 2, cutoffs, 2.0f, HAMMING, h);
+        check_convolve(h, numtaps, x, ref, n);
+        for (int k = 0; k < numtaps; k++) {
+            rtaps[k] = h[numtaps - 1 - k];
+        }
+        memset(xp, 0, (numtaps - 1) * sizeof(float));
+        memcpy(xp + numtaps - 1, x, n * sizeof(float));
+
+        for (size_t p = 0; p < sizeof(parallels) / sizeof(parallels[0]); p++) {
+            struct fir_ffa* ffa = fir_ffa_create(rtaps, numtaps, parallels[p], 1000);
+            if (!ffa) {
+                fprintf(stderr, "ffa: %d taps, parallel %d: create failed\n", numtaps, parallels[p]);
+                failures++;
+                continue;
+            }
+            for (int pos = 0, len = 1000; pos < n; pos += len, len = len == 1000 ? 997 : 1000) {
+                fir_ffa_process(ffa, xp + pos, y + pos, n - pos < len ? n - pos : len);
+            }
+            fir_ffa_destroy(ffa);
+            double err = check_error(y, ref, n);
+            if (err > 1e-4) {
+                fprintf(stderr, "ffa: %d taps, parallel %d: error %g\n", numtaps, parallels[p], err);
+                failures++;
+            }
+        }
+    }
+    if (fir_ffa_create(h, 64, 5, 1000) != NULL) {
+        fprintf(stderr, "ffa: parallel 5 accepted\n");
+        failures++;
+    }
+
+    free(rtaps);
+    free(xp);
+    free(h);
+    free(x);
+    free(y);
+    free(ref);
+    return failures;
+}
+
+// Decimating streams against every factor-th sample of direct convolution,
+// bit for bit the same however the signal is split into blocks
+static int check_decimate(void) {
+    static const int taps_list[] = { 1, 7, 16, 33, 101, 512 };
+    static const int factors[] = { 2, 3, 8 };
+    const int n = 4000;
+    const int blocks[] = { 1, 7, 64, 333, n };
+    float* h = (float*)malloc(512 * sizeof(float));
+    float* x = (float*)malloc(n * sizeof(float));
+    float* whole = (float*)malloc(n * sizeof(float));
+    float* y = (float*)malloc((n + 1) * sizeof(float));
+    double* ref = (double*)malloc(n * sizeof(double));
+    int failures = 0;
+    if (!h || !x || !whole || !y || !ref) {
+        fprintf(stderr, "decimate: memory allocation failed\n");
+        failures = 1;
+    }
+    check_signal(x, n, 64);
+
+    for (size_t t = 0; !failures && t < sizeof(taps_list) / sizeof(taps_list[0]); t++) {
+        const int numtaps = taps_list[t];
+        float cutoffs[2] = { 0.0f, 0.1f };
+        firwin(numtaps, 2, cutoffs, 2.0f, HAMMING, h);
+        check_convolve(h, numtaps, x, ref, n);
+
+        for (size_t f = 0; f < sizeof(factors) / sizeof(factors[0]); f++) {
+            const int factor = factors[f];
+            int count = -1;
+            for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+                struct fir_stream* stream = fir_stream_create(h, numtaps);
+                int written = 0;
+                for (int pos = 0; stream && pos < n; pos += blocks[b]) {
+                    int len = n - pos < blocks[b] ? n - pos : blocks[b];
+                    written += fir_stream_decimate(stream, x + pos, y + written, len, factor);
+                }
+                fir_stream_destroy(stream);
+
+                if (b == 0) {
+                    count = written;
+                    memcpy(whole, y, written * sizeof(float));
+                    double err = 0.0;
+                    for (int i = 0; i < written; i++) {
+                        double d = fabs(y[i] - ref[i * factor]);
+                        if (d > err) err = d;
+                    }
+                    if (!stream || written != (n + factor - 1) / factor || err > 1e-4) {
+                        fprintf(stderr, "decimate: %d taps, factor %d: %d outputs, error %g\n",
+                                numtaps, factor, written, err);
+                        failures++;
+                    }
+                } else if (written != count || memcmp(y, whole, count * sizeof(float)) != 0) {
+                    fprintf(stderr, "decimate: %d taps, factor %d, blocks of %d: output differs\n",
+                            numtaps, factor, blocks[b]);
+                    failures++;
+                }
+            }
+        }
+    }
+
+    free(h);
+    free(x);
+    free(whole);
+    free(y);
+    free(ref);
+    return failures;
+}
+
+// Run x through a fresh stream whose history is held at x[0], as filtfilt
+// starts each pass
+static int check_stream_steady(const float* h, int numtaps, const float* x, float* y, int n) {
+    struct fir_stream* stream = fir_stream_create(h, numtaps);
+    if (!stream) {
+        return -1;
+    }
+    for (int k = 0; k < numtaps - 1; k++) {
+        float y0;
+        fir_stream_process(stream, x, &y0, 1);
+    }
+    fir_stream_process(stream, x, y, n);
+    fir_stream_destroy(stream);
+    return 0;
+}
+
+// filtfilt against the same extension filtered forward and then backward
+// with fir_stream, and with 1, 2 and 5 threads
+static int check_filtfilt(void) {
+    static const int taps_list[] = { 3, 31, 101 };
+    const int n = 100000;
+    float* h = (float*)malloc(101 * sizeof(float));
+    float* x = (float*)malloc(n * sizeof(float));
+    float* y = (float*)malloc(n * sizeof(float));
+    float* first = (float*)malloc(n * sizeof(float));
+    float* ext = (float*)malloc((n + 6 * 101) * sizeof(float));
+    float* fwd = (float*)malloc((n + 6 * 101) * sizeof(float));
+    int failures = 0;
+    if (!h || !x || !y || !first || !ext || !fwd) {
+        fprintf(stderr, "filtfilt: memory allocation failed\n");
+        failures = 1;
+    }
+    check_signal(x, n, 52);
+
+    for (size_t t = 0; !failures && t < sizeof(taps_list) / sizeof(taps_list[0]); t++) {
+        const int numtaps = taps_list[t];
+        const int padlen = 3 * numtaps;
+        const int len = n + 2 * padlen;
+        float cutoffs[2] = { 0.0f, 0.3f };
+        firwin(numtaps, 2, cutoffs, 2.0f, HAMMING, h);
+
+        // Odd extension, forward pass, reversal, backward pass, reversal
+        for (int i = 0; i < n; i++) {
+            ext[padlen + i] = x[i];
+        }
+        for (int j = 1; j <= padlen; j++) {
+            ext[padlen - j] = 2.0f * x[0] - x[j];
+            ext[padlen + n - 1 + j] = 2.0f * x[n - 1] - x[n - 1 - j];
+        }
+        check_stream_steady(h, numtaps, ext, fwd, len);
+        for (int i = 0; i < len; i++) {
+            ext[i] = fwd[len - 1 - i];
+        }
+        check_stream_steady(h, numtaps, ext, fwd, len);
+
+        const int threads[] = { 1, 2, 5 };
+        for (size_t k = 0; k < sizeof(threads) / sizeof(threads[0]); k++) {
+            if (fir_filtfilt(h, numtaps, x, y, n, threads[k]) != 0) {
+                fprintf(stderr, "filtfilt: %d taps, %d threads: failed\n", numtaps, threads[k]);
+                failures++;
+                continue;
+            }
+            double err = 0.0;
+            for (int i = 0; i < n; i++) {
+                double d = fabs(y[i] - fwd[len - 1 - padlen - i]);
+                if (d > err) err = d;
+            }
+            if (err > 1e-4) {
+                fprintf(stderr, "filtfilt: %d taps, %d threads: error %g\n", numtaps, threads[k], err);
+                failures++;
+            }
+            if (k == 0) {
+                memcpy(first, y, n * sizeof(float));
+            } else if (memcmp(first, y, n * sizeof(float)) != 0) {
+                fprintf(stderr, "filtfilt: %d taps: %d threads differ from 1\n", numtaps, threads[k]);
+                failures++;
+            }
+        }
+    }
+
+    free(h);
+    free(x);
+    free(y);
+    free(first);
+    free(ext);
+    free(fwd);
+    return failures;
+}
+
+// CIC decimator against the integrator-comb cascade written as N boxcars of
+// ratio samples, followed by the compensation filter, in double; bit for bit
+// the same however the input is split into blocks
+static int check_cic(void) {
+    static const struct { int ratio, stages, comp_ratio; } configs[] = {
+        { 5, 3, 1 }, { 8, 4, 2 }, { 16, 2, 3 },
+    };
+    const int n = 20000;
+    const int numtaps = 31;
+    const int blocks[] = { n, 1, 7, 1000, 5001 };
+    int32_t* x = (int32_t*)malloc(n * sizeof(int32_t));
+    float* xf = (float*)malloc(n * sizeof(float));
+    float* h = (float*)malloc(numtaps * sizeof(float));
+    float* whole = (float*)malloc(n * sizeof(float));
+    float* y = (float*)malloc(n * sizeof(float));
+    double* box = (double*)malloc(8 * 16 * sizeof(double));
+    double* mid = (double*)malloc(n * sizeof(double));
+    int failures = 0;
+    if (!x || !xf || !h || !whole || !y || !box || !mid) {
+        fprintf(stderr, "cic: memory allocation failed\n");
+        failures = 1;
+    }
+    check_signal(xf, n, 53);
+    for (int i = 0; !failures && i < n; i++) {
+        x[i] = (int32_t)(xf[i] * 32767.0f);
+    }
+
+    for (size_t c = 0; !failures && c < sizeof(configs) / sizeof(configs[0]); c++) {
+        const int ratio = configs[c].ratio;
+        const int stages = configs[c].stages;
+        const int comp_ratio = configs[c].comp_ratio;
+
+        // Impulse response of the cascade: a boxcar of ratio samples, stages times
+        int len = 1;
+        box[0] = 1.0;
+        for (int s = 0; s < stages; s++) {
+            for (int k = len + ratio - 2; k >= 0; k--) {
+                double acc = 0.0;
+                for (int j = 0; j < ratio; j++) {
+                    if (k - j >= 0 && k - j < len) acc += box[k - j];
+                }
+                box[k] = acc;
+            }
+            len += ratio - 1;
+        }
+
+        // The combs output every ratio-th sample, the first after ratio inputs
+        const int mids = n / ratio;
+        const double scale = 1.0 / pow((double)ratio, stages);
+        for (int j = 0; j < mids; j++) {
+            const int t = (j + 1) * ratio - 1;
+            double acc = 0.0;
+            for (int k = 0; k < len && k <= t; k++) {
+                acc += box[k] * x[t - k];
+            }
+            mid[j] = acc * scale;
+        }
+        if (fir_cic_compensator(ratio, stages, comp_ratio, 0.2f / comp_ratio, numtaps, HAMMING, h) != 0) {
+            fprintf(stderr, "cic: ratio %d: compensator design failed\n", ratio);
+            failures++;
+            continue;
+        }
+
+        const int expected = (mids + comp_ratio - 1) / comp_ratio;
+        for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+            struct fir_cic_decimator* dec = fir_cic_decimator_create(ratio, stages, 16, comp_ratio,
+                                                                     0.2f / comp_ratio, numtaps, HAMMING);
+            int written = 0;
+            for (int pos = 0; dec && pos < n; pos += blocks[b]) {
+                int count = n - pos < blocks[b] ? n - pos : blocks[b];
+                written += fir_cic_decimator_process(dec, x + pos, count, y + written);
+            }
+            fir_cic_decimator_destroy(dec);
+
+            if (b == 0) {
+                memcpy(whole, y, written * sizeof(float));
+                double err = 0.0;
+                for (int m = 0; m < written; m++) {
+                    double acc = 0.0;
+                    for (int k = 0; k < numtaps && k <= m * comp_ratio; k++) {
+                        acc += (double)h[k] * mid[m * comp_ratio - k];
+                    }
+                    double d = fabs(y[m] - acc);
+                    if (d > err) err = d;
+                }
+                if (!dec || written != expected || err > 1e-5 * 32767.0) {
+                    fprintf(stderr, "cic: ratio %d, %d stages, comp_ratio %d: %d outputs, error %g\n",
+                            ratio, stages, comp_ratio, written, err);
+                    failures++;
+                }
+            } else if (written != expected || memcmp(y, whole, expected * sizeof(float)) != 0) {
+                fprintf(stderr, "cic: ratio %d, blocks of %d: output differs\n", ratio, blocks[b]);
+                failures++;
+            }
+        }
+    }
+
+    free(x);
+    free(xf);
+    free(h);
+    free(whole);
+    free(y);
+    free(box);
+    free(mid);
+    return failures;
+}
+
+// Window value i of an n-point window from its textbook definition, in double
+static double check_window_value(enum fir_filter_window_type window, int n, int i) {
+    static const double cosine_sums[][5] = {
+        [HAMMING] = { 0.54, 0.46 },
+        [BLACKMAN] = { 0.42, 0.5, 0.08 },
+        [NUTTALL] = { 0.3635819, 0.4891775, 0.1365995, 0.0106411 },
+        [BLACKMANHARRIS] = { 0.35875, 0.48829, 0.14128, 0.01168 },
+        [FLATTOP] = { 0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368 },
+        [HANN] = { 0.5, 0.5 },
+    };
+    if (n == 1) {
+        return 1.0;
+    }
+    const double m = n - 1;
+    const double x = fabs(2.0 * i / m - 1.0);
+    switch (window) {
+        case RECTANGULAR:
+            return 1.0;
+        case TRIANGULAR:
+            return 1.0 - fabs((i - m / 2.0) / (n / 2.0));
+        case PARZEN:
+            return x <= 0.5 ? 1.0 - 6.0 * x * x * (1.0 - x) : 2.0 * pow(1.0 - x, 3);
+        case BOHMAN:
+            return (1.0 - x) * cos(M_PI * x) + sin(M_PI * x) / M_PI;
+        case BARTLETT:
+            return 1.0 - x;
+        case COSINE:
+            return sin(M_PI * (i + 0.5) / n);
+        default: {
+            double w = 0.0;
+            for (int t = 0; t < 5; t++) {
+                w += (t % 2 ? -1.0 : 1.0) * cosine_sums[window][t] * cos(2.0 * M_PI * t * i / m);
+            }
+            return w;
+        }
+    }
+}
+
+// Every window type against its definition; the half window, the full
+// window and the windowing of data agree exactly
+static int check_window(void) {
+    static const int lengths[] = { 1, 2, 3, 16, 17, 255, 1000 };
+    const int max_n = 1000;
+    float* w = (float*)malloc(max_n * sizeof(float));
+    float* half = (float*)malloc(max_n * sizeof(float));
+    float* x = (float*)malloc(max_n * sizeof(float));
+    float* data = (float*)malloc(max_n * sizeof(float));
+    int failures = 0;
+    if (!w || !half || !x || !data) {
+        fprintf(stderr, "window: memory allocation failed\n");
+        failures = 1;
+    }
+    check_signal(x, max_n, 55);
+
+    for (int type = RECTANGULAR; !failures && type <= COSINE; type++) {
+        const enum fir_filter_window_type window = (enum fir_filter_window_type)type;
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            const int n = lengths[l];
+            if (fir_window(window, n, w) != 0 || fir_window_half(window, n, half) != 0) {
+                fprintf(stderr, "window: type %d, length %d: failed\n", type, n);
+                failures++;
+                continue;
+            }
+            double err = 0.0;
+            for (int i = 0; i < n; i++) {
+                double d = fabs(w[i] - check_window_value(window, n, i));
+                if (d > err) err = d;
+            }
+            if (err > 1e-5) {
+                fprintf(stderr, "window: type %d, length %d: error %g\n", type, n, err);
+                failures++;
+            }
+
+            int mismatch = memcmp(half, w, (n + 1) / 2 * sizeof(float)) != 0;
+            for (int i = 0; i < n; i++) {
+                mismatch |= w[i] != w[n - 1 - i];
+            }
+            memcpy(data, x, n * sizeof(float));
+            mismatch |= fir_window_apply(window, n, data) != 0;
+            for (int i = 0; i < n; i++) {
+                mismatch |= data[i] != x[i] * w[i];
+            }
+            if (mismatch) {
+                fprintf(stderr, "window: type %d, length %d: half, full and applied windows differ\n",
+                        type, n);
+                failures++;
+            }
+        }
+    }
+
+    if (fir_window(HAMMING, 0, w) != -1 || fir_window_half((enum fir_filter_window_type)99, 5, w) != -1 ||
+        fir_window_apply(HANN, 5, NULL) != -1) {
+        fprintf(stderr, "window: invalid arguments accepted\n");
+        failures++;
+    }
+
+    free(w);
+    free(half);
+    free(x);
+    free(data);
+    return failures;
+}
+
+// Farrow resampler against the sinusoid it samples, taken at each output's
+// input position minus the stated delay; bit for bit the same however the
+// input is split into blocks
+static int check_farrow(void) {
+    static const double ratios[] = { 0.37, 1.0, 1.7, 3.0 };
+    static const int degrees[] = { 3, 5 };
+    const int taps_per_phase = 16;
+    const int phases = 32;
+    const int n = 5000;
+    const int blocks[] = { n, 1, 7, 1000 };
+    const double omega = 0.1 * M_PI;
+    const double delay = (taps_per_phase * phases - 1) / (2.0 * phases);
+    float* x = (float*)malloc(n * sizeof(float));
+    float* whole = (float*)malloc(3 * n * sizeof(float));
+    float* y = (float*)malloc(3 * n * sizeof(float));
+    int failures = 0;
+    if (!x || !whole || !y) {
+        fprintf(stderr, "farrow: memory allocation failed\n");
+        failures = 1;
+    }
+    for (int i = 0; !failures && i < n; i++) {
+        x[i] = (float)sin(omega * i);
+    }
+
+    for (size_t d = 0; !failures && d < sizeof(degrees) / sizeof(degrees[0]); d++) {
+        for (size_t r = 0; r < sizeof(ratios) / sizeof(ratios[0]); r++) {
+            const double ratio = ratios[r];
+            int count = -1;
+            for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+                struct fir_farrow* farrow = fir_farrow_create(taps_per_phase, phases, degrees[d], 0.8f,
+                                                              HAMMING, ratio);
+                int written = 0;
+                for (int pos = 0; farrow && pos < n; pos += blocks[b]) {
+                    int len = n - pos < blocks[b] ? n - pos : blocks[b];
+                    written += fir_farrow_process(farrow, x + pos, len, y + written);
+                }
+                fir_farrow_destroy(farrow);
+
+                if (b == 0) {
+                    count = written;
+                    memcpy(whole, y, written * sizeof(float));
+                    // Outputs whose inputs are all past the start
+                    double err = 0.0;
+                    for (int j = 0; j < written; j++) {
+                        double t = j / ratio;
+                        if (t < taps_per_phase) continue;
+                        double e = fabs(y[j] - sin(omega * (t - delay)));
+                        if (e > err) err = e;
+                    }
+                    if (!farrow || abs(written - (int)ceil(n * ratio)) > 1 || err > 5e-3) {
+                        fprintf(stderr, "farrow: degree %d, ratio %g: %d outputs, error %g\n",
+                                degrees[d], ratio, written, err);
+                        failures++;
+                    }
+                } else if (written != count || memcmp(y, whole, count * sizeof(float)) != 0) {
+                    fprintf(stderr, "farrow: degree %d, ratio %g, blocks of %d: output differs\n",
+                            degrees[d], ratio, blocks[b]);
+                    failures++;
+                }
+            }
+        }
+    }
+
+    free(x);
+    free(whole);
+    free(y);
+    return failures;
+}
+
+// Fractional-delay bank: the interpolated taps have unity gain at DC, apply
+// matches the taps dotted with the input, and a sinusoid comes out delayed
+// by (numtaps - 1) / 2 plus the fractional delay
+static int check_fracdelay(void) {
+    static const int taps_list[] = { 1, 8, 31, 64 };
+    static const float delays[] = { 0.0f, 0.13f, 0.5f, 0.77f, 0.999f, 1.0f };
+    static const enum fir_fracdelay_interp interps[] = { FIR_FRACDELAY_LINEAR, FIR_FRACDELAY_CUBIC };
+    const int phases = 64;
+    const double omega = 0.1 * M_PI;
+    float h[64];
+    float x[64];
+    int failures = 0;
+
+    for (size_t t = 0; t < sizeof(taps_list) / sizeof(taps_list[0]); t++) {
+        const int numtaps = taps_list[t];
+        struct fir_fracdelay* bank = fir_fracdelay_create(numtaps, phases, 0.9f, HAMMING);
+        if (!bank) {
+            fprintf(stderr, "fracdelay: %d taps: create failed\n", numtaps);
+            failures++;
+            continue;
+        }
+        for (size_t i = 0; i < sizeof(interps) / sizeof(interps[0]); i++) {
+            for (size_t d = 0; d < sizeof(delays) / sizeof(delays[0]); d++) {
+                const float delay = delays[d];
+                if (fir_fracdelay_taps(bank, delay, interps[i], h) != 0) {
+                    fprintf(stderr, "fracdelay: %d taps, delay %g: taps failed\n", numtaps, delay);
+                    failures++;
+                    continue;
+                }
+
+                // x holds the sinusoid up to the newest sample x[numtaps - 1]
+                const double want = numtaps - 1 - 0.5 * (numtaps - 1) - delay;
+                double sum = 0.0;
+                double dot = 0.0;
+                for (int n = 0; n < numtaps; n++) {
+                    x[n] = (float)sin(omega * n);
+                    sum += h[n];
+                }
+                for (int n = 0; n < numtaps; n++) {
+                    dot += (double)h[n] * x[numtaps - 1 - n];
+                }
+                const float y = fir_fracdelay_apply(bank, x, delay, interps[i]);
+
+                // One tap can only delay by whole samples
+                const double tol = numtaps == 1 ? 1.0 : numtaps < 31 ? 1e-2 : 3e-3;
+                if (fabs(sum - 1.0) > 1e-5 || fabs(y - dot) > 1e-5 || fabs(y - sin(omega * want)) > tol) {
+                    fprintf(stderr, "fracdelay: %d taps, interp %d, delay %g: gain %g, apply %g, "
+                            "dot %g, expected %g\n", numtaps, (int)interps[i], delay, sum, y, dot,
+                            sin(omega * want));
+                    failures++;
+                }
+            }
+        }
+        fir_fracdelay_destroy(bank);
+    }
+
+    if (fir_fracdelay_create(8, 0, 0.9f, HAMMING) || fir_fracdelay_taps(NULL, 0.5f, FIR_FRACDELAY_LINEAR, h) != -1) {
+        fprintf(stderr, "fracdelay: invalid arguments accepted\n");
+        failures++;
+    }
+    return failures;
+}
+
+// Hilbert transformer taps against the windowed ideal response; the
+// analytic signal generator against a delay and a convolution with those
+// taps, in blocks of any size, and with a constant envelope for a sinusoid
+static int check_hilbert(void) {
+    static const int taps_list[] = { 3, 5, 31, 63, 127 };
+    const int n = 3000;
+    const int blocks[] = { n, 1, 7, 1000 };
+    float* h = (float*)malloc(127 * sizeof(float));
+    float* x = (float*)malloc(n * sizeof(float));
+    float* re = (float*)malloc(n * sizeof(float));
+    float* im = (float*)malloc(n * sizeof(float));
+    float* whole = (float*)malloc(n * sizeof(float));
+    double* ref = (double*)malloc(n * sizeof(double));
+    int failures = 0;
+    if (!h || !x || !re || !im || !whole || !ref) {
+        fprintf(stderr, "hilbert: memory allocation failed\n");
+        failures = 1;
+    }
+    check_signal(x, n, 62);
+
+    for (size_t t = 0; !failures && t < sizeof(taps_list) / sizeof(taps_list[0]); t++) {
+        const int numtaps = taps_list[t];
+        const int center = (numtaps - 1) / 2;
+        if (firhilbert(numtaps, BLACKMAN, h) != 0) {
+            fprintf(stderr, "hilbert: %d taps: design failed\n", numtaps);
+            failures++;
+            continue;
+        }
+        double err = 0.0;
+        for (int i = 0; i < numtaps; i++) {
+            int m = i - center;
+            double ideal = m % 2 ? 2.0 / (M_PI * m) : 0.0;
+            double d = fabs(h[i] - ideal * check_window_value(BLACKMAN, numtaps, i));
+            if (d > err) err = d;
+        }
+        if (err > 1e-6) {
+            fprintf(stderr, "hilbert: %d taps: design error %g\n", numtaps, err);
+            failures++;
+        }
+
+        check_convolve(h, numtaps, x, ref, n);
+        for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+            struct fir_hilbert* hilbert = fir_hilbert_create(numtaps, BLACKMAN);
+            int result = hilbert ? 0 : -1;
+            for (int pos = 0; result == 0 && pos < n; pos += blocks[b]) {
+                int len = n - pos < blocks[b] ? n - pos : blocks[b];
+                result = fir_hilbert_process(hilbert, x + pos, re + pos, im + pos, len);
+            }
+            fir_hilbert_destroy(hilbert);
+
+            int delayed = result == 0;
+            for (int i = 0; i < n; i++) {
+                delayed &= re[i] == (i < center ? 0.0f : x[i - center]);
+            }
+            if (b == 0) {
+                memcpy(whole, im, n * sizeof(float));
+                err = check_error(im, ref, n);
+                if (!delayed || err > 1e-5) {
+                    fprintf(stderr, "hilbert: %d taps: in-phase %s, quadrature error %g\n", numtaps,
+                            delayed ? "delayed" : "wrong", err);
+                    failures++;
+                }
+            } else if (!delayed || memcmp(im, whole, n * sizeof(float)) != 0) {
+                fprintf(stderr, "hilbert: %d taps, blocks of %d: output differs\n", numtaps, blocks[b]);
+                failures++;
+            }
+        }
+    }
+
+    // A sinusoid in the passband has an envelope of its amplitude
+    struct fir_hilbert* hilbert = fir_hilbert_create(63, BLACKMAN);
+    for (int i = 0; !failures && i < n; i++) {
+        x[i] = (float)(0.5 * sin(0.2 * M_PI * i + 0.3));
+    }
+    if (!failures && (!hilbert || fir_hilbert_process(hilbert, x, re, im, n) != 0)) {
+        fprintf(stderr, "hilbert: envelope: processing failed\n");
+        failures++;
+    } else if (!failures) {
+        double err = 0.0;
+        for (int i = 63; i < n; i++) {
+            double d = fabs(sqrt((double)re[i] * re[i] + (double)im[i] * im[i]) - 0.5);
+            if (d > err) err = d;
+        }
+        if (err > 1e-3) {
+            fprintf(stderr, "hilbert: envelope error %g\n", err);
+            failures++;
+        }
+    }
+    fir_hilbert_destroy(hilbert);
+
+    free(h);
+    free(x);
+    free(re);
+    free(im);
+    free(whole);
+    free(ref);
+    return failures;
+}
+
+// Shared-memory banks: an attached reader keeps its generation while a new
+// one is published, switches on refresh, and nothing can attach once the
+// bank is unlinked
+static int check_shm(void) {
+    char name[64];
+    float first[2 * 5];
+    float second[3 * 7];
+    int failures = 0;
+    snprintf(name, sizeof(name), "/fir_check_%ld", (long)getpid());
+    for (int i = 0; i < 2 * 5; i++) first[i] = (float)i;
+    for (int i = 0; i < 3 * 7; i++) second[i] = -(float)i;
+
+    long long gen1 = fir_shm_bank_publish(name, first, 5, 2);
+    struct fir_shm_bank* bank = fir_shm_bank_attach(name);
+    if (gen1 < 1 || !bank || fir_shm_bank_generation(bank) != gen1 || fir_shm_bank_numtaps(bank) != 5 ||
+        fir_shm_bank_filters(bank) != 2 || memcmp(fir_shm_bank_taps(bank, 1), first + 5, 5 * sizeof(float)) != 0) {
+        fprintf(stderr, "shm: first generation not attached\n");
+        fir_shm_bank_detach(bank);
+        fir_shm_bank_unlink(name);
+        return 1;
+    }
+
+    // A bank filled in place, published while the reader holds the first
+    struct fir_shm_writer* writer = fir_shm_bank_create(name, 7, 3);
+    for (int f = 0; writer && f < 3; f++) {
+        memcpy(fir_shm_writer_taps(writer, f), second + 7 * f, 7 * sizeof(float));
+    }
+    long long gen2 = writer ? fir_shm_bank_commit(writer) : -1;
+    if (gen2 <= gen1 || fir_shm_bank_generation(bank) != gen1 ||
+        memcmp(fir_shm_bank_taps(bank, 0), first, 5 * sizeof(float)) != 0) {
+        fprintf(stderr, "shm: second generation %lld disturbed the reader\n", gen2);
+        failures++;
+    }
+    if (fir_shm_bank_refresh(bank) != 1 || fir_shm_bank_generation(bank) != gen2 ||
+        fir_shm_bank_numtaps(bank) != 7 || fir_shm_bank_filters(bank) != 3 ||
+        memcmp(fir_shm_bank_taps(bank, 2), second + 14, 7 * sizeof(float)) != 0) {
+        fprintf(stderr, "shm: refresh did not switch to generation %lld\n", gen2);
+        failures++;
+    }
+    if (fir_shm_bank_refresh(bank) != 0) {
+        fprintf(stderr, "shm: refresh of a current bank switched\n");
+        failures++;
+    }
+
+    // An aborted bank is never seen
+    writer = fir_shm_bank_create(name, 5, 1);
+    fir_shm_writer_abort(writer);
+    if (!writer || fir_shm_bank_refresh(bank) != 0 || fir_shm_bank_generation(bank) != gen2) {
+        fprintf(stderr, "shm: aborted bank became visible\n");
+        failures++;
+    }
+
+    fir_shm_bank_detach(bank);
+    if (fir_shm_bank_unlink(name) != 0 || (bank = fir_shm_bank_attach(name)) != NULL) {
+        fprintf(stderr, "shm: bank still attachable after unlink\n");
+        fir_shm_bank_detach(bank);
+        failures++;
+    }
+    return failures;
+}
+
+// Batched streams with mixed tap counts against per-stream convolution, bit
+// for bit the same however the signal is split into blocks
+static int check_batch(void) {
+    const int count = 37;
+    const int max_taps = 63;
+    const int n = 1000;
+    const int blocks[] = { n, 1, 7, 65, 333 };
+    float* h = (float*)malloc((size_t)count * max_taps * sizeof(float));
+    float* x = (float*)malloc((size_t)count * n * sizeof(float));
+    float* y = (float*)malloc((size_t)count * n * sizeof(float));
+    float* whole = (float*)malloc((size_t)count * n * sizeof(float));
+    double* ref = (double*)malloc(n * sizeof(double));
+    const float** in = (const float**)malloc(count * sizeof(float*));
+    float** out = (float**)malloc(count * sizeof(float*));
+    int failures = 0;
+    if (!h || !x || !y || !whole || !ref || !in || !out) {
+        fprintf(stderr, "batch: memory allocation failed\n");
+        failures = 1;
+    }
+    check_signal(x, failures ? 0 : count * n, 74);
+
+    struct fir_batch* batch = failures ? NULL : fir_batch_create(count, max_taps);
+    for (int i = 0; batch && i < count; i++) {
+        // 1 to max_taps taps, the longest in the middle of the first group
+        const int numtaps = i == 5 ? max_taps : 1 + (i * 17) % max_taps;
+        float cutoffs[2] = { 0.0f, 0.05f + 0.01f * (i % 30) };
+        firwin(numtaps, 2, cutoffs, 2.0f, HAMMING, h + (size_t)i * max_taps);
+        failures += fir_batch_set_taps(batch, i, h + (size_t)i * max_taps, numtaps) != 0;
+    }
+    if (!batch || failures) {
+        fprintf(stderr, "batch: setup failed\n");
+        failures++;
+    }
+
+    for (size_t b = 0; !failures && b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+        fir_batch_reset(batch);
+        for (int pos = 0; pos < n; pos += blocks[b]) {
+            int len = n - pos < blocks[b] ? n - pos : blocks[b];
+            for (int i = 0; i < count; i++) {
+                in[i] = x + (size_t)i * n + pos;
+                out[i] = y + (size_t)i * n + pos;
+            }
+            failures += fir_batch_process(batch, in, out, len) != 0;
+        }
+
+        if (b == 0) {
+            memcpy(whole, y, (size_t)count * n * sizeof(float));
+            for (int i = 0; i < count; i++) {
+                const int numtaps = i == 5 ? max_taps : 1 + (i * 17) % max_taps;
+                check_convolve(h + (size_t)i * max_taps, numtaps, x + (size_t)i * n, ref, n);
+                double err = check_error(y + (size_t)i * n, ref, n);
+                if (err > 1e-5) {
+                    fprintf(stderr, "batch: stream %d, %d taps: error %g\n", i, numtaps, err);
+                    failures++;
+                }
+            }
+        } else if (memcmp(y, whole, (size_t)count * n * sizeof(float)) != 0) {
+            fprintf(stderr, "batch: blocks of %d: output differs\n", blocks[b]);
+            failures++;
+        }
+    }
+
+    fir_batch_destroy(batch);
+    free(h);
+    free(x);
+    free(y);
+    free(whole);
+    free(ref);
+    free(in);
+    free(out);
+    return failures;
+}
+
+// Sample-by-sample filters of both forms against convolution
+static int check_sample(void) {
+    static const int taps_list[] = { 1, 2, 5, 16, 17, 33, 100 };
+    static const enum fir_sample_form forms[] = { FIR_SAMPLE_DIRECT, FIR_SAMPLE_TRANSPOSED };
+    const int n = 2000;
+    float* h = (float*)malloc(100 * sizeof(float));
+    float* x = (float*)malloc(n * sizeof(float));
+    float* y = (float*)malloc(n * sizeof(float));
+    double* ref = (double*)malloc(n * sizeof(double));
+    int failures = 0;
+    if (!h || !x || !y || !ref) {
+        fprintf(stderr, "sample: memory allocation failed\n");
+        failures = 1;
+    }
+    check_signal(x, n, 75);
+
+    for (size_t t = 0; !failures && t < sizeof(taps_list) / sizeof(taps_list[0]); t++) {
+        const int numtaps = taps_list[t];
+        check_signal(h, numtaps, 750 + numtaps);
+        check_convolve(h, numtaps, x, ref, n);
+        for (size_t f = 0; f < sizeof(forms) / sizeof(forms[0]); f++) {
+            struct fir_sample* filter = fir_sample_create(h, numtaps, forms[f]);
+            if (!filter) {
+                fprintf(stderr, "sample: %d taps, form %d: create failed\n", numtaps, (int)forms[f]);
+                failures++;
+                continue;
+            }
+            // Once through, then again after a reset
+            for (int pass = 0; pass < 2; pass++) {
+                for (int i = 0; i < n; i++) {
+                    y[i] = fir_sample_push(filter, x[i]);
+                }
+                double err = check_error(y, ref, n);
+                if (err > 1e-4) {
+                    fprintf(stderr, "sample: %d taps, form %d, pass %d: error %g\n", numtaps,
+                            (int)forms[f], pass, err);
+                    failures++;
+                }
+                fir_sample_reset(filter);
+            }
+            fir_sample_destroy(filter);
+        }
+    }
+
+    free(h);
+    free(x);
+    free(y);
+    free(ref);
+    return failures;
+}
+
+static double check_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Tuned streams against default streams, the tuning file against what was
+// measured, and auto mode measuring a length once even if the file cannot be
+// written
+static int check_tune(void) {
+    const int numtaps = 64;
+    const int n = 20000;
+    char path[64];
+    float* h = (float*)malloc(numtaps * sizeof(float));
+    float* x = (float*)malloc(n * sizeof(float));
+    float* y = (float*)malloc(n * sizeof(float));
+    float* ref = (float*)malloc(n * sizeof(float));
+    int failures = 0;
+    if (!h || !x || !y || !ref) {
+        fprintf(stderr, "tune: memory allocation failed\n");
+        failures = 1;
+    }
+    snprintf(path, sizeof(path), "/tmp/fir_check_tune_%ld", (long)getpid());
+    setenv("FIR_TUNE_FILE", path, 1);
+    check_signal(x, failures ? 0 : n, 68);
+
+    struct fir_tune_config best;
+    if (!failures) {
+        float cutoffs[2] = { 0.0f, 0.2f };
+        firwin(numtaps, 2, cutoffs, 2.0f, HAMMING, h);
+        if (fir_tune(h, numtaps, &best) != 0) {
+            fprintf(stderr, "tune: fir_tune failed\n");
+            failures++;
+        }
+    }
+
+    // The file holds the measured configuration
+    FILE* f = failures ? NULL : fopen(path, "r");
+    int stored = 0;
+    char line[512];
+    while (f && fgets(line, sizeof(line), f)) {
+        char* tab = strchr(line, '\t');
+        struct fir_tune_config c;
+        int taps;
+        if (tab && sscanf(tab + 1, "%d\t%d\t%d\t%d", &taps, &c.block, &c.unroll, &c.prefetch) == 4 &&
+            taps == numtaps) {
+            stored = c.block == best.block && c.unroll == best.unroll && c.prefetch == best.prefetch;
+        }
+    }
+    if (f) fclose(f);
+    struct fir_tune_config found;
+    if (!failures && (!stored || fir_tune_lookup(numtaps, &found) != 1 || found.block != best.block ||
+                      found.unroll != best.unroll || found.prefetch != best.prefetch)) {
+        fprintf(stderr, "tune: stored configuration does not round-trip\n");
+        failures++;
+    }
+
+    struct fir_stream* tuned = failures ? NULL : fir_stream_create_flags(h, numtaps, FIR_STREAM_TUNED);
+    struct fir_stream* plain = failures ? NULL : fir_stream_create(h, numtaps);
+    if (!failures && (!tuned || !plain || fir_stream_process(tuned, x, y, n) != 0 ||
+                      fir_stream_process(plain, x, ref, n) != 0 || memcmp(y, ref, n * sizeof(float)) != 0)) {
+        fprintf(stderr, "tune: tuned stream differs from default stream\n");
+        failures++;
+    }
+    fir_stream_destroy(tuned);
+    fir_stream_destroy(plain);
+
+    // With an unwritable file, the first creation measures and the second
+    // uses the result
+    setenv("FIR_TUNE_FILE", "/nonexistent/dir/tune", 1);
+    fir_tune_set_auto(1);
+    double times[2] = { 0.0, 0.0 };
+    for (int i = 0; !failures && i < 2; i++) {
+        double start = check_now();
+        struct fir_stream* s = fir_stream_create_flags(h, 15, FIR_STREAM_TUNED);
+        times[i] = check_now() - start;
+        fir_stream_destroy(s);
+        if (!s) {
+            fprintf(stderr, "tune: creation failed\n");
+            failures++;
+        }
+    }
+    if (!failures && times[1] > 0.1 * times[0]) {
+        fprintf(stderr, "tune: unsaved length measured again (%g s, then %g s)\n", times[0], times[1]);
+        failures++;
+    }
+    fir_tune_set_auto(0);
+    unsetenv("FIR_TUNE_FILE");
+    remove(path);
+    char lock[80];
+    snprintf(lock, sizeof(lock), "%s.lock", path);
+    remove(lock);
+
+    free(h);
+    free(x);
+    free(y);
+    free(ref);
+    return failures;
+}
+
+// Run a sweep from f0 to f1 over x in blocks, each block continuing the
+// previous one's frequency
+static int check_sweep_blocks(struct fir_sweep* sweep, const float* x, float* y, int n, int block,
+                              float f0, float f1) {
+    fir_sweep_reset(sweep);
+    for (int pos = 0; pos < n; pos += block) {
+        int len = n - pos < block ? n - pos : block;
+        float fa = f0 + (f1 - f0) * pos / n;
+        float fb = f0 + (f1 - f0) * (pos + len) / n;
+        if (fir_sweep_process(sweep, x + pos, y + pos, len, fa, fb) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Swept filters: at a constant grid frequency like a fir_stream with the
+// firwin taps, and the same sweep however the signal is split into blocks,
+// with taps updated every update_interval samples across calls
+static int check_sweep(void) {
+    static const int intervals[] = { 1, 64, 1000 };
+    const int numtaps = 63;
+    const int n = 5000;
+    const int blocks[] = { 1, 7, 333, 1500 };
+    float* h = (float*)malloc(numtaps * sizeof(float));
+    float* x = (float*)malloc(n * sizeof(float));
+    float* y = (float*)malloc(n * sizeof(float));
+    float* whole = (float*)malloc(n * sizeof(float));
+    double* ref = (double*)malloc(n * sizeof(double));
+    int failures = 0;
+    if (!h || !x || !y || !whole || !ref) {
+        fprintf(stderr, "sweep: memory allocation failed\n");
+        failures = 1;
+    }
+    check_signal(x, n, 59);
+
+    // Grid of 11 designs from 1000 to 6000 Hz: 3500 Hz is one of them
+    float cutoffs[2] = { 0.0f, 3500.0f };
+    if (!failures) {
+        firwin(numtaps, 2, cutoffs, 48000.0f, BLACKMAN, h);
+        check_convolve(h, numtaps, x, ref, n);
+    }
+    for (size_t i = 0; !failures && i < sizeof(intervals) / sizeof(intervals[0]); i++) {
+        struct fir_sweep* sweep = fir_sweep_create(numtaps, 48000.0f, BLACKMAN, 0.0f, 1000.0f, 6000.0f,
+                                                   11, intervals[i]);
+        if (!sweep || check_sweep_blocks(sweep, x, y, n, 777, 3500.0f, 3500.0f) != 0) {
+            fprintf(stderr, "sweep: interval %d: failed\n", intervals[i]);
+            fir_sweep_destroy(sweep);
+            failures++;
+            continue;
+        }
+        double err = check_error(y, ref, n);
+        if (err > 1e-5) {
+            fprintf(stderr, "sweep: interval %d: constant cutoff error %g\n", intervals[i], err);
+            failures++;
+        }
+
+        check_sweep_blocks(sweep, x, whole, n, n, 1000.0f, 6000.0f);
+        for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+            check_sweep_blocks(sweep, x, y, n, blocks[b], 1000.0f, 6000.0f);
+            double d = 0.0;
+            for (int k = 0; k < n; k++) {
+                if (fabs(y[k] - whole[k]) > d) d = fabs(y[k] - whole[k]);
+            }
+            if (d > 1e-4) {
+                fprintf(stderr, "sweep: interval %d, blocks of %d: differs by %g\n", intervals[i],
+                        blocks[b], d);
+                failures++;
+            }
+        }
+        fir_sweep_destroy(sweep);
+    }
+
+    free(h);
+    free(x);
+    free(y);
+    free(whole);
+    free(ref);
+    return failures;
+}
+
+// WAV headers written and read back through a temporary file, including an
+// empty file followed by another chunk and sizes filled in afterwards
+static int check_wav(void) {
+    static const struct fir_wav_info infos[] = {
+        { 2, 44100, FIR_FORMAT_S16, 1234 },
+        { 1, 48000, FIR_FORMAT_S24, 0 },
+        { 6, 96000, FIR_FORMAT_S32, 10 },
+        { 2, 8000, FIR_FORMAT_F32, -1 },
+    };
+    char path[64];
+    int failures = 0;
+    snprintf(path, sizeof(path), "/tmp/fir_check_wav_%ld", (long)getpid());
+
+    for (size_t i = 0; i < sizeof(infos) / sizeof(infos[0]); i++) {
+        struct fir_wav_info info = infos[i];
+        struct fir_wav_info got = { 0, 0, FIR_FORMAT_F32, 0 };
+        int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+        int ok = fd >= 0 && fir_wav_write_header(fd, &info) == 0;
+
+        // The samples, then a chunk that is not part of them
+        const long long frames = info.frames >= 0 ? info.frames : 77;
+        const size_t bytes = (size_t)frames * info.channels * fir_format_size(info.format);
+        unsigned char* data = (unsigned char*)calloc(bytes + 1, 1);
+        ok = ok && data && write(fd, data, bytes) == (ssize_t)bytes;
+        ok = ok && write(fd, "LIST\4\0\0\0abcd", 12) == 12;
+        if (ok && info.frames < 0) {
+            info.frames = frames;
+            ok = fir_wav_finish(fd, &info) == 0;
+        }
+        ok = ok && lseek(fd, 0, SEEK_SET) == 0 && fir_wav_read_header(fd, &got) == 0;
+        if (!ok || got.channels != info.channels || got.rate != info.rate || got.format != info.format ||
+            got.frames != info.frames) {
+            fprintf(stderr, "wav: format %d, %d channels, %lld frames: read back %d channels, format %d, "
+                    "%lld frames\n", (int)info.format, info.channels, info.frames, got.channels,
+                    (int)got.format, got.frames);
+            failures++;
+        }
+        free(data);
+        if (fd >= 0) close(fd);
+    }
+
+    // A streamed header keeps its sizes unknown
+    struct fir_wav_info info = { 2, 44100, FIR_FORMAT_S16, -1 };
+    struct fir_wav_info got;
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0 || fir_wav_write_header(fd, &info) != 0 || lseek(fd, 0, SEEK_SET) != 0 ||
+        fir_wav_read_header(fd, &got) != 0 || got.frames != -1) {
+        fprintf(stderr, "wav: streamed header not read as unknown size\n");
+        failures++;
+    }
+    if (fd >= 0) close(fd);
+    remove(path);
+    return failures;
+}
+
+// Sample conversion: the vector path (contiguous data) against the scalar
+// path (interleaved data) with and without dither, plain rounding against
+// its definition, and raw streams against float streams
+static int check_format(void) {
+    static const enum fir_sample_format formats[] = { FIR_FORMAT_S16, FIR_FORMAT_S24, FIR_FORMAT_S32 };
+    const int n = 1003;
+    float* x = (float*)malloc(n * sizeof(float));
+    float* back = (float*)malloc(n * sizeof(float));
+    float* y = (float*)malloc(n * sizeof(float));
+    float* ref = (float*)malloc(n * sizeof(float));
+    unsigned char* packed = (unsigned char*)malloc((size_t)n * 4);
+    unsigned char* strided = (unsigned char*)malloc((size_t)n * 8);
+    unsigned char* raw_out = (unsigned char*)malloc((size_t)n * 8);
+    int failures = 0;
+    if (!x || !back || !y || !ref || !packed || !strided || !raw_out) {
+        fprintf(stderr, "format: memory allocation failed\n");
+        free(x);
+        free(back);
+        free(y);
+        free(ref);
+        free(packed);
+        free(strided);
+        free(raw_out);
+        return 1;
+    }
+
+    // Up to 1.2 so the conversions clip
+    check_signal(x, n, 65);
+    for (int i = 0; i < n; i++) {
+        x[i] *= 1.2f;
+    }
+
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        const enum fir_sample_format format = formats[f];
+        const int size = fir_format_size(format);
+        const double scale = format == FIR_FORMAT_S16 ? 32768.0 : format == FIR_FORMAT_S24 ? 8388608.0
+                                                                                             : 2147483648.0;
+        // Without dither last, for the rounding check below
+        for (int dither = 1; dither >= 0; dither--) {
+            struct fir_dither d1, d2;
+            fir_dither_init(&d1, 7);
+            fir_dither_init(&d2, 7);
+            fir_format_from_float(x, packed, format, 1, n, dither ? &d1 : NULL);
+            fir_format_from_float(x, strided, format, 2, n, dither ? &d2 : NULL);
+            int mismatch = 0;
+            for (int i = 0; i < n; i++) {
+                mismatch |= memcmp(packed + (size_t)i * size, strided + (size_t)2 * i * size, size) != 0;
+            }
+            if (mismatch) {
+                fprintf(stderr, "format: %d bytes, dither %d: contiguous and strided differ\n", size, dither);
+                failures++;
+            }
+        }
+
+        // Without dither: round to nearest and clip; back to float: divide
+        fir_format_to_float(packed, format, 1, back, n);
+        fir_format_to_float(strided, format, 2, y, n);
+        int wrong = memcmp(back, y, n * sizeof(float)) != 0;
+        for (int i = 0; i < n; i++) {
+            double v = rint((double)x[i] * scale);
+            v = v < -scale ? -scale : v > scale - 1.0 ? scale - 1.0 : v;
+            wrong |= back[i] != (float)(v / scale);
+        }
+        if (wrong) {
+            fprintf(stderr, "format: %d bytes: conversion differs from rounding\n", size);
+            failures++;
+        }
+    }
+
+    // Channel 1 of interleaved stereo s16 through a raw stream, with float
+    // and s16 output, against a float stream on the converted samples
+    float h[31];
+    float cutoffs[2] = { 0.0f, 0.3f };
+    firwin(31, 2, cutoffs, 2.0f, HAMMING, h);
+    int16_t* stereo = (int16_t*)strided;
+    for (int i = 0; i < n; i++) {
+        stereo[2 * i] = (int16_t)(i * 37);
+        stereo[2 * i + 1] = (int16_t)rint(x[i] / 1.2f * 32000.0f);
+    }
+    fir_format_to_float(stereo + 1, FIR_FORMAT_S16, 2, back, n);
+    struct fir_stream* plain = fir_stream_create(h, 31);
+    struct fir_stream* to_f32 = fir_stream_create(h, 31);
+    struct fir_stream* to_s16 = fir_stream_create(h, 31);
+    int ok = plain && to_f32 && to_s16 && fir_stream_process(plain, back, ref, n) == 0 &&
+             fir_stream_set_format(to_f32, FIR_FORMAT_S16, FIR_FORMAT_F32, 2, 0) == 0 &&
+             fir_stream_set_format(to_s16, FIR_FORMAT_S16, FIR_FORMAT_S16, 2, 0) == 0;
+    float* f32 = (float*)raw_out;
+    for (int pos = 0, len = 1; ok && pos < n; pos += len, len = len * 3 % 500 + 1) {
+        len = n - pos < len ? n - pos : len;
+        ok = fir_stream_process_raw(to_f32, stereo + 2 * pos + 1, f32 + 2 * pos + 1, len) == 0;
+    }
+    for (int i = 0; ok && i < n; i++) {
+        y[i] = f32[2 * i + 1];
+    }
+    if (!ok || memcmp(y, ref, n * sizeof(float)) != 0) {
+        fprintf(stderr, "format: raw s16 to float stream differs from the float stream\n");
+        failures++;
+    }
+    int16_t* s16 = (int16_t*)raw_out;
+    int16_t* expect = (int16_t*)packed;
+    ok = ok && fir_stream_process_raw(to_s16, stereo + 1, s16 + 1, n) == 0;
+    fir_format_from_float(ref, expect, FIR_FORMAT_S16, 1, n, NULL);
+    for (int i = 0; ok && i < n; i++) {
+        ok = s16[2 * i + 1] == expect[i];
+    }
+    if (!ok) {
+        fprintf(stderr, "format: raw s16 stream differs from converting the float stream\n");
+        failures++;
+    }
+    fir_stream_destroy(plain);
+    fir_stream_destroy(to_f32);
+    fir_stream_destroy(to_s16);
+
+    free(x);
+    free(back);
+    free(y);
+    free(ref);
+    free(packed);
+    free(strided);
+    free(raw_out);
+    return failures;
+}
+
+// firwin_fft against firwin for several lengths, band counts and windows,
+// including the short filters it hands to firwin and a highpass ending at
+// Nyquist
+static int check_firwin_fft(void) {
+    static const int lengths[] = { 31, 63, 64, 101, 255, 1000, 2047 };
+    static const enum fir_filter_window_type windows[] = { RECTANGULAR, HAMMING, BLACKMAN, FLATTOP, HANN };
+    const float fs = 48000.0f;
+    const int max_taps = 2047;
+    float* h = (float*)malloc(max_taps * sizeof(float));
+    float* ref = (float*)malloc(max_taps * sizeof(float));
+    int failures = 0;
+    if (!h || !ref) {
+        fprintf(stderr, "firwin_fft: memory allocation failed\n");
+        free(h);
+        free(ref);
+        return 1;
+    }
+
+    float cutoffs[16];
+    for (int bands = 1; bands <= 8; bands *= 2) {
+        for (int highpass = 0; highpass < 2; highpass++) {
+            // Evenly spaced passbands; the highpass ones start at a cutoff
+            // and end at Nyquist
+            const int count = 2 * bands;
+            for (int i = 0; i < count; i++) {
+                cutoffs[i] = (i + 1 - highpass) * fs / 2.0f / (count + 1 - highpass);
+            }
+            if (!highpass) cutoffs[0] = 0.0f;
+            if (highpass) cutoffs[count - 1] = fs / 2.0f;
+
+            for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+                const int numtaps = lengths[l];
+                for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+                    const int expected = firwin(numtaps, count, cutoffs, fs, windows[w], ref);
+                    if (firwin_fft(numtaps, count, cutoffs, fs, windows[w], h) != expected) {
+                        fprintf(stderr, "firwin_fft: %d taps, %d bands, highpass %d, window %d: result "
+                                "differs from firwin\n", numtaps, bands, highpass, (int)windows[w]);
+                        failures++;
+                        continue;
+                    }
+                    if (expected != 0) continue;
+
+                    double peak = 0.0;
+                    double err = 0.0;
+                    for (int i = 0; i < numtaps; i++) {
+                        peak = fabs(ref[i]) > peak ? fabs(ref[i]) : peak;
+                        err = fabs(h[i] - ref[i]) > err ? fabs(h[i] - ref[i]) : err;
+                    }
+                    // Mostly firwin's own error: its sinc arguments are
+                    // single precision, which costs about 1e-5 at 1000 taps
+                    if (numtaps < 64 ? memcmp(h, ref, numtaps * sizeof(float)) != 0 : err > 2e-5 * peak) {
+                        fprintf(stderr, "firwin_fft: %d taps, %d bands, highpass %d, window %d: error %g "
+                                "of the largest tap\n", numtaps, bands, highpass, (int)windows[w], err / peak);
+                        failures++;
+                    }
+                }
+            }
+        }
+    }
+
+    free(h);
+    free(ref);
+    return failures;
+}
+
+// A design handle redesigned one cutoff and several cutoffs at a time gives
+// the taps firwin gives, for every window; rejected changes leave it as it was
+static int check_design(void) {
+    static const float moves[][4] = {
+        { 0.0f, 3000.0f, 9000.0f, 12000.0f },
+        { 0.0f, 3000.0f, 9000.0f, 15000.0f },
+        { 0.0f, 500.0f, 9000.0f, 15000.0f },
+        { 0.0f, 500.0f, 700.0f, 23000.0f },
+        { 0.0f, 4000.0f, 5000.0f, 6000.0f },
+    };
+    const int numtaps = 101;
+    const float fs = 48000.0f;
+    float h[101];
+    float ref[101];
+    int failures = 0;
+
+    for (int type = RECTANGULAR; type <= COSINE; type++) {
+        const enum fir_filter_window_type window = (enum fir_filter_window_type)type;
+        struct firwin_design* design = firwin_design_create(numtaps, 4, moves[0], fs, window);
+        if (!design) {
+            fprintf(stderr, "design: window %d: create failed\n", type);
+            failures++;
+            continue;
+        }
+
+        // Every cutoff of every move on its own, then the whole move at once
+        // from the previous one
+        float cutoffs[4];
+        memcpy(cutoffs, moves[0], sizeof(cutoffs));
+        int mismatch = 0;
+        for (size_t m = 0; m < sizeof(moves) / sizeof(moves[0]); m++) {
+            for (int i = 0; i < 4; i++) {
+                float previous[4];
+                memcpy(previous, cutoffs, sizeof(cutoffs));
+                cutoffs[i] = moves[m][i];
+                if (cutoffs[i] > (i < 3 ? cutoffs[i + 1] : fs / 2.0f) || (i > 0 && cutoffs[i] < cutoffs[i - 1])) {
+                    memcpy(cutoffs, previous, sizeof(cutoffs));
+                    continue;
+                }
+                mismatch |= firwin_design_set_cutoff(design, i, cutoffs[i]) != 0;
+                mismatch |= firwin_design_taps(design, h) != 0 ||
+                            firwin(numtaps, 4, cutoffs, fs, window, ref) != 0 ||
+                            memcmp(h, ref, sizeof(h)) != 0;
+            }
+            const float* next = moves[(m + 2) % (sizeof(moves) / sizeof(moves[0]))];
+            memcpy(cutoffs, next, sizeof(cutoffs));
+            mismatch |= firwin_design_set_cutoffs(design, cutoffs) != 0;
+            mismatch |= firwin_design_taps(design, h) != 0 ||
+                        firwin(numtaps, 4, cutoffs, fs, window, ref) != 0 ||
+                        memcmp(h, ref, sizeof(h)) != 0;
+        }
+        if (mismatch) {
+            fprintf(stderr, "design: window %d: taps differ from firwin\n", type);
+            failures++;
+        }
+
+        // Out of order, above Nyquist, out of range: all rejected, nothing changed
+        const float unordered[4] = { 0.0f, 9000.0f, 3000.0f, 12000.0f };
+        int accepted = firwin_design_set_cutoff(design, 1, cutoffs[2] + 1.0f) != -1;
+        accepted |= firwin_design_set_cutoff(design, 3, fs) != -1;
+        accepted |= firwin_design_set_cutoff(design, 4, 1000.0f) != -1;
+        accepted |= firwin_design_set_cutoff(design, -1, 1000.0f) != -1;
+        accepted |= firwin_design_set_cutoffs(design, unordered) != -1;
+        if (accepted || firwin_design_taps(design, h) != 0 || memcmp(h, ref, sizeof(h)) != 0) {
+            fprintf(stderr, "design: window %d: invalid cutoffs accepted or changed the design\n", type);
+            failures++;
+        }
+        firwin_design_destroy(design);
+    }
+
+    const float even[2] = { 0.0f, 24000.0f };
+    if (firwin_design_create(100, 2, even, fs, HAMMING) != NULL || firwin_design_taps(NULL, h) != -1) {
+        fprintf(stderr, "design: invalid arguments accepted\n");
+        failures++;
+    }
+    return failures;
+}
+
+// Multi-channel filter against a stream per channel, for several thread
+// counts, with the placement of every channel
+static int check_mc(void) {
+    static const int threads_list[] = { 0, 1, 2, 3, 8 };
+    const int channels = 5;
+    const int numtaps = 63;
+    const int n = 3000;
+    const int blocks[] = { 1000, 1, 777, 1222 };
+    float h[63];
+    float cutoffs[2] = { 0.0f, 0.2f };
+    float* x = (float*)malloc((size_t)channels * n * sizeof(float));
+    float* ref = (float*)malloc((size_t)channels * n * sizeof(float));
+    float* y = (float*)malloc((size_t)channels * n * sizeof(float));
+    float* first = (float*)malloc((size_t)channels * n * sizeof(float));
+    int failures = 0;
+    if (!x || !ref || !y || !first) {
+        fprintf(stderr, "mc: memory allocation failed\n");
+        free(x);
+        free(ref);
+        free(y);
+        free(first);
+        return 1;
+    }
+    firwin(numtaps, 2, cutoffs, 2.0f, HAMMING, h);
+    check_signal(x, channels * n, 67);
+    for (int ch = 0; ch < channels; ch++) {
+        check_stream_blocks(h, numtaps, 0, x + ch * n, ref + ch * n, n, n);
+    }
+
+    const int nodes = fir_numa_node_count();
+    for (size_t t = 0; t < sizeof(threads_list) / sizeof(threads_list[0]); t++) {
+        const int threads = threads_list[t];
+        struct fir_mc* mc = fir_mc_create(h, numtaps, channels, threads);
+        if (!mc) {
+            fprintf(stderr, "mc: %d threads: create failed\n", threads);
+            failures++;
+            continue;
+        }
+
+        // Twice, with a reset in between
+        for (int round = 0; round < 2; round++) {
+            int ok = 1;
+            for (int pos = 0, b = 0; ok && pos < n; pos += blocks[b], b++) {
+                const float* in[5];
+                float* out[5];
+                for (int ch = 0; ch < channels; ch++) {
+                    in[ch] = x + ch * n + pos;
+                    out[ch] = y + ch * n + pos;
+                }
+                ok = fir_mc_process(mc, in, out, blocks[b]) == 0;
+            }
+            double err = 0.0;
+            for (int i = 0; i < channels * n; i++) {
+                err = fabs(y[i] - ref[i]) > err ? fabs(y[i] - ref[i]) : err;
+            }
+            if (!ok || err > 1e-4) {
+                fprintf(stderr, "mc: %d threads, round %d: error %g against streams\n", threads, round, err);
+                failures++;
+            }
+            fir_mc_reset(mc);
+        }
+
+        // Every channel is filtered the same way whatever the thread count
+        if (t == 0) {
+            memcpy(first, y, (size_t)channels * n * sizeof(float));
+        } else if (memcmp(first, y, (size_t)channels * n * sizeof(float)) != 0) {
+            fprintf(stderr, "mc: %d threads: output differs from %d threads\n", threads, threads_list[0]);
+            failures++;
+        }
+
+        // One group per node, its channels split between at most the
+        // requested workers, all memory on the group's node where known
+        int bad = 0;
+        int max_worker = -1;
+        for (int ch = 0; ch < channels; ch++) {
+            struct fir_mc_placement p;
+            if (fir_mc_placement(mc, ch, &p) != 0) {
+                bad = 1;
+                continue;
+            }
+            bad |= p.node < 0 || p.node >= (nodes > 0 ? nodes : 1) || (nodes == 1 && p.node != 0);
+            bad |= (p.state_node != -1 && p.state_node != p.node) || (p.taps_node != -1 && p.taps_node != p.node);
+            bad |= p.worker < max_worker;
+            max_worker = p.worker > max_worker ? p.worker : max_worker;
+        }
+        if (nodes == 1 && threads > 0) {
+            bad |= max_worker + 1 != (threads < channels ? threads : channels);
+        }
+        struct fir_mc_placement p;
+        bad |= fir_mc_placement(mc, channels, &p) != -1 || fir_mc_placement(mc, -1, &p) != -1;
+        if (bad) {
+            fprintf(stderr, "mc: %d threads: wrong placement\n", threads);
+            failures++;
+        }
+        fir_mc_destroy(mc);
+    }
+
+    if (fir_mc_create(h, numtaps, 0, 1) != NULL || fir_mc_create(NULL, numtaps, 1, 1) != NULL) {
+        fprintf(stderr, "mc: invalid arguments accepted\n");
+        failures++;
+    }
+
+    free(x);
+    free(ref);
+    free(y);
+    free(first);
+    return failures;
+}
+
+// Down-converter bank against mixing, filtering and decimating in double
+// precision, for channels with different decimation factors spread over
+// several threads; a tone at a channel's center comes out as a constant
+static int check_ddc(void) {
+    static const int threads_list[] = { 1, 2, 3 };
+    static const int factors[] = { 1, 8, 3, 5 };
+    static const float freqs[] = { 1000.0f, 6000.0f, 11025.0f, 15500.0f };
+    const int channels = 4;
+    const int numtaps = 64;
+    const float fs = 48000.0f;
+    const int n = 5000;
+    const int blocks[] = { 1000, 1, 1500, 2499 };
+    float h[64];
+    float cutoffs[2] = { 0.0f, 1500.0f };
+    float* x = (float*)malloc(n * sizeof(float));
+    float* out[4];
+    float* first = (float*)malloc((size_t)channels * 2 * (n + 1) * sizeof(float));
+    double* ref = (double*)malloc((size_t)channels * 2 * (n + 1) * sizeof(double));
+    int failures = 0;
+    int alloc_failed = !x || !first || !ref;
+    for (int ch = 0; ch < channels; ch++) {
+        out[ch] = (float*)malloc(2 * (n + 1) * sizeof(float));
+        alloc_failed |= !out[ch];
+    }
+    if (alloc_failed) {
+        fprintf(stderr, "ddc: memory allocation failed\n");
+        failures = 1;
+    }
+
+    // A tone at channel 1's center plus a little noise
+    firwin(numtaps - 1, 2, cutoffs, fs, HAMMING, h);
+    h[numtaps - 1] = 0.0f;
+    if (!failures) {
+        check_signal(x, n, 69);
+        for (int i = 0; i < n; i++) {
+            x[i] = 0.8f * (float)cos(2.0 * M_PI * freqs[1] / fs * i + 0.3) + 0.1f * x[i];
+        }
+    }
+
+    // Output k of a channel is the filtered mixed signal at input k * factor
+    int ref_counts[4];
+    for (int ch = 0; !failures && ch < channels; ch++) {
+        double* r = ref + (size_t)ch * 2 * (n + 1);
+        ref_counts[ch] = 0;
+        for (int i = 0; i < n; i += factors[ch]) {
+            double re = 0.0;
+            double im = 0.0;
+            for (int k = 0; k < numtaps && k <= i; k++) {
+                double w = 2.0 * M_PI * freqs[ch] / fs * (i - k);
+                re += h[k] * x[i - k] * cos(w);
+                im -= h[k] * x[i - k] * sin(w);
+            }
+            r[2 * ref_counts[ch]] = re;
+            r[2 * ref_counts[ch] + 1] = im;
+            ref_counts[ch]++;
+        }
+    }
+
+    for (size_t t = 0; !failures && t < sizeof(threads_list) / sizeof(threads_list[0]); t++) {
+        const int threads = threads_list[t];
+        struct fir_ddc* ddc = fir_ddc_create(h, numtaps, fs, channels, freqs, factors, threads);
+        if (!ddc) {
+            fprintf(stderr, "ddc: %d threads: create failed\n", threads);
+            failures++;
+            continue;
+        }
+
+        // Twice, with a reset in between
+        for (int round = 0; round < 2; round++) {
+            int total[4] = { 0, 0, 0, 0 };
+            int ok = 1;
+            for (int pos = 0, b = 0; ok && pos < n; pos += blocks[b], b++) {
+                float* dst[4];
+                int counts[4];
+                for (int ch = 0; ch < channels; ch++) {
+                    dst[ch] = out[ch] + 2 * total[ch];
+                }
+                ok = fir_ddc_process(ddc, x + pos, blocks[b], dst, counts) == 0;
+                for (int ch = 0; ch < channels; ch++) {
+                    total[ch] += counts[ch];
+                }
+            }
+
+            for (int ch = 0; ch < channels; ch++) {
+                const double* r = ref + (size_t)ch * 2 * (n + 1);
+                double err = 0.0;
+                for (int k = 0; ok && total[ch] == ref_counts[ch] && k < 2 * total[ch]; k++) {
+                    err = fabs(out[ch][k] - r[k]) > err ? fabs(out[ch][k] - r[k]) : err;
+                }
+                if (!ok || total[ch] != ref_counts[ch] || err > 1e-4) {
+                    fprintf(stderr, "ddc: %d threads, round %d, channel %d: %d outputs, error %g\n",
+                            threads, round, ch, total[ch], err);
+                    failures++;
+                }
+            }
+            fir_ddc_reset(ddc);
+        }
+
+        // The tone at its center: a constant 0.4 * exp(0.3i) once the
+        // filter has filled
+        double dev = 0.0;
+        for (int k = numtaps / factors[1]; k < ref_counts[1]; k++) {
+            double dre = out[1][2 * k] - 0.4 * cos(0.3);
+            double dim = out[1][2 * k + 1] - 0.4 * sin(0.3);
+            dev = sqrt(dre * dre + dim * dim) > dev ? sqrt(dre * dre + dim * dim) : dev;
+        }
+        if (dev > 0.05) {
+            fprintf(stderr, "ddc: %d threads: centered tone deviates by %g\n", threads, dev);
+            failures++;
+        }
+
+        // Each channel is computed the same way whatever the thread count
+        int mismatch = 0;
+        for (int ch = 0; ch < channels; ch++) {
+            float* keep = first + (size_t)ch * 2 * (n + 1);
+            if (t == 0) {
+                memcpy(keep, out[ch], 2 * ref_counts[ch] * sizeof(float));
+            } else {
+                mismatch |= memcmp(keep, out[ch], 2 * ref_counts[ch] * sizeof(float)) != 0;
+            }
+        }
+        if (mismatch) {
+            fprintf(stderr, "ddc: %d threads: output differs from %d thread\n", threads, threads_list[0]);
+            failures++;
+        }
+        fir_ddc_destroy(ddc);
+    }
+
+    const int bad_factors[] = { 1, 0, 3, 5 };
+    if (fir_ddc_create(h, numtaps, fs, channels, freqs, bad_factors, 1) != NULL) {
+        fprintf(stderr, "ddc: invalid arguments accepted\n");
+        failures++;
+    }
+
+    free(x);
+    free(first);
+    free(ref);
+    for (int ch = 0; ch < channels; ch++) {
+        free(out[ch]);
+    }
+    return failures;
+}
+
+struct check_service_server {
+    char path[64];
+    volatile sig_atomic_t stop;
+    int result;
+};
+
+static void* check_service_thread(void* arg) {
+    struct check_service_server* server = (struct check_service_server*)arg;
+    server->result = fir_service_serve(server->path, 4, &server->stop);
+    return NULL;
+}
+
+// Inode of the file mapped at addr, from /proc/self/maps, or 0
+static unsigned long check_mapped_inode(const void* addr) {
+    FILE* f = fopen("/proc/self/maps", "r");
+    char line[512];
+    unsigned long inode = 0;
+    while (f && fgets(line, sizeof(line), f)) {
+        unsigned long start, end, ino;
+        if (sscanf(line, "%lx-%lx %*s %*s %*s %lu", &start, &end, &ino) == 3 &&
+            (unsigned long)addr >= start && (unsigned long)addr < end) {
+            inode = ino;
+            break;
+        }
+    }
+    if (f) fclose(f);
+    return inode;
+}
+
+// Design server on a thread: designs equal firwin's, a repeated request maps
+// the cached memfd again, invalid requests fail
+static int check_service(void) {
+    static const float cutoffs[4] = { 0.0f, 3000.0f, 8000.0f, 12000.0f };
+    static const float unordered[4] = { 0.0f, 8000.0f, 3000.0f, 12000.0f };
+    static const float to_nyquist[4] = { 0.0f, 3000.0f, 8000.0f, 24000.0f };
+    const int numtaps = 101;
+    const float fs = 48000.0f;
+    float ref[101];
+    struct check_service_server server;
+    pthread_t thread;
+    int failures = 0;
+
+    snprintf(server.path, sizeof(server.path), "/tmp/fir_check_service_%ld", (long)getpid());
+    server.stop = 0;
+    server.result = 0;
+    if (pthread_create(&thread, NULL, check_service_thread, &server) != 0) {
+        fprintf(stderr, "service: cannot start the server\n");
+        return 1;
+    }
+
+    // The server is up once it answers
+    const float* a = NULL;
+    for (int tries = 0; !a && tries < 200; tries++) {
+        a = fir_service_design(server.path, numtaps, 4, cutoffs, fs, BLACKMAN);
+        if (!a) usleep(10000);
+    }
+    const float* b = fir_service_design(server.path, numtaps, 4, cutoffs, fs, BLACKMAN);
+    firwin(numtaps, 4, cutoffs, fs, BLACKMAN, ref);
+    if (!a || !b || memcmp(a, ref, sizeof(ref)) != 0 || memcmp(b, ref, sizeof(ref)) != 0) {
+        fprintf(stderr, "service: design missing or different from firwin\n");
+        failures++;
+    } else if (a == b || check_mapped_inode(a) == 0 || check_mapped_inode(a) != check_mapped_inode(b)) {
+        fprintf(stderr, "service: repeated request not served from the same memfd\n");
+        failures++;
+    }
+    fir_service_release(a, numtaps);
+    fir_service_release(b, numtaps);
+
+    const float* other = fir_service_design(server.path, numtaps, 4, cutoffs, fs, HANN);
+    firwin(numtaps, 4, cutoffs, fs, HANN, ref);
+    if (!other || memcmp(other, ref, sizeof(ref)) != 0) {
+        fprintf(stderr, "service: second design different from firwin\n");
+        failures++;
+    }
+    fir_service_release(other, numtaps);
+
+    if (fir_service_design(server.path, numtaps, 4, unordered, fs, HANN) != NULL ||
+        fir_service_design(server.path, 100, 4, to_nyquist, fs, HANN) != NULL ||
+        fir_service_design(server.path, 0, 4, cutoffs, fs, HANN) != NULL) {
+        fprintf(stderr, "service: invalid request answered\n");
+        failures++;
+    }
+
+    // Stop, waking the server with one more request
+    server.stop = 1;
+    const float* last = fir_service_design(server.path, numtaps, 4, cutoffs, fs, BLACKMAN);
+    fir_service_release(last, numtaps);
+    pthread_join(thread, NULL);
+    if (server.result != 0 || access(server.path, F_OK) == 0) {
+        fprintf(stderr, "service: server failed or left its socket behind\n");
+        failures++;
+    }
+    return failures;
+}
+
+static const struct {
+    const char* name;
+    int (*run)(void);
+} checks[] = {
+    { "stream", check_stream },
+    { "ffa", check_ffa },
+    { "decimate", check_decimate },
+    { "filtfilt", check_filtfilt },
+    { "cic", check_cic },
+    { "window", check_window },
+    { "farrow", check_farrow },
+    { "fracdelay", check_fracdelay },
+    { "hilbert", check_hilbert },
+    { "shm", check_shm },
+    { "batch", check_batch },
+    { "sample", check_sample },
+    { "sweep", check_sweep },
+    { "tune", check_tune },
+    { "wav", check_wav },
+    { "format", check_format },
+    { "firwin_fft", check_firwin_fft },
+    { "design", check_design },
+    { "mc", check_mc },
+    { "ddc", check_ddc },
+    { "service", check_service },
+};
+
+static int run_checks(int count, char* names[]) {
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++) {
+        int selected = count == 0;
+        for (int j = 0; j < count; j++) {
+            selected |= strcmp(names[j], checks[i].name) == 0;
+        }
+        if (selected) {
+            int f = checks[i].run();
+            printf("# Check %s: %s\n", checks[i].name, f ? "FAILED" : "passed");
+            failures += f;
+        }
+    }
+    return failures ? 1 : 0;
+}
 
 void print_usage(const char* prog_name) {
     printf("Usage: %s <numtaps> <fs> <window_type> <cutoff1> [cutoff2 ...]\n", prog_name);
+    printf("       %s check [name ...]\n", prog_name);
     printf("  numtaps:    Number of filter taps (must be odd)\n");
     printf("  fs:         Sampling frequency in Hz\n");
     printf("  window_type: Window type (number or name):\n");
@@ -17,41 +1904,11 @@ void print_usage(const char* prog_name) {
     printf("Example: %s 101 44100.0 hann 500.0 1000.0 3000.0 4000.0\n", prog_name);
 }
 
-int parse_window_type(const char* str) {
-    if (strcmp(str, "0") == 0 || strcasecmp(str, "rectangular") == 0 || strcasecmp(str, "boxcar") == 0) return RECTANGULAR;
-    if (strcmp(str, "1") == 0 || strcasecmp(str, "hamming") == 0) return HAMMING;
-    if (strcmp(str, "2") == 0 || strcasecmp(str, "blackman") == 0) return BLACKMAN;
-    if (strcmp(str, "3") == 0 || strcasecmp(str, "triangular") == 0) return TRIANGULAR;
-    if (strcmp(str, "4") == 0 || strcasecmp(str, "parzen") == 0) return PARZEN;
-    if (strcmp(str, "5") == 0 || strcasecmp(str, "bohman") == 0) return BOHMAN;
-    if (strcmp(str, "6") == 0 || strcasecmp(str, "nuttall") == 0) return NUTTALL;
-    if (strcmp(str, "7") == 0 || strcasecmp(str, "blackmanharris") == 0 || strcasecmp(str, "blackman-harris") == 0) return BLACKMANHARRIS;
-    if (strcmp(str, "8") == 0 || strcasecmp(str, "flattop") == 0) return FLATTOP;
-    if (strcmp(str, "9") == 0 || strcasecmp(str, "bartlett") == 0) return BARTLETT;
-    if (strcasecmp(str, "10") == 0 || strcasecmp(str, "hann") == 0) return HANN;
-    if (strcasecmp(str, "11") == 0 || strcasecmp(str, "cosine") == 0) return COSINE;
-    return -1;
-}
-
-const char* get_window_name(enum fir_filter_window_type window) {
-    switch (window) {
-        case RECTANGULAR:   return "Rectangular (boxcar)";
-        case HAMMING:       return "Hamming";
-        case BLACKMAN:      return "Blackman";
-        case TRIANGULAR:    return "Triangular";
-        case PARZEN:        return "Parzen";
-        case BOHMAN:        return "Bohman";
-        case NUTTALL:       return "Nuttall";
-        case BLACKMANHARRIS:return "Blackman-Harris";
-        case FLATTOP:       return "Flat-top";
-        case BARTLETT:      return "Bartlett";
-        case HANN:          return "Hann";
-        case COSINE:        return "Cosine (sine)";
-        default:            return "Unknown";
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "check") == 0) {
+        return run_checks(argc - 2, argv + 2);
     }
-}
 
-int main(int argc, char* argv[]) {
     // Check minimum number of arguments
     if (argc < 5) {
         print_usage(argv[0]);
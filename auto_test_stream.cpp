@@ -0,0 +1,113 @@
+// Check of the C++20 interface in fir_stream.hpp, run by "make check": a
+// source that suspends between blocks is filtered with fir::filter() and
+// compared with fir_stream_process() on the whole signal, and every block
+// must be yielded from the same output buffer.
+
+#include "fir_stream.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Coroutines suspended by the source, resumed by main() like an event loop
+static std::vector<std::coroutine_handle<>> pending;
+
+struct suspend_to_loop {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) { pending.push_back(h); }
+    void await_resume() const noexcept {}
+};
+
+static fir::async_generator<std::span<const float>> source(const std::vector<float>& x) {
+    static const std::size_t sizes[] = { 1, 7, 5000, 333, 64 };
+    std::size_t pos = 0;
+    for (std::size_t k = 0; pos < x.size(); k++) {
+        co_await suspend_to_loop{};
+        const std::size_t n = std::min(sizes[k % 5], x.size() - pos);
+        co_yield std::span<const float>(x.data() + pos, n);
+        pos += n;
+    }
+}
+
+// Eagerly started coroutine that runs to completion
+struct task {
+    struct promise_type {
+        task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+struct result {
+    std::vector<float> y;
+    std::size_t blocks = 0;
+    std::size_t largest = 0;
+    bool same_buffer = true;
+    bool finished = false;
+};
+
+static task consume(fir::async_generator<std::span<const float>> blocks, result& r) {
+    const float* buffer = nullptr;
+    while (auto block = co_await blocks.next()) {
+        if (buffer && block->data() != buffer) {
+            r.same_buffer = false;
+        }
+        buffer = block->data();
+        r.blocks++;
+        r.largest = std::max(r.largest, block->size());
+        r.y.insert(r.y.end(), block->begin(), block->end());
+    }
+    r.finished = true;
+}
+
+int main() {
+    const std::size_t capacity = 1000;
+    std::vector<float> x(20000);
+    for (std::size_t i = 0; i < x.size(); i++) {
+        x[i] = static_cast<float>(std::sin(1e-4 * static_cast<double>(i * i)));
+    }
+    float taps[51];
+    float cutoffs[2] = { 0.0f, 0.2f };
+    firwin(51, 2, cutoffs, 2.0f, HAMMING, taps);
+
+    result r;
+    consume(fir::filter(fir::stream(taps), source(x), capacity), r);
+    while (!pending.empty()) {
+        std::coroutine_handle<> h = pending.back();
+        pending.pop_back();
+        h.resume();
+    }
+
+    std::vector<float> ref(x.size());
+    struct fir_stream* s = fir_stream_create(taps, 51);
+    fir_stream_process(s, x.data(), ref.data(), static_cast<int>(x.size()));
+    fir_stream_destroy(s);
+
+    int failures = 0;
+    if (!r.finished || r.y.size() != ref.size() ||
+        std::memcmp(r.y.data(), ref.data(), ref.size() * sizeof(float)) != 0) {
+        std::fprintf(stderr, "stream.hpp: output differs from fir_stream_process\n");
+        failures++;
+    }
+    if (!r.same_buffer || r.largest > capacity || r.blocks < 2) {
+        std::fprintf(stderr, "stream.hpp: %zu blocks of up to %zu samples, %s buffer\n", r.blocks,
+                     r.largest, r.same_buffer ? "one" : "more than one");
+        failures++;
+    }
+
+    bool thrown = false;
+    try {
+        fir::stream bad(std::span<const float>{});
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    if (!thrown) {
+        std::fprintf(stderr, "stream.hpp: invalid taps accepted\n");
+        failures++;
+    }
+
+    std::printf("# Check stream.hpp: %s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
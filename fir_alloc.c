@@ -0,0 +1,242 @@
+#define _GNU_SOURCE
+#include "fir_alloc.h"
+#include "fir_numa.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define FIR_HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+// Buffers smaller than this are not worth a huge page
+#define FIR_HUGE_PAGE_MIN ((size_t)1 << 20)
+
+// Header stored in front of every buffer; its size keeps the data 64-byte aligned
+struct alloc_header {
+    void* base;                 // Start of the malloc block or mapping
+    size_t map_size;            // Size of the mapping (0 for heap blocks)
+    struct fir_alloc_info info;
+    struct alloc_header* prev;
+    struct alloc_header* next;
+} __attribute__((aligned(64)));
+
+static enum fir_alloc_mode global_mode = FIR_ALLOC_DEFAULT;
+static __thread enum fir_alloc_mode thread_mode = FIR_ALLOC_INHERIT;
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct alloc_header* registry;
+
+void fir_alloc_set_mode(enum fir_alloc_mode mode) {
+    if (mode == FIR_ALLOC_DEFAULT || mode == FIR_ALLOC_HUGE_PAGES) {
+        __atomic_store_n(&global_mode, mode, __ATOMIC_RELAXED);
+    }
+}
+
+void fir_alloc_set_thread_mode(enum fir_alloc_mode mode) {
+    thread_mode = mode;
+}
+
+static enum fir_alloc_mode current_mode(void) {
+    if (thread_mode != FIR_ALLOC_INHERIT) {
+        return thread_mode;
+    }
+    return __atomic_load_n(&global_mode, __ATOMIC_RELAXED);
+}
+
+static size_t round_up(size_t x, size_t align) {
+    return (x + align - 1) / align * align;
+}
+
+// Whether the mapping containing p has transparent huge pages, from its
+// AnonHugePages line in /proc/self/smaps
+static int has_anon_huge_pages(const void* p) {
+    FILE* f = fopen("/proc/self/smaps", "r");
+    if (!f) {
+        return 0;
+    }
+    char line[512];
+    int inside = 0;
+    int huge = 0;
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long start, end;
+        unsigned long kb;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            inside = (uintptr_t)p >= start && (uintptr_t)p < end;
+        } else if (inside && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1) {
+            huge = kb > 0;
+            break;
+        }
+    }
+    fclose(f);
+    return huge;
+}
+
+// Map at least size bytes, trying hugetlb pages, then transparent huge pages
+// on a 2 MB aligned mapping, then regular pages
+static void* map_pages(size_t size, int huge, size_t* map_size, enum fir_alloc_backing* backing) {
+    if (huge) {
+#ifdef MAP_HUGETLB
+        void* p = mmap(NULL, round_up(size, FIR_HUGE_PAGE_SIZE), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            *map_size = round_up(size, FIR_HUGE_PAGE_SIZE);
+            *backing = FIR_BACKING_HUGETLB;
+            return p;
+        }
+#endif
+
+        // Over-allocate so the mapping can be trimmed to a 2 MB boundary
+        size_t want = round_up(size, FIR_HUGE_PAGE_SIZE);
+        size_t len = want + FIR_HUGE_PAGE_SIZE;
+        char* raw = (char*)mmap(NULL, len, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw != MAP_FAILED) {
+            char* p = (char*)round_up((uintptr_t)raw, FIR_HUGE_PAGE_SIZE);
+            if (p > raw) {
+                munmap(raw, p - raw);
+            }
+            if (raw + len > p + want) {
+                munmap(p + want, raw + len - (p + want));
+            }
+            *map_size = want;
+            *backing = FIR_BACKING_PAGES;
+#ifdef MADV_HUGEPAGE
+            if (madvise(p, want, MADV_HUGEPAGE) == 0) {
+                *backing = FIR_BACKING_THP_REQUESTED;
+            }
+#endif
+            return p;
+        }
+    }
+
+    size_t len = round_up(size, (size_t)sysconf(_SC_PAGESIZE));
+    void* p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+    *map_size = len;
+    *backing = FIR_BACKING_PAGES;
+    return p;
+}
+
+// Fault in every 2 MB page of a mapping with transparent huge pages
+// requested, so the kernel either backs it with a huge page or falls back to
+// regular pages, and find out which
+static enum fir_alloc_backing touch_huge_pages(char* p, size_t map_size) {
+    for (size_t off = 0; off < map_size; off += FIR_HUGE_PAGE_SIZE) {
+        p[off] = 0;
+    }
+    return has_anon_huge_pages(p) ? FIR_BACKING_THP : FIR_BACKING_THP_REQUESTED;
+}
+
+static void* finish(struct alloc_header* h, size_t size, const char* label) {
+    h->info.ptr = h + 1;
+    h->info.size = size;
+    h->info.label = label;
+
+    pthread_mutex_lock(&registry_lock);
+    h->prev = NULL;
+    h->next = registry;
+    if (registry) {
+        registry->prev = h;
+    }
+    registry = h;
+    pthread_mutex_unlock(&registry_lock);
+
+    return h + 1;
+}
+
+void* fir_alloc(size_t size, const char* label) {
+    size_t total = sizeof(struct alloc_header) + size;
+    struct alloc_header* h;
+
+    if (current_mode() == FIR_ALLOC_HUGE_PAGES && size >= FIR_HUGE_PAGE_MIN) {
+        size_t map_size;
+        enum fir_alloc_backing backing;
+        void* base = map_pages(total, 1, &map_size, &backing);
+        if (!base) {
+            return NULL;
+        }
+        if (backing == FIR_BACKING_THP_REQUESTED) {
+            backing = touch_huge_pages((char*)base, map_size);
+        }
+        h = (struct alloc_header*)base;
+        h->base = base;
+        h->map_size = map_size;
+        h->info.backing = backing;
+    } else {
+        void* base = NULL;
+        if (posix_memalign(&base, sizeof(struct alloc_header), total) != 0) {
+            return NULL;
+        }
+        memset(base, 0, total);
+        h = (struct alloc_header*)base;
+        h->base = base;
+        h->map_size = 0;
+        h->info.backing = FIR_BACKING_HEAP;
+    }
+    h->info.node = -1;
+    return finish(h, size, label);
+}
+
+void* fir_alloc_on_node(size_t size, const char* label, int node) {
+    size_t total = sizeof(struct alloc_header) + size;
+    size_t map_size;
+    enum fir_alloc_backing backing;
+    int huge = current_mode() == FIR_ALLOC_HUGE_PAGES && size >= FIR_HUGE_PAGE_MIN;
+    void* base = map_pages(total, huge, &map_size, &backing);
+    if (!base) {
+        return NULL;
+    }
+
+    // Bind before the header write faults in the first page
+    int bound = fir_numa_bind(base, map_size, node) == 0;
+    if (backing == FIR_BACKING_THP_REQUESTED) {
+        backing = touch_huge_pages((char*)base, map_size);
+    }
+
+    struct alloc_header* h = (struct alloc_header*)base;
+    h->base = base;
+    h->map_size = map_size;
+    h->info.backing = backing;
+    h->info.node = bound ? node : -1;
+    return finish(h, size, label);
+}
+
+void fir_free(void* ptr) {
+    if (!ptr) return;
+    struct alloc_header* h = (struct alloc_header*)ptr - 1;
+
+    pthread_mutex_lock(&registry_lock);
+    if (h->prev) {
+        h->prev->next = h->next;
+    } else {
+        registry = h->next;
+    }
+    if (h->next) {
+        h->next->prev = h->prev;
+    }
+    pthread_mutex_unlock(&registry_lock);
+
+    if (h->map_size) {
+        munmap(h->base, h->map_size);
+    } else {
+        free(h->base);
+    }
+}
+
+void fir_alloc_report(void (*fn)(const struct fir_alloc_info* info, void* user), void* user) {
+    if (!fn) return;
+    pthread_mutex_lock(&registry_lock);
+    for (struct alloc_header* h = registry; h; h = h->next) {
+        // khugepaged may have collapsed the pages since the allocation
+        if (h->info.backing == FIR_BACKING_THP || h->info.backing == FIR_BACKING_THP_REQUESTED) {
+            h->info.backing = has_anon_huge_pages(h->base) ? FIR_BACKING_THP : FIR_BACKING_THP_REQUESTED;
+        }
+        fn(&h->info, user);
+    }
+    pthread_mutex_unlock(&registry_lock);
+}
@@ -0,0 +1,77 @@
+#ifndef FIR_ALLOC_H
+#define FIR_ALLOC_H
+
+#include <stddef.h>
+
+// Buffer allocation for the filter engines.
+//
+// Large buffers (tap banks, delay lines, work buffers) are allocated through
+// fir_alloc(). In huge-page mode, buffers of at least 1 MB are backed by
+// 2 MB huge pages: explicit hugetlb pages when the system has them reserved,
+// otherwise transparent huge pages requested with madvise. Every live buffer
+// is tracked, so fir_alloc_report() shows which ones got huge pages; for
+// transparent huge pages this is checked in /proc/self/smaps on every report.
+
+enum fir_alloc_mode {
+    FIR_ALLOC_INHERIT = -1,     // Thread setting only: use the global mode
+    FIR_ALLOC_DEFAULT = 0,      // Regular heap allocation
+    FIR_ALLOC_HUGE_PAGES = 1    // Huge pages for large buffers
+};
+
+enum fir_alloc_backing {
+    FIR_BACKING_HEAP,       // malloc
+    FIR_BACKING_PAGES,      // Anonymous mapping with regular pages
+    FIR_BACKING_HUGETLB,    // Explicit 2 MB huge pages (MAP_HUGETLB)
+    FIR_BACKING_THP,        // Transparent huge pages obtained (AnonHugePages in /proc/self/smaps)
+    FIR_BACKING_THP_REQUESTED   // Transparent huge pages requested with madvise, but regular pages so far
+};
+
+struct fir_alloc_info {
+    const void* ptr;
+    size_t size;
+    const char* label;      // Which buffer this is, e.g. "fir_stream.buf"
+    enum fir_alloc_backing backing;
+    int node;               // NUMA node the buffer was bound to, or -1
+};
+
+/**
+ * @brief Set the allocation mode for buffers of objects created from now on.
+ */
+void fir_alloc_set_mode(enum fir_alloc_mode mode);
+
+/**
+ * @brief Override the allocation mode for objects created by the calling thread.
+ *
+ * This allows choosing the mode per object: set it before creating the object and reset it to FIR_ALLOC_INHERIT afterwards.
+ */
+void fir_alloc_set_thread_mode(enum fir_alloc_mode mode);
+
+/**
+ * @brief Call fn for every live buffer allocated by the library.
+ *
+ * fn must not allocate or free library buffers.
+ */
+void fir_alloc_report(void (*fn)(const struct fir_alloc_info* info, void* user), void* user);
+
+/**
+ * @brief Allocate a zeroed, 64-byte aligned buffer according to the current mode.
+ *
+ * @param size Size in bytes
+ * @param label Static string naming the buffer for fir_alloc_report()
+ * @return Buffer, or NULL on error
+ */
+void* fir_alloc(size_t size, const char* label);
+
+/**
+ * @brief Allocate a zeroed, 64-byte aligned buffer whose pages are placed on a NUMA node.
+ *
+ * The buffer is always page-backed (huge pages in huge-page mode).
+ */
+void* fir_alloc_on_node(size_t size, const char* label, int node);
+
+/**
+ * @brief Free a buffer from fir_alloc() or fir_alloc_on_node(). NULL is ignored.
+ */
+void fir_free(void* ptr);
+
+#endif
@@ -0,0 +1,275 @@
+#include "fir_batch.h"
+#include "fir_alloc.h"
+#include "fir_cpu.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Streams per group: one AVX-512 vector, two AVX2 vectors
+#define FIR_BATCH_LANES 16
+
+// Samples per stream handled per pass over a group's work buffer
+#define FIR_BATCH_CHUNK 64
+
+// Rows hold one value per lane. Each group keeps its reversed taps (shorter
+// filters padded with leading zeros) and the last max_taps - 1 inputs.
+struct fir_batch {
+    int count;
+    int groups;
+    int max_taps;
+    int* numtaps;       // Per stream
+    int* group_taps;    // Per group: the longest filter in it
+    float* rtaps;   // groups * max_taps rows
+    float* hist;    // groups * (max_taps - 1) rows
+    float* work;    // max_taps - 1 + FIR_BATCH_CHUNK rows: history, then the chunk
+    float* y;       // FIR_BATCH_CHUNK rows of output
+};
+
+// Computes row t of y from rows t..t+numtaps-1 of x, for every lane
+typedef void (*batch_kernel)(const float* rtaps, int numtaps, const float* x, float* y, int n);
+
+static void batch_scalar(const float* rtaps, int numtaps, const float* x, float* y, int n) {
+    for (int t = 0; t < n; t++) {
+        float acc[FIR_BATCH_LANES] = {0.0f};
+        for (int k = 0; k < numtaps; k++) {
+            const float* r = rtaps + k * FIR_BATCH_LANES;
+            const float* xr = x + (t + k) * FIR_BATCH_LANES;
+            for (int l = 0; l < FIR_BATCH_LANES; l++) {
+                acc[l] += r[l] * xr[l];
+            }
+        }
+        memcpy(y + t * FIR_BATCH_LANES, acc, sizeof(acc));
+    }
+}
+
+#if FIR_X86
+// Four output rows per pass, so each row of taps is loaded once for all of
+// them and the multiply-adds are independent
+__attribute__((target("avx2,fma")))
+static void batch_avx2(const float* rtaps, int numtaps, const float* x, float* y, int n) {
+    int t = 0;
+    for (; t + 4 <= n; t += 4) {
+        __m256 acc[4][2];
+        for (int u = 0; u < 4; u++) {
+            acc[u][0] = _mm256_setzero_ps();
+            acc[u][1] = _mm256_setzero_ps();
+        }
+        for (int k = 0; k < numtaps; k++) {
+            __m256 r0 = _mm256_loadu_ps(rtaps + k * 16);
+            __m256 r1 = _mm256_loadu_ps(rtaps + k * 16 + 8);
+            for (int u = 0; u < 4; u++) {
+                const float* xr = x + (t + u + k) * 16;
+                acc[u][0] = _mm256_fmadd_ps(r0, _mm256_loadu_ps(xr), acc[u][0]);
+                acc[u][1] = _mm256_fmadd_ps(r1, _mm256_loadu_ps(xr + 8), acc[u][1]);
+            }
+        }
+        for (int u = 0; u < 4; u++) {
+            _mm256_storeu_ps(y + (t + u) * 16, acc[u][0]);
+            _mm256_storeu_ps(y + (t + u) * 16 + 8, acc[u][1]);
+        }
+    }
+    for (; t < n; t++) {
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        for (int k = 0; k < numtaps; k++) {
+            const float* xr = x + (t + k) * 16;
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(rtaps + k * 16), _mm256_loadu_ps(xr), acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(rtaps + k * 16 + 8), _mm256_loadu_ps(xr + 8), acc1);
+        }
+        _mm256_storeu_ps(y + t * 16, acc0);
+        _mm256_storeu_ps(y + t * 16 + 8, acc1);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void batch_avx512(const float* rtaps, int numtaps, const float* x, float* y, int n) {
+    int t = 0;
+    for (; t + 4 <= n; t += 4) {
+        __m512 acc0 = _mm512_setzero_ps();
+        __m512 acc1 = _mm512_setzero_ps();
+        __m512 acc2 = _mm512_setzero_ps();
+        __m512 acc3 = _mm512_setzero_ps();
+        for (int k = 0; k < numtaps; k++) {
+            __m512 r = _mm512_loadu_ps(rtaps + k * 16);
+            const float* xr = x + (t + k) * 16;
+            acc0 = _mm512_fmadd_ps(r, _mm512_loadu_ps(xr), acc0);
+            acc1 = _mm512_fmadd_ps(r, _mm512_loadu_ps(xr + 16), acc1);
+            acc2 = _mm512_fmadd_ps(r, _mm512_loadu_ps(xr + 32), acc2);
+            acc3 = _mm512_fmadd_ps(r, _mm512_loadu_ps(xr + 48), acc3);
+        }
+        _mm512_storeu_ps(y + t * 16, acc0);
+        _mm512_storeu_ps(y + t * 16 + 16, acc1);
+        _mm512_storeu_ps(y + t * 16 + 32, acc2);
+        _mm512_storeu_ps(y + t * 16 + 48, acc3);
+    }
+    for (; t < n; t++) {
+        __m512 acc = _mm512_setzero_ps();
+        for (int k = 0; k < numtaps; k++) {
+            acc = _mm512_fmadd_ps(_mm512_loadu_ps(rtaps + k * 16),
+                                  _mm512_loadu_ps(x + (t + k) * 16), acc);
+        }
+        _mm512_storeu_ps(y + t * 16, acc);
+    }
+}
+#endif
+
+static batch_kernel select_kernel(void) {
+#if FIR_X86
+    if (fir_cpu_has_avx512()) return batch_avx512;
+    if (fir_cpu_has_avx2()) return batch_avx2;
+#endif
+    return batch_scalar;
+}
+
+static batch_kernel get_kernel(void) {
+    // Selected on first use; concurrent first calls store the same value
+    static batch_kernel kernel;
+    batch_kernel k = __atomic_load_n(&kernel, __ATOMIC_RELAXED);
+    if (!k) {
+        k = select_kernel();
+        __atomic_store_n(&kernel, k, __ATOMIC_RELAXED);
+    }
+    return k;
+}
+
+struct fir_batch* fir_batch_create(int count, int max_taps) {
+    if (count <= 0 || max_taps <= 0) {
+        return NULL;
+    }
+
+    struct fir_batch* batch = (struct fir_batch*)calloc(1, sizeof(struct fir_batch));
+    if (!batch) {
+        return NULL;
+    }
+    batch->count = count;
+    batch->groups = (count + FIR_BATCH_LANES - 1) / FIR_BATCH_LANES;
+    batch->max_taps = max_taps;
+    batch->numtaps = (int*)calloc(count, sizeof(int));
+    batch->group_taps = (int*)calloc(batch->groups, sizeof(int));
+
+    const size_t row = FIR_BATCH_LANES * sizeof(float);
+    const size_t taps_size = (size_t)batch->groups * max_taps * row;
+    const size_t hist_size = (size_t)batch->groups * (max_taps - 1) * row;
+    batch->rtaps = (float*)fir_alloc(taps_size, "fir_batch.taps");
+    batch->hist = (float*)fir_alloc(hist_size > 0 ? hist_size : row, "fir_batch.hist");
+    batch->work = (float*)fir_alloc((max_taps - 1 + FIR_BATCH_CHUNK) * row, "fir_batch.work");
+    batch->y = (float*)fir_alloc(FIR_BATCH_CHUNK * row, "fir_batch.out");
+    if (!batch->numtaps || !batch->group_taps || !batch->rtaps || !batch->hist || !batch->work ||
+        !batch->y) {
+        fir_batch_destroy(batch);
+        return NULL;
+    }
+    memset(batch->rtaps, 0, taps_size);
+    memset(batch->hist, 0, hist_size);
+    return batch;
+}
+
+void fir_batch_destroy(struct fir_batch* batch) {
+    if (!batch) return;
+    free(batch->numtaps);
+    free(batch->group_taps);
+    fir_free(batch->rtaps);
+    fir_free(batch->hist);
+    fir_free(batch->work);
+    fir_free(batch->y);
+    free(batch);
+}
+
+int fir_batch_set_taps(struct fir_batch* batch, int index, const float* taps, int numtaps) {
+    if (!batch || !taps || index < 0 || index >= batch->count || numtaps <= 0 ||
+        numtaps > batch->max_taps) {
+        return -1;
+    }
+
+    const int group = index / FIR_BATCH_LANES;
+    const int lane = index % FIR_BATCH_LANES;
+    const int max_taps = batch->max_taps;
+    float* rtaps = batch->rtaps + (size_t)group * max_taps * FIR_BATCH_LANES + lane;
+    float* hist = batch->hist + (size_t)group * (max_taps - 1) * FIR_BATCH_LANES + lane;
+
+    // Padding in front lines the newest input up with the last tap of every
+    // filter
+    const int pad = max_taps - numtaps;
+    for (int k = 0; k < max_taps; k++) {
+        rtaps[k * FIR_BATCH_LANES] = k < pad ? 0.0f : taps[max_taps - 1 - k];
+    }
+    for (int k = 0; k < max_taps - 1; k++) {
+        hist[k * FIR_BATCH_LANES] = 0.0f;
+    }
+
+    batch->numtaps[index] = numtaps;
+    int longest = 0;
+    for (int i = group * FIR_BATCH_LANES; i < batch->count && i < (group + 1) * FIR_BATCH_LANES; i++) {
+        if (batch->numtaps[i] > longest) longest = batch->numtaps[i];
+    }
+    batch->group_taps[group] = longest;
+    return 0;
+}
+
+void fir_batch_reset(struct fir_batch* batch) {
+    if (!batch) return;
+    memset(batch->hist, 0,
+           (size_t)batch->groups * (batch->max_taps - 1) * FIR_BATCH_LANES * sizeof(float));
+}
+
+int fir_batch_process(struct fir_batch* batch, const float* const* in, float* const* out, int n) {
+    if (!batch || n < 0 || (n > 0 && (!in || !out))) {
+        return -1;
+    }
+    for (int i = 0; i < batch->count && n > 0; i++) {
+        if (!in[i] || !out[i]) {
+            return -1;
+        }
+    }
+
+    const batch_kernel kernel = get_kernel();
+    const int max_taps = batch->max_taps;
+    const int hist_len = max_taps - 1;
+    const size_t row = FIR_BATCH_LANES * sizeof(float);
+    float* work = batch->work;
+    float* y = batch->y;
+
+    for (int g = 0; g < batch->groups && n > 0; g++) {
+        const int first = g * FIR_BATCH_LANES;
+        const int lanes = batch->count - first < FIR_BATCH_LANES ? batch->count - first
+                                                                 : FIR_BATCH_LANES;
+        const float* rtaps = batch->rtaps + (size_t)g * max_taps * FIR_BATCH_LANES;
+        float* hist = batch->hist + (size_t)g * hist_len * FIR_BATCH_LANES;
+
+        // History rows before the longest filter of the group only meet zero
+        // taps, so they are neither computed nor kept up to date
+        const int numtaps = batch->group_taps[g];
+        const int skip = numtaps > 0 ? max_taps - numtaps : hist_len;
+        float* live = work + (size_t)skip * FIR_BATCH_LANES;
+        const size_t live_size = (size_t)(hist_len - skip) * row;
+
+        memcpy(live, hist + (size_t)skip * FIR_BATCH_LANES, live_size);
+        for (int pos = 0; pos < n; pos += FIR_BATCH_CHUNK) {
+            const int len = n - pos < FIR_BATCH_CHUNK ? n - pos : FIR_BATCH_CHUNK;
+
+            // Transpose the chunk into rows after the history; unused lanes
+            // of the last group stay zero
+            float* rows = work + (size_t)hist_len * FIR_BATCH_LANES;
+            if (lanes < FIR_BATCH_LANES) {
+                memset(rows, 0, len * row);
+            }
+            for (int l = 0; l < lanes; l++) {
+                const float* src = in[first + l] + pos;
+                for (int t = 0; t < len; t++) {
+                    rows[t * FIR_BATCH_LANES + l] = src[t];
+                }
+            }
+
+            kernel(rtaps + (size_t)skip * FIR_BATCH_LANES, numtaps, live, y, len);
+
+            for (int l = 0; l < lanes; l++) {
+                float* dst = out[first + l] + pos;
+                for (int t = 0; t < len; t++) {
+                    dst[t] = y[t * FIR_BATCH_LANES + l];
+                }
+            }
+            memmove(live, live + (size_t)len * FIR_BATCH_LANES, live_size);
+        }
+        memcpy(hist + (size_t)skip * FIR_BATCH_LANES, live, live_size);
+    }
+    return 0;
+}
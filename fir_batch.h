@@ -0,0 +1,63 @@
+#ifndef FIR_BATCH_H
+#define FIR_BATCH_H
+
+// Batched filtering of many independent short filters.
+//
+// A batch holds count streams, each with its own taps and delay line, that
+// are filtered together in one call. State is stored structure-of-arrays:
+// 16 streams share each row of taps and history, so one SIMD lane serves
+// one stream and a short filter costs as many vector multiply-adds as it
+// has taps, for 16 streams at once. This suits thousands of small filters
+// (e.g. 15 to 63 taps from firwin()) fed with small blocks, where calling
+// fir_stream_process() per stream would be dominated by call overhead.
+//
+// Every stream is filtered exactly as by its own fir_stream, up to float
+// rounding, and the output does not depend on how the signal is split into
+// calls. All buffers are allocated on creation; processing never allocates.
+
+struct fir_batch;
+
+/**
+ * @brief Create a batch of streams.
+ *
+ * All taps start at zero; set them with fir_batch_set_taps().
+ *
+ * @param count Number of streams
+ * @param max_taps Largest number of taps of any stream
+ * @return New batch, or NULL on error
+ */
+struct fir_batch* fir_batch_create(int count, int max_taps);
+
+/**
+ * @brief Destroy a batch created with fir_batch_create().
+ */
+void fir_batch_destroy(struct fir_batch* batch);
+
+/**
+ * @brief Set the taps of one stream and clear its delay line.
+ *
+ * @param batch Batch
+ * @param index Stream index (0 to count - 1)
+ * @param taps Filter coefficients, e.g. designed with firwin() (copied)
+ * @param numtaps Number of taps (1 to max_taps)
+ * @return 0 on success, -1 on error
+ */
+int fir_batch_set_taps(struct fir_batch* batch, int index, const float* taps, int numtaps);
+
+/**
+ * @brief Clear the delay lines of all streams.
+ */
+void fir_batch_reset(struct fir_batch* batch);
+
+/**
+ * @brief Filter a block of n samples for every stream.
+ *
+ * @param batch Batch
+ * @param in Input buffers, one per stream
+ * @param out Output buffers, one per stream (out[i] may be the same buffer as in[i])
+ * @param n Number of samples per stream
+ * @return 0 on success, -1 on error
+ */
+int fir_batch_process(struct fir_batch* batch, const float* const* in, float* const* out, int n);
+
+#endif
@@ -0,0 +1,196 @@
+#include "fir_cic.h"
+#include "fir_stream.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FIR_CIC_MAX_STAGES 8
+
+// Number of CIC output samples buffered before running the compensation filter
+#define FIR_CIC_CHUNK 1024
+
+// Number of points used to describe the compensation passband to firwin2()
+#define FIR_CIC_PASSBAND_POINTS 32
+
+struct fir_cic_decimator {
+    int ratio;
+    int stages;
+    int comp_ratio;
+    int phase;                              // Input samples since the last CIC output
+    uint64_t integ[FIR_CIC_MAX_STAGES];     // Integrator states (wrap-around arithmetic)
+    uint64_t comb[FIR_CIC_MAX_STAGES];      // Previous input of each comb
+    float scale;                            // Inverse of the CIC DC gain
+    struct fir_stream* comp;
+    float* mid;                             // CIC output waiting for the compensation filter
+};
+
+// Magnitude response of the CIC at frequency f (relative to its output rate)
+static double cic_response(int ratio, int stages, double f) {
+    if (f == 0.0) {
+        return 1.0;
+    }
+    double h = sin(M_PI * f) / (ratio * sin(M_PI * f / ratio));
+    return pow(fabs(h), stages);
+}
+
+int fir_cic_compensator(int ratio, int stages, int comp_ratio, float passband, int numtaps,
+                        enum fir_filter_window_type window, float* out) {
+    if (ratio < 1 || stages < 1 || comp_ratio < 1 || numtaps <= 0 || !out) {
+        return -1;
+    }
+    if (!(passband > 0.0f && passband < 0.5f / comp_ratio)) {
+        return -1;
+    }
+
+    // Aliases of the stopband must not fold into the passband
+    float stop = 1.0f / comp_ratio - passband;
+    if (stop > 0.5f) {
+        stop = 0.5f;
+    }
+
+    float freq[FIR_CIC_PASSBAND_POINTS + 2];
+    float gain[FIR_CIC_PASSBAND_POINTS + 2];
+    int count = 0;
+    for (int i = 0; i < FIR_CIC_PASSBAND_POINTS; i++) {
+        float f = passband * i / (FIR_CIC_PASSBAND_POINTS - 1);
+        freq[count] = f;
+        gain[count] = (float)(1.0 / cic_response(ratio, stages, f));
+        count++;
+    }
+    if (stop < 0.5f) {
+        freq[count] = stop;
+        gain[count] = 0.0f;
+        count++;
+    }
+    freq[count] = 0.5f;
+    gain[count] = 0.0f;
+    count++;
+
+    if (firwin2(numtaps, count, freq, gain, 1.0f, window, out) != 0) {
+        return -1;
+    }
+
+    float sum = 0.0f;
+    for (int n = 0; n < numtaps; n++) {
+        sum += out[n];
+    }
+    if (fabsf(sum) < 1e-10f) {
+        return -1;
+    }
+    for (int n = 0; n < numtaps; n++) {
+        out[n] /= sum;
+    }
+    return 0;
+}
+
+struct fir_cic_decimator* fir_cic_decimator_create(int ratio, int stages, int input_bits,
+                                                   int comp_ratio, float passband, int numtaps,
+                                                   enum fir_filter_window_type window) {
+    if (ratio < 2 || stages < 1 || stages > FIR_CIC_MAX_STAGES || comp_ratio < 1) {
+        return NULL;
+    }
+    if (input_bits < 1 || input_bits > 32) {
+        return NULL;
+    }
+
+    // The register width must hold the full bit growth of the CIC
+    int growth = 0;
+    while ((1LL << growth) < ratio) {
+        growth++;
+    }
+    if (input_bits + stages * growth > 64) {
+        return NULL;
+    }
+
+    float* taps = (float*)malloc(numtaps > 0 ? numtaps * sizeof(float) : 1);
+    if (!taps) {
+        return NULL;
+    }
+    if (fir_cic_compensator(ratio, stages, comp_ratio, passband, numtaps, window, taps) != 0) {
+        free(taps);
+        return NULL;
+    }
+
+    struct fir_cic_decimator* dec =
+        (struct fir_cic_decimator*)calloc(1, sizeof(struct fir_cic_decimator));
+    if (!dec) {
+        free(taps);
+        return NULL;
+    }
+
+    dec->ratio = ratio;
+    dec->stages = stages;
+    dec->comp_ratio = comp_ratio;
+    dec->scale = (float)(1.0 / pow((double)ratio, stages));
+    dec->comp = fir_stream_create(taps, numtaps);
+    dec->mid = (float*)malloc(FIR_CIC_CHUNK * sizeof(float));
+    free(taps);
+
+    if (!dec->comp || !dec->mid) {
+        fir_cic_decimator_destroy(dec);
+        return NULL;
+    }
+    return dec;
+}
+
+void fir_cic_decimator_destroy(struct fir_cic_decimator* dec) {
+    if (!dec) return;
+    fir_stream_destroy(dec->comp);
+    free(dec->mid);
+    free(dec);
+}
+
+void fir_cic_decimator_reset(struct fir_cic_decimator* dec) {
+    if (!dec) return;
+    dec->phase = 0;
+    memset(dec->integ, 0, sizeof(dec->integ));
+    memset(dec->comb, 0, sizeof(dec->comb));
+    fir_stream_reset(dec->comp);
+}
+
+int fir_cic_decimator_process(struct fir_cic_decimator* dec, const int32_t* in, int n,
+                              float* out) {
+    if (!dec || n < 0 || (n > 0 && (!in || !out))) {
+        return -1;
+    }
+
+    const int stages = dec->stages;
+    uint64_t* integ = dec->integ;
+    uint64_t* comb = dec->comb;
+    int mid_count = 0;
+    int written = 0;
+
+    for (int i = 0; i < n; i++) {
+        // Integrators run at the input rate
+        integ[0] += (uint64_t)(int64_t)in[i];
+        for (int s = 1; s < stages; s++) {
+            integ[s] += integ[s-1];
+        }
+
+        if (++dec->phase < dec->ratio) {
+            continue;
+        }
+        dec->phase = 0;
+
+        // Combs run at the output rate
+        uint64_t v = integ[stages-1];
+        for (int s = 0; s < stages; s++) {
+            uint64_t prev = comb[s];
+            comb[s] = v;
+            v -= prev;
+        }
+        dec->mid[mid_count++] = (float)(int64_t)v * dec->scale;
+
+        if (mid_count == FIR_CIC_CHUNK) {
+            written += fir_stream_decimate(dec->comp, dec->mid, out + written,
+                                           mid_count, dec->comp_ratio);
+            mid_count = 0;
+        }
+    }
+
+    if (mid_count > 0) {
+        written += fir_stream_decimate(dec->comp, dec->mid, out + written,
+                                       mid_count, dec->comp_ratio);
+    }
+    return written;
+}
@@ -0,0 +1,78 @@
+#ifndef FIR_CIC_H
+#define FIR_CIC_H
+
+#include "fir_filter.h"
+#include <stdint.h>
+
+// High-ratio decimator: a multiplier-free CIC (cascaded integrator-comb)
+// front end followed by a FIR that compensates the CIC passband droop and
+// decimates further at the low rate.
+
+struct fir_cic_decimator;
+
+/**
+ * @brief Design a CIC compensation filter.
+ *
+ * The passband gain is the inverse of the CIC response, so that the cascade
+ * is flat; the stopband starts where aliases of the following decimation
+ * would fall into the passband. Frequencies are relative to the CIC output
+ * rate. The filter is normalized to unity gain at DC.
+ *
+ * @param ratio CIC decimation ratio
+ * @param stages Number of CIC stages
+ * @param comp_ratio Decimation ratio of the compensation filter
+ * @param passband Passband edge as a fraction of the CIC output rate (0 < passband < 0.5 / comp_ratio)
+ * @param numtaps Number of taps
+ * @param window Window type
+ * @param out Output array (must be pre-allocated with size numtaps)
+ * @return 0 on success, -1 on error
+ */
+int fir_cic_compensator(int ratio, int stages, int comp_ratio, float passband, int numtaps,
+                        enum fir_filter_window_type window, float* out);
+
+/**
+ * @brief Create a CIC decimator with compensation filter.
+ *
+ * The total decimation ratio is ratio * comp_ratio. The CIC runs in 64-bit
+ * integer arithmetic, so input_bits + stages * ceil(log2(ratio)) must not
+ * exceed 64.
+ *
+ * @param ratio CIC decimation ratio (at least 2)
+ * @param stages Number of CIC stages (1 to 8)
+ * @param input_bits Number of significant bits in the input samples (1 to 32)
+ * @param comp_ratio Decimation ratio of the compensation filter (1 or more)
+ * @param passband Passband edge as a fraction of the CIC output rate
+ * @param numtaps Number of taps of the compensation filter
+ * @param window Window type of the compensation filter
+ * @return New decimator, or NULL on error
+ */
+struct fir_cic_decimator* fir_cic_decimator_create(int ratio, int stages, int input_bits,
+                                                   int comp_ratio, float passband, int numtaps,
+                                                   enum fir_filter_window_type window);
+
+/**
+ * @brief Destroy a decimator created with fir_cic_decimator_create().
+ */
+void fir_cic_decimator_destroy(struct fir_cic_decimator* dec);
+
+/**
+ * @brief Clear all filter state.
+ */
+void fir_cic_decimator_reset(struct fir_cic_decimator* dec);
+
+/**
+ * @brief Decimate a block of samples.
+ *
+ * Output is scaled so that a constant input gives the same constant output.
+ * Blocks can have any size; the decimation phase carries over between calls.
+ *
+ * @param dec Decimator
+ * @param in Input samples
+ * @param n Number of input samples
+ * @param out Output samples (room for n / (ratio * comp_ratio) + 1 samples)
+ * @return Number of output samples written, or -1 on error
+ */
+int fir_cic_decimator_process(struct fir_cic_decimator* dec, const int32_t* in, int n,
+                              float* out);
+
+#endif
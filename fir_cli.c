@@ -0,0 +1,37 @@
+#include "fir_cli.h"
+#include <string.h>
+#include <strings.h>
+
+int parse_window_type(const char* str) {
+    if (strcmp(str, "0") == 0 || strcasecmp(str, "rectangular") == 0 || strcasecmp(str, "boxcar") == 0) return RECTANGULAR;
+    if (strcmp(str, "1") == 0 || strcasecmp(str, "hamming") == 0) return HAMMING;
+    if (strcmp(str, "2") == 0 || strcasecmp(str, "blackman") == 0) return BLACKMAN;
+    if (strcmp(str, "3") == 0 || strcasecmp(str, "triangular") == 0) return TRIANGULAR;
+    if (strcmp(str, "4") == 0 || strcasecmp(str, "parzen") == 0) return PARZEN;
+    if (strcmp(str, "5") == 0 || strcasecmp(str, "bohman") == 0) return BOHMAN;
+    if (strcmp(str, "6") == 0 || strcasecmp(str, "nuttall") == 0) return NUTTALL;
+    if (strcmp(str, "7") == 0 || strcasecmp(str, "blackmanharris") == 0 || strcasecmp(str, "blackman-harris") == 0) return BLACKMANHARRIS;
+    if (strcmp(str, "8") == 0 || strcasecmp(str, "flattop") == 0) return FLATTOP;
+    if (strcmp(str, "9") == 0 || strcasecmp(str, "bartlett") == 0) return BARTLETT;
+    if (strcasecmp(str, "10") == 0 || strcasecmp(str, "hann") == 0) return HANN;
+    if (strcasecmp(str, "11") == 0 || strcasecmp(str, "cosine") == 0) return COSINE;
+    return -1;
+}
+
+const char* get_window_name(enum fir_filter_window_type window) {
+    switch (window) {
+        case RECTANGULAR:   return "Rectangular (boxcar)";
+        case HAMMING:       return "Hamming";
+        case BLACKMAN:      return "Blackman";
+        case TRIANGULAR:    return "Triangular";
+        case PARZEN:        return "Parzen";
+        case BOHMAN:        return "Bohman";
+        case NUTTALL:       return "Nuttall";
+        case BLACKMANHARRIS:return "Blackman-Harris";
+        case FLATTOP:       return "Flat-top";
+        case BARTLETT:      return "Bartlett";
+        case HANN:          return "Hann";
+        case COSINE:        return "Cosine (sine)";
+        default:            return "Unknown";
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef FIR_CLI_H
+#define FIR_CLI_H
+
+#include "fir_filter.h"
+
+// Argument helpers shared by the command line programs.
+
+/**
+ * @brief Parse a window type given by number or name.
+ *
+ * @param str Window number (0-11) or name, e.g. "hann"
+ * @return Window type, or -1 if str is not a window
+ */
+int parse_window_type(const char* str);
+
+/**
+ * @brief Get the display name of a window type.
+ */
+const char* get_window_name(enum fir_filter_window_type window);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef FIR_CPU_H
+#define FIR_CPU_H
+
+// CPU feature detection for kernels with per-ISA variants (internal header).
+//
+// Kernels are compiled for each instruction set with target attributes and
+// selected at run time, so the library itself is built for the baseline ISA.
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define FIR_X86 1
+#include <immintrin.h>
+
+static inline int fir_cpu_has_avx2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+static inline int fir_cpu_has_avx512(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f");
+}
+#else
+#define FIR_X86 0
+
+static inline int fir_cpu_has_avx2(void) { return 0; }
+static inline int fir_cpu_has_avx512(void) { return 0; }
+#endif
+
+#endif
@@ -0,0 +1,241 @@
+#include "fir_ddc.h"
+#include "fir_alloc.h"
+#include "fir_kernel.h"
+#include "fir_math.h"
+#include "fir_pool.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Number of input samples shared by all channels of a worker per pass
+#define FIR_DDC_CHUNK 1024
+
+struct ddc_channel {
+    double nco;         // NCO phase in half-turns, in [0, 2)
+    double step;        // NCO phase increment per sample in half-turns
+    int factor;
+    int phase;          // Input samples to skip before the next output
+    float* re;          // numtaps-1 samples of mixed history followed by one chunk
+    float* im;
+};
+
+struct fir_ddc {
+    int numtaps;
+    float fs;
+    int channels;
+    struct ddc_channel* chan;
+    float* rtaps;           // Taps in reverse order
+    int worker_count;
+    int* worker_first;      // First channel of each worker, plus the end
+    float* scratch;         // Per worker: NCO arguments, cosines, sines and outputs
+    struct fir_pool* pool;
+
+    // Current job
+    const float* in;
+    int n;
+    float* const* out;
+    int* counts;
+};
+
+static void ddc_worker(void* arg, int worker) {
+    struct fir_ddc* ddc = (struct fir_ddc*)arg;
+    const int numtaps = ddc->numtaps;
+    const int hist = numtaps - 1;
+    float* ph = ddc->scratch + (size_t)worker * 5 * FIR_DDC_CHUNK;
+    float* c = ph + FIR_DDC_CHUNK;
+    float* s = c + FIR_DDC_CHUNK;
+    float* yre = s + FIR_DDC_CHUNK;
+    float* yim = yre + FIR_DDC_CHUNK;
+    int first = ddc->worker_first[worker];
+    int last = ddc->worker_first[worker + 1];
+
+    for (int ch = first; ch < last; ch++) {
+        ddc->counts[ch] = 0;
+    }
+
+    for (int base = 0; base < ddc->n; base += FIR_DDC_CHUNK) {
+        int len = ddc->n - base < FIR_DDC_CHUNK ? ddc->n - base : FIR_DDC_CHUNK;
+        const float* x = ddc->in + base;
+
+        for (int ch = first; ch < last; ch++) {
+            struct ddc_channel* chan = &ddc->chan[ch];
+
+            // Mix to baseband with exp(-i pi phase); the phase is accumulated
+            // in double precision and reduced before the float conversion
+            for (int j = 0; j < len; j++) {
+                double p = chan->nco + chan->step * j;
+                ph[j] = (float)(p - 2.0 * floor(0.5 * p));
+            }
+            fir_cospi(ph, c, len);
+            fir_sinpi(ph, s, len);
+            for (int j = 0; j < len; j++) {
+                chan->re[hist + j] = x[j] * c[j];
+                chan->im[hist + j] = -x[j] * s[j];
+            }
+            double p = chan->nco + chan->step * len;
+            chan->nco = p - 2.0 * floor(0.5 * p);
+
+            if (chan->phase < len) {
+                int count = (len - chan->phase + chan->factor - 1) / chan->factor;
+                fir_kernel_decimate(ddc->rtaps, numtaps, chan->re + chan->phase, chan->factor,
+                                    yre, count);
+                fir_kernel_decimate(ddc->rtaps, numtaps, chan->im + chan->phase, chan->factor,
+                                    yim, count);
+                float* out = ddc->out[ch] + 2 * (size_t)ddc->counts[ch];
+                for (int k = 0; k < count; k++) {
+                    out[2 * k] = yre[k];
+                    out[2 * k + 1] = yim[k];
+                }
+                ddc->counts[ch] += count;
+                chan->phase += count * chan->factor;
+            }
+            chan->phase -= len;
+
+            memmove(chan->re, chan->re + len, hist * sizeof(float));
+            memmove(chan->im, chan->im + len, hist * sizeof(float));
+        }
+    }
+}
+
+struct fir_ddc* fir_ddc_create(const float* taps, int numtaps, float fs, int channels,
+                               const float* freqs, const int* factors, int threads) {
+    if (!taps || numtaps <= 0 || !(fs > 0.0f) || channels <= 0 || !freqs || !factors ||
+        threads < 0) {
+        return NULL;
+    }
+    for (int ch = 0; ch < channels; ch++) {
+        if (factors[ch] < 1) {
+            return NULL;
+        }
+    }
+
+    struct fir_ddc* ddc = (struct fir_ddc*)calloc(1, sizeof(struct fir_ddc));
+    if (!ddc) {
+        return NULL;
+    }
+    ddc->numtaps = numtaps;
+    ddc->fs = fs;
+    ddc->channels = channels;
+
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > channels) {
+        threads = channels;
+    }
+    ddc->worker_count = threads;
+
+    ddc->chan = (struct ddc_channel*)calloc(channels, sizeof(struct ddc_channel));
+    ddc->worker_first = (int*)malloc((threads + 1) * sizeof(int));
+    ddc->rtaps = (float*)fir_alloc(numtaps * sizeof(float), "fir_ddc.taps");
+    ddc->scratch = (float*)fir_alloc((size_t)threads * 5 * FIR_DDC_CHUNK * sizeof(float),
+                                     "fir_ddc.scratch");
+    if (!ddc->chan || !ddc->worker_first || !ddc->rtaps || !ddc->scratch) {
+        fir_ddc_destroy(ddc);
+        return NULL;
+    }
+
+    for (int k = 0; k < numtaps; k++) {
+        ddc->rtaps[k] = taps[numtaps - 1 - k];
+    }
+
+    const size_t buf_size = (numtaps - 1 + FIR_DDC_CHUNK) * sizeof(float);
+    double total = 0.0;
+    for (int ch = 0; ch < channels; ch++) {
+        struct ddc_channel* chan = &ddc->chan[ch];
+        chan->factor = factors[ch];
+        chan->step = 2.0 * freqs[ch] / fs;
+        chan->re = (float*)fir_alloc(buf_size, "fir_ddc.re");
+        chan->im = (float*)fir_alloc(buf_size, "fir_ddc.im");
+        if (!chan->re || !chan->im) {
+            fir_ddc_destroy(ddc);
+            return NULL;
+        }
+
+        // Mixing costs a few operations per input sample, filtering two
+        // dot products per output
+        total += 8.0 + 2.0 * numtaps / chan->factor;
+    }
+
+    // Give each worker a contiguous range of channels with an equal share of
+    // the cost
+    int ch = 0;
+    double done = 0.0;
+    for (int w = 0; w < threads; w++) {
+        ddc->worker_first[w] = ch;
+        double target = total * (w + 1) / threads;
+        int min_end = ch + 1;
+        int max_end = channels - (threads - 1 - w);
+        while (ch < max_end && (ch < min_end || done < target)) {
+            done += 8.0 + 2.0 * numtaps / ddc->chan[ch].factor;
+            ch++;
+        }
+    }
+    ddc->worker_first[threads] = channels;
+
+    ddc->pool = fir_pool_create(threads, NULL);
+    if (!ddc->pool) {
+        fir_ddc_destroy(ddc);
+        return NULL;
+    }
+    return ddc;
+}
+
+void fir_ddc_destroy(struct fir_ddc* ddc) {
+    if (!ddc) return;
+    fir_pool_destroy(ddc->pool);
+    if (ddc->chan) {
+        for (int ch = 0; ch < ddc->channels; ch++) {
+            fir_free(ddc->chan[ch].re);
+            fir_free(ddc->chan[ch].im);
+        }
+    }
+    free(ddc->chan);
+    free(ddc->worker_first);
+    fir_free(ddc->rtaps);
+    fir_free(ddc->scratch);
+    free(ddc);
+}
+
+void fir_ddc_reset(struct fir_ddc* ddc) {
+    if (!ddc) return;
+    for (int ch = 0; ch < ddc->channels; ch++) {
+        struct ddc_channel* chan = &ddc->chan[ch];
+        memset(chan->re, 0, (ddc->numtaps - 1) * sizeof(float));
+        memset(chan->im, 0, (ddc->numtaps - 1) * sizeof(float));
+        chan->nco = 0.0;
+        chan->phase = 0;
+    }
+}
+
+int fir_ddc_set_freq(struct fir_ddc* ddc, int channel, float freq) {
+    if (!ddc || channel < 0 || channel >= ddc->channels) {
+        return -1;
+    }
+    ddc->chan[channel].step = 2.0 * freq / ddc->fs;
+    return 0;
+}
+
+int fir_ddc_process(struct fir_ddc* ddc, const float* in, int n, float* const* out, int* counts) {
+    if (!ddc || n < 0 || !counts || (n > 0 && (!in || !out))) {
+        return -1;
+    }
+    for (int ch = 0; ch < ddc->channels; ch++) {
+        counts[ch] = 0;
+        if (n > 0 && !out[ch]) {
+            return -1;
+        }
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    ddc->in = in;
+    ddc->n = n;
+    ddc->out = out;
+    ddc->counts = counts;
+    fir_pool_run(ddc->pool, ddc_worker, ddc);
+    return 0;
+}
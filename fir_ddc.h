@@ -0,0 +1,66 @@
+#ifndef FIR_DDC_H
+#define FIR_DDC_H
+
+// Digital down-converter bank.
+//
+// Extracts narrowband channels at arbitrary center frequencies from one real
+// wideband stream. Every channel mixes the input to baseband with its own
+// NCO, then lowpass filters and decimates it with a shared prototype (e.g.
+// designed with firwin()) and its own decimation factor. The input is
+// processed in cache-sized chunks; each worker thread runs all of its
+// channels over a chunk before moving to the next, so the input is read from
+// memory once. Channels are split between the workers by their cost.
+
+struct fir_ddc;
+
+/**
+ * @brief Create a down-converter bank.
+ *
+ * @param taps Lowpass prototype shared by all channels (copied)
+ * @param numtaps Number of taps
+ * @param fs Input sampling frequency in Hz
+ * @param channels Number of channels
+ * @param freqs Center frequency of each channel in Hz
+ * @param factors Decimation factor of each channel (at least 1)
+ * @param threads Number of worker threads, or 0 for one per CPU (at most one per channel)
+ * @return New bank, or NULL on error
+ */
+struct fir_ddc* fir_ddc_create(const float* taps, int numtaps, float fs, int channels,
+                               const float* freqs, const int* factors, int threads);
+
+/**
+ * @brief Stop the workers and destroy a bank created with fir_ddc_create().
+ */
+void fir_ddc_destroy(struct fir_ddc* ddc);
+
+/**
+ * @brief Clear the delay lines and restart the NCOs and decimation phases.
+ */
+void fir_ddc_reset(struct fir_ddc* ddc);
+
+/**
+ * @brief Retune a channel. The NCO phase stays continuous.
+ *
+ * @param ddc Bank
+ * @param channel Channel index
+ * @param freq New center frequency in Hz
+ * @return 0 on success, -1 on error
+ */
+int fir_ddc_set_freq(struct fir_ddc* ddc, int channel, float freq);
+
+/**
+ * @brief Down-convert a block of input samples on every channel.
+ *
+ * The decimation phase of each channel carries over between calls, like
+ * fir_stream_decimate(), so the input can be split into blocks of any size.
+ *
+ * @param ddc Bank
+ * @param in Real input samples
+ * @param n Number of input samples
+ * @param out Per channel: interleaved complex output (re, im), room for n / factor + 1 samples
+ * @param counts Per channel: number of complex samples written
+ * @return 0 on success, -1 on error
+ */
+int fir_ddc_process(struct fir_ddc* ddc, const float* in, int n, float* const* out, int* counts);
+
+#endif
@@ -0,0 +1,45 @@
+#include "fir_service.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static volatile sig_atomic_t stop = 0;
+
+static void handle_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+void print_usage(const char* prog_name) {
+    fprintf(stderr, "Usage: %s <socket_path> [max_entries]\n", prog_name);
+    fprintf(stderr, "  Serves firwin designs to local clients (fir_service_design) over a Unix socket.\n");
+    fprintf(stderr, "  max_entries: Number of designs kept in the cache (default 256)\n");
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    int max_entries = argc > 2 ? atoi(argv[2]) : 256;
+    if (max_entries < 1) {
+        fprintf(stderr, "Error: max_entries must be at least 1.\n");
+        return 1;
+    }
+
+    // Stop cleanly so the socket file is removed; the server takes the
+    // signals only while it waits, so the flag is checked right after
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (fir_service_serve(argv[1], max_entries, &stop) != 0) {
+        perror("fir_designd");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,247 @@
+#include "fir_farrow.h"
+#include "fir_alloc.h"
+#include "fir_cpu.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FIR_FARROW_MAX_DEGREE 7
+
+// Number of input samples handled per pass over the work buffer
+#define FIR_FARROW_CHUNK 1024
+
+struct fir_farrow {
+    int taps;           // Taps per phase
+    int groups;         // Branches are stored in groups of 4 lanes
+    float* coef;        // coef[(j * groups + g) * 4 + l]: tap j (reversed) of branch 4g + l
+    float* buf;         // taps-1 samples of history followed by one chunk of input
+    double step;        // Input samples per output sample
+    double frac;        // Fractional position of the next output
+    int next;           // Input index of the next output, relative to the current chunk
+};
+
+// Solve the least-squares polynomial fit over the points u[0..count-1]:
+// returns the (degree+1) x count matrix P such that P * v are the polynomial
+// coefficients fitting the values v
+static int fit_matrix(const double* u, int count, int degree, double* P) {
+    int d1 = degree + 1;
+    double M[FIR_FARROW_MAX_DEGREE + 1][FIR_FARROW_MAX_DEGREE + 1];
+
+    // Normal equations M = A^T A, right hand side A^T (stored in P)
+    for (int r = 0; r < d1; r++) {
+        for (int c = 0; c < d1; c++) {
+            double acc = 0.0;
+            for (int p = 0; p < count; p++) {
+                acc += pow(u[p], r + c);
+            }
+            M[r][c] = acc;
+        }
+        for (int p = 0; p < count; p++) {
+            P[r * count + p] = pow(u[p], r);
+        }
+    }
+
+    // Gauss-Jordan elimination with partial pivoting
+    for (int col = 0; col < d1; col++) {
+        int pivot = col;
+        for (int r = col + 1; r < d1; r++) {
+            if (fabs(M[r][col]) > fabs(M[pivot][col])) pivot = r;
+        }
+        if (fabs(M[pivot][col]) < 1e-300) {
+            return -1;
+        }
+        if (pivot != col) {
+            for (int c = 0; c < d1; c++) {
+                double t = M[col][c]; M[col][c] = M[pivot][c]; M[pivot][c] = t;
+            }
+            for (int p = 0; p < count; p++) {
+                double t = P[col * count + p];
+                P[col * count + p] = P[pivot * count + p];
+                P[pivot * count + p] = t;
+            }
+        }
+        for (int r = 0; r < d1; r++) {
+            if (r == col) continue;
+            double f = M[r][col] / M[col][col];
+            for (int c = 0; c < d1; c++) {
+                M[r][c] -= f * M[col][c];
+            }
+            for (int p = 0; p < count; p++) {
+                P[r * count + p] -= f * P[col * count + p];
+            }
+        }
+    }
+    for (int r = 0; r < d1; r++) {
+        for (int p = 0; p < count; p++) {
+            P[r * count + p] /= M[r][r];
+        }
+    }
+    return 0;
+}
+
+// Evaluate all branch filters at input position x: b[d] = sum(coef_d[j] * x[j])
+static void eval_branches(const struct fir_farrow* farrow, const float* x, float* b) {
+    const float* coef = farrow->coef;
+    const int taps = farrow->taps;
+#if FIR_X86
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    if (farrow->groups == 1) {
+        for (int j = 0; j < taps; j++) {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(coef + 4 * j), _mm_set1_ps(x[j])));
+        }
+    } else {
+        for (int j = 0; j < taps; j++) {
+            __m128 xj = _mm_set1_ps(x[j]);
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(coef + 8 * j), xj));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(coef + 8 * j + 4), xj));
+        }
+    }
+    _mm_storeu_ps(b, acc0);
+    _mm_storeu_ps(b + 4, acc1);
+#else
+    const int lanes = 4 * farrow->groups;
+    for (int l = 0; l < 8; l++) {
+        b[l] = 0.0f;
+    }
+    for (int j = 0; j < taps; j++) {
+        for (int l = 0; l < lanes; l++) {
+            b[l] += coef[lanes * j + l] * x[j];
+        }
+    }
+#endif
+}
+
+struct fir_farrow* fir_farrow_create(int taps_per_phase, int phases, int degree, float cutoff,
+                                     enum fir_filter_window_type window, double ratio) {
+    if (taps_per_phase < 2 || phases < 2 || degree < 1 || degree > FIR_FARROW_MAX_DEGREE) {
+        return NULL;
+    }
+    if (!(cutoff > 0.0f && cutoff < 1.0f) || !(ratio > 0.0)) {
+        return NULL;
+    }
+
+    const int K = taps_per_phase;
+    const int L = phases;
+    const int N = K * L;
+
+    struct fir_farrow* farrow = (struct fir_farrow*)calloc(1, sizeof(struct fir_farrow));
+    if (!farrow) {
+        return NULL;
+    }
+    farrow->taps = K;
+    farrow->groups = degree < 4 ? 1 : 2;
+    farrow->step = 1.0 / ratio;
+    farrow->coef = (float*)fir_alloc((size_t)K * farrow->groups * 4 * sizeof(float),
+                                     "fir_farrow.coef");
+    farrow->buf = (float*)fir_alloc((K - 1 + FIR_FARROW_CHUNK) * sizeof(float), "fir_farrow.buf");
+
+    // Prototype at L times the input rate, plus the fit points
+    // u = p / L - 1/2 for p = 0..L (the last point is the next tap's phase 0)
+    float* proto = (float*)malloc(N * sizeof(float));
+    double* u = (double*)malloc((L + 1) * sizeof(double));
+    double* P = (double*)malloc((size_t)(degree + 1) * (L + 1) * sizeof(double));
+
+    float cutoffs[2] = {0.0f, 0.5f * cutoff};
+    if (!farrow->coef || !farrow->buf || !proto || !u || !P ||
+        firwin(N, 2, cutoffs, (float)L, window, proto) != 0) {
+        goto fail;
+    }
+
+    for (int p = 0; p <= L; p++) {
+        u[p] = (double)p / L - 0.5;
+    }
+    if (fit_matrix(u, L + 1, degree, P) != 0) {
+        goto fail;
+    }
+
+    // Tap k at fractional delay mu is L * proto[k * L + mu * L]; fit a
+    // polynomial over each tap interval and store it in reversed tap order
+    const int lanes = 4 * farrow->groups;
+    for (int k = 0; k < K; k++) {
+        int j = K - 1 - k;
+        for (int d = 0; d <= degree; d++) {
+            double acc = 0.0;
+            for (int p = 0; p <= L; p++) {
+                int idx = k * L + p;
+                double v = idx < N ? (double)L * proto[idx] : 0.0;
+                acc += P[d * (L + 1) + p] * v;
+            }
+            farrow->coef[lanes * j + d] = (float)acc;
+        }
+    }
+
+    free(proto);
+    free(u);
+    free(P);
+    return farrow;
+
+fail:
+    free(proto);
+    free(u);
+    free(P);
+    fir_farrow_destroy(farrow);
+    return NULL;
+}
+
+void fir_farrow_destroy(struct fir_farrow* farrow) {
+    if (!farrow) return;
+    fir_free(farrow->coef);
+    fir_free(farrow->buf);
+    free(farrow);
+}
+
+void fir_farrow_reset(struct fir_farrow* farrow) {
+    if (!farrow) return;
+    memset(farrow->buf, 0, (farrow->taps - 1) * sizeof(float));
+    farrow->frac = 0.0;
+    farrow->next = 0;
+}
+
+int fir_farrow_set_ratio(struct fir_farrow* farrow, double ratio) {
+    if (!farrow || !(ratio > 0.0)) {
+        return -1;
+    }
+    farrow->step = 1.0 / ratio;
+    return 0;
+}
+
+int fir_farrow_process(struct fir_farrow* farrow, const float* in, int n, float* out) {
+    if (!farrow || n < 0 || (n > 0 && (!in || !out))) {
+        return -1;
+    }
+
+    const int hist = farrow->taps - 1;
+    const int top = 4 * farrow->groups - 1;
+    float* buf = farrow->buf;
+    float b[8];
+    int written = 0;
+
+    while (n > 0) {
+        int len = n < FIR_FARROW_CHUNK ? n : FIR_FARROW_CHUNK;
+        memcpy(buf + hist, in, len * sizeof(float));
+
+        // Output at input position next + frac uses inputs next-taps+1..next
+        while (farrow->next < len) {
+            eval_branches(farrow, buf + farrow->next, b);
+
+            float u = (float)(farrow->frac - 0.5);
+            float y = b[top];
+            for (int d = top - 1; d >= 0; d--) {
+                y = y * u + b[d];
+            }
+            out[written++] = y;
+
+            farrow->frac += farrow->step;
+            double whole = floor(farrow->frac);
+            farrow->frac -= whole;
+            farrow->next += (int)whole;
+        }
+        farrow->next -= len;
+
+        memmove(buf, buf + len, hist * sizeof(float));
+        in += len;
+        n -= len;
+    }
+    return written;
+}
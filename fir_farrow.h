@@ -0,0 +1,64 @@
+#ifndef FIR_FARROW_H
+#define FIR_FARROW_H
+
+#include "fir_filter.h"
+
+// Arbitrary-ratio resampler with a Farrow structure.
+//
+// A lowpass prototype with `phases` polyphase branches is designed with
+// firwin(), and each of its taps is approximated by a polynomial in the
+// fractional delay. Every output is computed from degree + 1 branch filters
+// evaluated at once and combined with Horner's rule, so any ratio can be
+// used (and changed between blocks) while only taps_per_phase * (degree + 1)
+// coefficients are stored.
+
+struct fir_farrow;
+
+/**
+ * @brief Create a resampler.
+ *
+ * The output is delayed by (taps_per_phase * phases - 1) / (2 * phases)
+ * input samples.
+ *
+ * @param taps_per_phase Number of input samples each output depends on (at least 2)
+ * @param phases Number of polyphase branches of the prototype used for the polynomial fit (at least 2)
+ * @param degree Degree of the polynomials (1 to 7)
+ * @param cutoff Passband edge of the prototype relative to the input Nyquist frequency (0 < cutoff < 1)
+ * @param window Window type of the prototype
+ * @param ratio Output rate divided by input rate
+ * @return New resampler, or NULL on error
+ */
+struct fir_farrow* fir_farrow_create(int taps_per_phase, int phases, int degree, float cutoff,
+                                     enum fir_filter_window_type window, double ratio);
+
+/**
+ * @brief Destroy a resampler created with fir_farrow_create().
+ */
+void fir_farrow_destroy(struct fir_farrow* farrow);
+
+/**
+ * @brief Clear the delay line and the output phase.
+ */
+void fir_farrow_reset(struct fir_farrow* farrow);
+
+/**
+ * @brief Change the resampling ratio; takes effect from the next output sample.
+ *
+ * @param farrow Resampler
+ * @param ratio Output rate divided by input rate
+ * @return 0 on success, -1 on error
+ */
+int fir_farrow_set_ratio(struct fir_farrow* farrow, double ratio);
+
+/**
+ * @brief Resample a block of samples.
+ *
+ * @param farrow Resampler
+ * @param in Input samples
+ * @param n Number of input samples
+ * @param out Output samples (room for ceil(n * ratio) + 1 samples)
+ * @return Number of output samples written, or -1 on error
+ */
+int fir_farrow_process(struct fir_farrow* farrow, const float* in, int n, float* out);
+
+#endif
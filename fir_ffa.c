@@ -0,0 +1,301 @@
+#include "fir_ffa.h"
+#include "fir_alloc.h"
+#include "fir_cpu.h"
+#include "fir_kernel.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Sub-filter products per stage: 3 for L = 2, 6 for L = 3
+#define FFA_MAX_PRODUCTS 6
+
+// The stage of L = 2 is the common one and has vector variants: split_2
+// deinterleaves x into X0, X1 and X0 + X1, combine_2 interleaves the outputs
+typedef void (*split_kernel)(const float* x, float* in0, float* in1, float* in2, int len);
+typedef void (*combine_kernel)(const float* m0, const float* m1, const float* m2, float* y,
+                               int q_count);
+
+// Each stage is a node: factor L splits the filter into products sub-filters
+// of subtaps taps, which are nodes of the next stage or leaves (factor 0)
+struct fir_ffa {
+    int numtaps;
+    int factor;
+    int products;
+    int subtaps;
+    int max_q;          // Largest number of output groups per call
+    float* rtaps;       // For leaves and the outputs after the last full group
+    float* in;          // Input of each product: max_q + subtaps samples
+    float* out;         // Output of each product: max_q + 1 samples
+    struct fir_ffa* sub[FFA_MAX_PRODUCTS];
+    split_kernel split_2;
+    combine_kernel combine_2;
+};
+
+static void split_2_scalar(const float* x, float* in0, float* in1, float* in2, int len) {
+    for (int s = 0; s < len; s++) {
+        float x0 = x[2 * s], x1 = x[2 * s + 1];
+        in0[s] = x0;
+        in1[s] = x1;
+        in2[s] = x0 + x1;
+    }
+}
+
+static void combine_2_scalar(const float* m0, const float* m1, const float* m2, float* y,
+                             int q_count) {
+    for (int q = 0; q < q_count; q++) {
+        y[2 * q] = m2[q] - m0[q] - m1[q];
+        y[2 * q + 1] = m1[q] + m0[q + 1];
+    }
+}
+
+#if FIR_X86
+__attribute__((target("avx2,fma")))
+static void split_2_avx2(const float* x, float* in0, float* in1, float* in2, int len) {
+    int s = 0;
+    for (; s + 8 <= len; s += 8) {
+        __m256 a = _mm256_loadu_ps(x + 2 * s);
+        __m256 b = _mm256_loadu_ps(x + 2 * s + 8);
+        __m256 x0 = _mm256_castpd_ps(_mm256_permute4x64_pd(
+            _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+        __m256 x1 = _mm256_castpd_ps(_mm256_permute4x64_pd(
+            _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(in0 + s, x0);
+        _mm256_storeu_ps(in1 + s, x1);
+        _mm256_storeu_ps(in2 + s, _mm256_add_ps(x0, x1));
+    }
+    split_2_scalar(x + 2 * s, in0 + s, in1 + s, in2 + s, len - s);
+}
+
+__attribute__((target("avx2,fma")))
+static void combine_2_avx2(const float* m0, const float* m1, const float* m2, float* y,
+                           int q_count) {
+    int q = 0;
+    for (; q + 8 <= q_count; q += 8) {
+        __m256 a = _mm256_loadu_ps(m0 + q);
+        __m256 b = _mm256_loadu_ps(m1 + q);
+        __m256 even = _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(m2 + q), a), b);
+        __m256 odd = _mm256_add_ps(b, _mm256_loadu_ps(m0 + q + 1));
+        __m256 lo = _mm256_unpacklo_ps(even, odd);
+        __m256 hi = _mm256_unpackhi_ps(even, odd);
+        _mm256_storeu_ps(y + 2 * q, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(y + 2 * q + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    combine_2_scalar(m0 + q, m1 + q, m2 + q, y + 2 * q, q_count - q);
+}
+#endif
+
+// Sum of polyphase components of the taps, a through b, each padded to len
+static void sum_phases(const float* rtaps, int numtaps, int factor, int a, int b, int len,
+                       float* out) {
+    for (int p = 0; p < len; p++) {
+        float acc = 0.0f;
+        for (int c = a; c <= b; c++) {
+            // The reversed polyphase order makes the sub-filters a linear
+            // convolution of the input phases with these tap phases
+            int k = p * factor + (factor - 1 - c);
+            acc += k < numtaps ? rtaps[k] : 0.0f;
+        }
+        out[p] = acc;
+    }
+}
+
+static struct fir_ffa* create_node(const float* rtaps, int numtaps, const int* factors, int stages,
+                                   int max_n) {
+    struct fir_ffa* ffa = (struct fir_ffa*)calloc(1, sizeof(struct fir_ffa));
+    if (!ffa) {
+        return NULL;
+    }
+    ffa->numtaps = numtaps;
+    ffa->rtaps = (float*)fir_alloc(numtaps * sizeof(float), "fir_ffa.taps");
+    if (!ffa->rtaps) {
+        fir_ffa_destroy(ffa);
+        return NULL;
+    }
+    memcpy(ffa->rtaps, rtaps, numtaps * sizeof(float));
+
+    // A stage needs at least two taps per sub-filter and one full group
+    if (stages == 0 || numtaps < 2 * factors[0] || max_n < factors[0]) {
+        return ffa;
+    }
+
+    const int L = factors[0];
+    ffa->factor = L;
+    ffa->products = L == 2 ? 3 : 6;
+    ffa->subtaps = (numtaps + L - 1) / L;
+    ffa->max_q = max_n / L;
+    ffa->split_2 = split_2_scalar;
+    ffa->combine_2 = combine_2_scalar;
+#if FIR_X86
+    if (fir_cpu_has_avx2()) {
+        ffa->split_2 = split_2_avx2;
+        ffa->combine_2 = combine_2_avx2;
+    }
+#endif
+
+    const size_t in_len = (size_t)ffa->max_q + ffa->subtaps;
+    ffa->in = (float*)fir_alloc(ffa->products * in_len * sizeof(float), "fir_ffa.in");
+    ffa->out = (float*)fir_alloc(ffa->products * ((size_t)ffa->max_q + 1) * sizeof(float),
+                                 "fir_ffa.out");
+    float* t = (float*)malloc(ffa->subtaps * sizeof(float));
+    if (!ffa->in || !ffa->out || !t) {
+        free(t);
+        fir_ffa_destroy(ffa);
+        return NULL;
+    }
+
+    // Product j multiplies the sum of input phases a..b with the sum of the
+    // same tap phases; the ranges follow the combination in fir_ffa_process()
+    static const int ranges2[3][2] = { {0, 0}, {1, 1}, {0, 1} };
+    static const int ranges3[6][2] = { {0, 0}, {1, 1}, {2, 2}, {0, 1}, {1, 2}, {0, 2} };
+    for (int j = 0; j < ffa->products; j++) {
+        const int* r = L == 2 ? ranges2[j] : ranges3[j];
+        sum_phases(rtaps, numtaps, L, r[0], r[1], ffa->subtaps, t);
+        ffa->sub[j] = create_node(t, ffa->subtaps, factors + 1, stages - 1, ffa->max_q + 1);
+        if (!ffa->sub[j]) {
+            free(t);
+            fir_ffa_destroy(ffa);
+            return NULL;
+        }
+    }
+    free(t);
+    return ffa;
+}
+
+struct fir_ffa* fir_ffa_create(const float* rtaps, int numtaps, int parallel, int max_n) {
+    if (!rtaps || numtaps <= 0 || parallel < 2 || max_n <= 0) {
+        return NULL;
+    }
+
+    // Split into stages of 3 first, so the widest split sees the longest filter
+    int factors[32];
+    int stages = 0;
+    while (parallel % 3 == 0) {
+        factors[stages++] = 3;
+        parallel /= 3;
+    }
+    while (parallel % 2 == 0) {
+        factors[stages++] = 2;
+        parallel /= 2;
+    }
+    if (parallel != 1) {
+        return NULL;
+    }
+    return create_node(rtaps, numtaps, factors, stages, max_n);
+}
+
+void fir_ffa_destroy(struct fir_ffa* ffa) {
+    if (!ffa) return;
+    for (int j = 0; j < FFA_MAX_PRODUCTS; j++) {
+        fir_ffa_destroy(ffa->sub[j]);
+    }
+    fir_free(ffa->rtaps);
+    fir_free(ffa->in);
+    fir_free(ffa->out);
+    free(ffa);
+}
+
+// Split x into the inputs of the products. Samples beyond the end of x only
+// meet taps whose contributions cancel, so they are read as zero.
+static void split_input(const struct fir_ffa* ffa, const float* x, int x_len, int len) {
+    const int L = ffa->factor;
+    const size_t stride = (size_t)ffa->max_q + ffa->subtaps;
+    float* in = ffa->in;
+    int full = x_len / L < len ? x_len / L : len;
+
+    if (L == 2) {
+        ffa->split_2(x, in, in + stride, in + 2 * stride, full);
+    } else {
+        for (int s = 0; s < full; s++) {
+            float x0 = x[3 * s], x1 = x[3 * s + 1], x2 = x[3 * s + 2];
+            in[s] = x0;
+            in[stride + s] = x1;
+            in[2 * stride + s] = x2;
+            in[3 * stride + s] = x0 + x1;
+            in[4 * stride + s] = x1 + x2;
+            in[5 * stride + s] = x0 + x1 + x2;
+        }
+    }
+    for (int s = full; s < len; s++) {
+        float v[3] = {0.0f, 0.0f, 0.0f};
+        for (int c = 0; c < L; c++) {
+            v[c] = L * s + c < x_len ? x[L * s + c] : 0.0f;
+        }
+        in[s] = v[0];
+        in[stride + s] = v[1];
+        if (L == 2) {
+            in[2 * stride + s] = v[0] + v[1];
+        } else {
+            in[2 * stride + s] = v[2];
+            in[3 * stride + s] = v[0] + v[1];
+            in[4 * stride + s] = v[1] + v[2];
+            in[5 * stride + s] = v[0] + v[1] + v[2];
+        }
+    }
+}
+
+void fir_ffa_process(struct fir_ffa* ffa, const float* x, float* y, int n) {
+    const int L = ffa->factor;
+    const int q_count = L ? n / L : 0;
+    if (q_count == 0) {
+        fir_kernel_blocked(ffa->rtaps, ffa->numtaps, x, y, n);
+        return;
+    }
+
+    // Each product needs one extra output, for the phases that reach into
+    // the next group; it is a plain dot product, so the sub-filters keep
+    // whole blocks
+    const int len = q_count + ffa->subtaps;
+    const size_t in_stride = (size_t)ffa->max_q + ffa->subtaps;
+    const size_t out_stride = (size_t)ffa->max_q + 1;
+    split_input(ffa, x, ffa->numtaps - 1 + n, len);
+    for (int j = 0; j < ffa->products; j++) {
+        const float* in = ffa->in + j * in_stride;
+        float* out = ffa->out + j * out_stride;
+        fir_ffa_process(ffa->sub[j], in, out, q_count);
+
+        const float* t = ffa->sub[j]->rtaps;
+        float acc = 0.0f;
+        for (int k = 0; k < ffa->subtaps; k++) {
+            acc += t[k] * in[q_count + k];
+        }
+        out[q_count] = acc;
+    }
+
+    // Output phase b is the convolution term L - 1 + b plus term b - 1 of
+    // the next group
+    const float* m0 = ffa->out;
+    const float* m1 = m0 + out_stride;
+    const float* m2 = m1 + out_stride;
+    if (L == 2) {
+        ffa->combine_2(m0, m1, m2, y, q_count);
+    } else {
+        const float* m3 = m2 + out_stride;
+        const float* m4 = m3 + out_stride;
+        const float* m5 = m4 + out_stride;
+        for (int q = 0; q < q_count; q++) {
+            y[3 * q] = m5[q] - m3[q] - m4[q] + 2.0f * m1[q];
+            y[3 * q + 1] = m4[q] - m1[q] - m2[q] + m0[q + 1];
+            y[3 * q + 2] = m2[q] + m3[q + 1] - m0[q + 1] - m1[q + 1];
+        }
+    }
+
+    int done = q_count * L;
+    if (done < n) {
+        fir_kernel_blocked(ffa->rtaps, ffa->numtaps, x + done, y + done, n - done);
+    }
+}
+
+int fir_ffa_parallel(int numtaps, int max_n) {
+    // Measured against fir_kernel_blocked(): 2 saves about 20% from 64 taps
+    // on, 4 about 35% from 256 taps. Each stage halves the blocks of the
+    // sub-filters, and below about 128 outputs per sub-filter block the
+    // split and combine cost more than they save. The 3-parallel stage has
+    // no vector split and never beat two 2-parallel stages.
+    if (numtaps < FIR_FFA_MIN_TAPS || numtaps > FIR_FFA_MAX_TAPS) {
+        return 0;
+    }
+    int parallel = numtaps >= 256 ? 4 : 2;
+    while (parallel > 1 && max_n < 128 * parallel) {
+        parallel /= 2;
+    }
+    return parallel > 1 ? parallel : 0;
+}
@@ -0,0 +1,59 @@
+#ifndef FIR_FFA_H
+#define FIR_FFA_H
+
+// Fast FIR algorithm (FFA) engine for mid-length filters (internal header).
+//
+// An L-parallel FFA splits the taps and the input into L polyphase
+// components and computes the L interleaved output phases from sub-filter
+// products, like a polynomial multiplication: Karatsuba for L = 2 (3
+// sub-filters of numtaps/2 taps instead of 4) and the 3-point Winograd
+// algorithm for L = 3 (6 sub-filters of numtaps/3 taps instead of 9). The
+// sub-filters can be FFAs themselves, so 4 = 2x2 needs 9 sub-filters of
+// numtaps/4 taps: 44% fewer multiplications than the direct form, at the
+// cost of some additions before and after. The innermost sub-filters run on
+// fir_kernel_blocked().
+//
+// The result is mathematically that of fir_kernel_direct(), but rounding
+// differs and depends on where n starts, because outputs are computed in
+// groups of the parallelism.
+
+// Range of tap counts for which fir_ffa_parallel() picks an FFA
+#define FIR_FFA_MIN_TAPS 64
+#define FIR_FFA_MAX_TAPS 512
+
+struct fir_ffa;
+
+/**
+ * @brief Create an FFA engine.
+ *
+ * @param rtaps Taps in reverse order (copied)
+ * @param numtaps Number of taps
+ * @param parallel Outputs per group: a product of 2s and 3s (2, 3, 4, 6, 8, 9, ...)
+ * @param max_n Largest number of outputs per fir_ffa_process() call
+ * @return Engine, or NULL on error (invalid arguments or out of memory)
+ */
+struct fir_ffa* fir_ffa_create(const float* rtaps, int numtaps, int parallel, int max_n);
+
+/**
+ * @brief Destroy an FFA engine.
+ */
+void fir_ffa_destroy(struct fir_ffa* ffa);
+
+/**
+ * @brief Compute y[i] = sum(rtaps[k] * x[i + k], k = 0..numtaps-1) for i in [0, n).
+ *
+ * Same contract as fir_kernel_direct(): x holds numtaps - 1 + n samples.
+ *
+ * @param n Number of outputs, at most max_n
+ */
+void fir_ffa_process(struct fir_ffa* ffa, const float* x, float* y, int n);
+
+/**
+ * @brief Parallelism of the fastest FFA for a filter, or 0 if fir_kernel_blocked() is faster.
+ *
+ * @param numtaps Number of taps
+ * @param max_n Outputs per fir_ffa_process() call in the caller's loop
+ */
+int fir_ffa_parallel(int numtaps, int max_n);
+
+#endif
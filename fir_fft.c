@@ -0,0 +1,143 @@
+#include "fir_fft.h"
+#include <math.h>
+#include <stdlib.h>
+
+// cos and sin of 2 pi k / n for k in [0, n/2)
+static void twiddles(int n, double* c, double* s) {
+    int half = n / 2;
+    int quarter = n / 4;
+    int eighth = n / 8;
+
+    for (int k = 0; k <= eighth && k < half; k++) {
+        double a = 2.0 * M_PI * k / n;
+        c[k] = cos(a);
+        s[k] = sin(a);
+    }
+    // Reflect about pi/4, then about pi/2
+    for (int k = eighth + 1; k <= quarter && k < half; k++) {
+        c[k] = s[quarter - k];
+        s[k] = c[quarter - k];
+    }
+    for (int k = quarter + 1; k < half; k++) {
+        c[k] = -c[half - k];
+        s[k] = s[half - k];
+    }
+}
+
+// Allocate and fill the twiddle table for length n
+static int make_twiddles(int n, double** c, double** s) {
+    *c = (double*)malloc((n / 2) * sizeof(double));
+    *s = (double*)malloc((n / 2) * sizeof(double));
+    if (!*c || !*s) {
+        free(*c);
+        free(*s);
+        return -1;
+    }
+    twiddles(n, *c, *s);
+    return 0;
+}
+
+// In-place transform of length n using the twiddles of length n * stride
+// (every stride-th entry); sign is -1 for the forward transform
+static void transform(double* re, double* im, int n, const double* c, const double* s,
+                      int stride, double sign) {
+    // Bit-reversal permutation
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j |= bit;
+        if (i < j) {
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    // Butterflies; at each stage the twiddle for offset j is k = j * n / size
+    for (int size = 2; size <= n; size <<= 1) {
+        int half = size / 2;
+        int step = stride * (n / size);
+        for (int start = 0; start < n; start += size) {
+            double* ra = re + start;
+            double* ia = im + start;
+            double* rb = ra + half;
+            double* ib = ia + half;
+            for (int j = 0; j < half; j++) {
+                double wr = c[j * step];
+                double wi = sign * s[j * step];
+                double tr = rb[j] * wr - ib[j] * wi;
+                double ti = rb[j] * wi + ib[j] * wr;
+                rb[j] = ra[j] - tr;
+                ib[j] = ia[j] - ti;
+                ra[j] += tr;
+                ia[j] += ti;
+            }
+        }
+    }
+}
+
+int fir_fft(double* re, double* im, int n, int inverse) {
+    if (!re || !im || n <= 0 || (n & (n - 1)) != 0) {
+        return -1;
+    }
+    if (n == 1) {
+        return 0;
+    }
+
+    double* c;
+    double* s;
+    if (make_twiddles(n, &c, &s) != 0) {
+        return -1;
+    }
+    transform(re, im, n, c, s, 1, inverse ? 1.0 : -1.0);
+    free(c);
+    free(s);
+    return 0;
+}
+
+int fir_fft_real_inverse(const double* re, const double* im, int n, double* out) {
+    if (!re || !im || !out || n < 2 || (n & (n - 1)) != 0) {
+        return -1;
+    }
+
+    // Split the sum into even and odd outputs: with A = X[k] and
+    // B = X[k + n/2], out[2j] + i out[2j+1] is the inverse transform of
+    // length n/2 of (A + B) + i w^k (A - B), w = exp(2 pi i / n)
+    int half = n / 2;
+    double* c;
+    double* s;
+    if (make_twiddles(n, &c, &s) != 0) {
+        return -1;
+    }
+    double* zr = out;
+    double* zi = (double*)malloc(half * sizeof(double));
+    if (!zi) {
+        free(c);
+        free(s);
+        return -1;
+    }
+
+    for (int k = 0; k < half; k++) {
+        double ar = re[k];
+        double ai = im[k];
+        double br = k ? re[half - k] : re[half];
+        double bi = k ? -im[half - k] : im[half];
+        double dr = ar - br;
+        double di = ai - bi;
+        zr[k] = ar + br - (c[k] * di + s[k] * dr);
+        zi[k] = ai + bi + (c[k] * dr - s[k] * di);
+    }
+    transform(zr, zi, half, c, s, 2, 1.0);
+
+    // Interleave from the back so the real parts are not overwritten early
+    for (int j = half - 1; j >= 0; j--) {
+        out[2 * j + 1] = zi[j];
+        out[2 * j] = zr[j];
+    }
+
+    free(c);
+    free(s);
+    free(zi);
+    return 0;
+}
@@ -0,0 +1,36 @@
+#ifndef FIR_FFT_H
+#define FIR_FFT_H
+
+// Complex FFT in double precision used by the design functions (internal
+// header).
+//
+// Iterative radix-2 transform on separate real and imaginary arrays. The
+// twiddle factors are computed for one octant with libm and completed by
+// symmetry, so they are correctly rounded and the transform is accurate to
+// a few ULP times log2(n).
+
+/**
+ * @brief In-place FFT of length n: X[k] = sum_j x[j] exp(-2 pi i j k / n), or
+ * with exp(+2 pi i j k / n) if inverse is set. The inverse is not scaled by 1/n.
+ *
+ * @param re Real parts (n values)
+ * @param im Imaginary parts (n values)
+ * @param n Length, a power of two
+ * @param inverse Nonzero for the inverse transform
+ * @return 0 on success, -1 on error (n not a power of two, or out of memory)
+ */
+int fir_fft(double* re, double* im, int n, int inverse);
+
+/**
+ * @brief Inverse FFT of a Hermitian spectrum (real result), at the cost of a complex FFT of length n/2:
+ * out[j] = sum_k X[k] exp(+2 pi i j k / n), not scaled by 1/n.
+ *
+ * @param re Real parts of X[0] to X[n/2]; the other half is X[n-k] = conj(X[k])
+ * @param im Imaginary parts of X[0] to X[n/2]
+ * @param n Length, a power of two of at least 2
+ * @param out Output (n values)
+ * @return 0 on success, -1 on error (n not a power of two, or out of memory)
+ */
+int fir_fft_real_inverse(const double* re, const double* im, int n, double* out);
+
+#endif
@@ -1,55 +1,74 @@
 #include "fir_filter.h"
+#include "fir_fft.h"
+#include "fir_math.h"
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
-// Sinc function
-static float sinc(float x) {
-    if (x == 0.0f) {
-        return 1.0f;
+// Number of taps processed per call to the vectorized trig kernels
+#define FIR_TILE 256
+
+// Designs with at least this many taps generate the sinc numerators with a
+// rotation recurrence instead of fir_sinpi
+#define FIR_ROTOR_MIN_TAPS 1024
+
+// Independent recurrence lanes; must divide FIR_TILE
+#define FIR_ROTOR_LANES 8
+
+// Cosine-sum window: w = a[0] - a[1] cos(x) + a[2] cos(2x) - ..., x = 2 pi i / (n - 1)
+static void cosine_sum_window(const float* a, int terms, int n, int start, int len, float* w) {
+    float arg[FIR_TILE];
+    float c[FIR_TILE];
+
+    for (int j = 0; j < len; j++) {
+        w[j] = a[0];
+    }
+    for (int t = 1; t < terms; t++) {
+        float coef = (t % 2) ? -a[t] : a[t];
+        for (int j = 0; j < len; j++) {
+            arg[j] = (float)(2.0 * t * (start + j) / (n - 1));
+        }
+        fir_cospi(arg, c, len);
+        for (int j = 0; j < len; j++) {
+            w[j] += coef * c[j];
+        }
     }
-    return sinf(M_PI * x) / (M_PI * x);
 }
 
-// Apply the specified window to the data
-static void apply_window(float* data, int n, enum fir_filter_window_type window) {
-    if (n <= 0) return;
-    
+// Compute window values w[j] for samples i = start + j of an n-point window,
+// len <= FIR_TILE
+static void window_values(enum fir_filter_window_type window, int n, int start, int len, float* w) {
+    if (n == 1) {
+        w[0] = 1.0f;
+        return;
+    }
+
     switch (window) {
         case RECTANGULAR:
-            // Rectangular window is all ones - no need to do anything
+            for (int j = 0; j < len; j++) {
+                w[j] = 1.0f;
+            }
             break;
             
         case HAMMING:
         {
-            const float a0 = 0.54f;
-            const float a1 = 1.0f - a0;
-            
-            for (int i = 0; i < n; i++) {
-                float win = a0 - a1 * cosf(2.0f * M_PI * i / (n - 1));
-                data[i] *= win;
-            }
+            const float a[2] = {0.54f, 0.46f};
+            cosine_sum_window(a, 2, n, start, len, w);
             break;
         }
         
         case BLACKMAN:
         {
-            const float a0 = 0.42f;
-            const float a1 = 0.5f;
-            const float a2 = 0.08f;
-            
-            for (int i = 0; i < n; i++) {
-                float x = 2.0f * M_PI * i / (n - 1);
-                float win = a0 - a1 * cosf(x) + a2 * cosf(2.0f * x);
-                data[i] *= win;
-            }
+            const float a[3] = {0.42f, 0.5f, 0.08f};
+            cosine_sum_window(a, 3, n, start, len, w);
             break;
         }
         
         case TRIANGULAR:
         {
-            for (int i = 0; i < n; i++) {
-                float win = 1.0f - fabsf((i - (n - 1) / 2.0f) / (n / 2.0f));
-                data[i] *= win;
+            for (int j = 0; j < len; j++) {
+                int i = start + j;
+                w[j] = 1.0f - fabsf((i - (n - 1) / 2.0f) / (n / 2.0f));
             }
             break;
         }
@@ -58,16 +77,15 @@ static void apply_window(float* data, int n, enum fir_filter_window_type window)
         {
             int N = n - 1;
             float half_N = N / 2.0f;
-            for (int i = 0; i < n; i++) {
+            for (int j = 0; j < len; j++) {
+                int i = start + j;
                 float x = fabsf((i - half_N) / half_N);
-                float win;
                 if (x <= 0.5f) {
-                    win = 1.0f - 6.0f * x * x * (1.0f - x);
+                    w[j] = 1.0f - 6.0f * x * x * (1.0f - x);
                 } else {
                     float temp = 1.0f - x;
-                    win = 2.0f * temp * temp * temp;
+                    w[j] = 2.0f * temp * temp * temp;
                 }
-                data[i] *= win;
             }
             break;
         }
@@ -75,96 +93,127 @@ static void apply_window(float* data, int n, enum fir_filter_window_type window)
         case BOHMAN:
         {
             float N = (float)(n - 1);
-            for (int i = 0; i < n; i++) {
-                float x = fabsf(2.0f * i / N - 1.0f);
-                float win = (1.0f - x) * cosf(M_PI * x) + sinf(M_PI * x) / M_PI;
-                data[i] *= win;
+            float x[FIR_TILE];
+            float c[FIR_TILE];
+            float s[FIR_TILE];
+            for (int j = 0; j < len; j++) {
+                x[j] = fabsf(2.0f * (start + j) / N - 1.0f);
+            }
+            fir_cospi(x, c, len);
+            fir_sinpi(x, s, len);
+            for (int j = 0; j < len; j++) {
+                w[j] = (1.0f - x[j]) * c[j] + s[j] / (float)M_PI;
             }
             break;
         }
         
         case NUTTALL:
         {
-            const float a0 = 0.3635819f;
-            const float a1 = 0.4891775f;
-            const float a2 = 0.1365995f;
-            const float a3 = 0.0106411f;
-            
-            for (int i = 0; i < n; i++) {
-                float x = 2.0f * M_PI * i / (n - 1);
-                float win = a0 - a1 * cosf(x) + a2 * cosf(2.0f * x) - a3 * cosf(3.0f * x);
-                data[i] *= win;
-            }
+            const float a[4] = {0.3635819f, 0.4891775f, 0.1365995f, 0.0106411f};
+            cosine_sum_window(a, 4, n, start, len, w);
             break;
         }
         
         case BLACKMANHARRIS:
         {
-            const float a0 = 0.35875f;
-            const float a1 = 0.48829f;
-            const float a2 = 0.14128f;
-            const float a3 = 0.01168f;
-            
-            for (int i = 0; i < n; i++) {
-                float x = 2.0f * M_PI * i / (n - 1);
-                float win = a0 - a1 * cosf(x) + a2 * cosf(2.0f * x) - a3 * cosf(3.0f * x);
-                data[i] *= win;
-            }
+            const float a[4] = {0.35875f, 0.48829f, 0.14128f, 0.01168f};
+            cosine_sum_window(a, 4, n, start, len, w);
             break;
         }
         
         case FLATTOP:
         {
-            const float a0 = 0.21557895f;
-            const float a1 = 0.41663158f;
-            const float a2 = 0.277263158f;
-            const float a3 = 0.083578947f;
-            const float a4 = 0.006947368f;
-            
-            for (int i = 0; i < n; i++) {
-                float x = 2.0f * M_PI * i / (n - 1);
-                float win = a0 - a1 * cosf(x) + a2 * cosf(2.0f * x) - 
-                           a3 * cosf(3.0f * x) + a4 * cosf(4.0f * x);
-                data[i] *= win;
-            }
+            const float a[5] = {0.21557895f, 0.41663158f, 0.277263158f, 0.083578947f, 0.006947368f};
+            cosine_sum_window(a, 5, n, start, len, w);
             break;
         }
         
         case BARTLETT:
         {
             float N = (float)(n - 1);
-            for (int i = 0; i < n; i++) {
-                float win = 1.0f - fabsf(2.0f * i / N - 1.0f);
-                data[i] *= win;
+            for (int j = 0; j < len; j++) {
+                w[j] = 1.0f - fabsf(2.0f * (start + j) / N - 1.0f);
             }
             break;
         }
         
         case HANN:
         {
-            for (int i = 0; i < n; i++) {
-                float win = 0.5f * (1.0f - cosf(2.0f * M_PI * i / (n - 1)));
-                data[i] *= win;
-            }
+            const float a[2] = {0.5f, 0.5f};
+            cosine_sum_window(a, 2, n, start, len, w);
             break;
         }
         
         case COSINE:
         {
-            for (int i = 0; i < n; i++) {
-                float win = sinf(M_PI * (i + 0.5f) / n);
-                data[i] *= win;
+            float x[FIR_TILE];
+            for (int j = 0; j < len; j++) {
+                x[j] = (start + j + 0.5f) / n;
             }
+            fir_sinpi(x, w, len);
             break;
         }
+
+        default:
+            for (int j = 0; j < len; j++) {
+                w[j] = 1.0f;
+            }
+            break;
     }
 }
 
-// Create a FIR filter using the window method
-int firwin(int numtaps, int cutoff_count, const float* cutoffs, float fs, 
-           enum fir_filter_window_type window, float* out) {
-    // Validate inputs
-    if (numtaps <= 0 || cutoff_count <= 0 || !cutoffs || !out) {
+// All windows are symmetric, so only the first (n + 1) / 2 values are computed
+int fir_window_half(enum fir_filter_window_type window, int n, float* out) {
+    if (n <= 0 || !out || window < RECTANGULAR || window > COSINE) {
+        return -1;
+    }
+
+    int half = (n + 1) / 2;
+    for (int start = 0; start < half; start += FIR_TILE) {
+        int len = half - start < FIR_TILE ? half - start : FIR_TILE;
+        window_values(window, n, start, len, out + start);
+    }
+    return 0;
+}
+
+int fir_window(enum fir_filter_window_type window, int n, float* out) {
+    if (fir_window_half(window, n, out) != 0) {
+        return -1;
+    }
+
+    for (int i = (n + 1) / 2; i < n; i++) {
+        out[i] = out[n - 1 - i];
+    }
+    return 0;
+}
+
+int fir_window_apply(enum fir_filter_window_type window, int n, float* data) {
+    if (n <= 0 || !data || window < RECTANGULAR || window > COSINE) {
+        return -1;
+    }
+    if (window == RECTANGULAR) {
+        return 0;
+    }
+
+    float w[FIR_TILE];
+    int half = (n + 1) / 2;
+    for (int start = 0; start < half; start += FIR_TILE) {
+        int len = half - start < FIR_TILE ? half - start : FIR_TILE;
+        window_values(window, n, start, len, w);
+        for (int j = 0; j < len; j++) {
+            int i = start + j;
+            data[i] *= w[j];
+            if (n - 1 - i != i) {
+                data[n - 1 - i] *= w[j];
+            }
+        }
+    }
+    return 0;
+}
+
+// Check the parameters shared by firwin and the design handle
+static int validate_cutoffs(int numtaps, int cutoff_count, const float* cutoffs, float fs) {
+    if (numtaps <= 0 || cutoff_count <= 0 || !cutoffs) {
         return -1;
     }
     
@@ -192,58 +241,677 @@ int firwin(int numtaps, int cutoff_count, const float* cutoffs, float fs,
     if (cutoffs[cutoff_count-1] == nyquist && numtaps % 2 == 0) {
         return -1;  // Even number of taps can't have response at Nyquist
     }
-    
-    // Allocate temporary array for the filter coefficients
-    float* h = (float*)calloc(numtaps, sizeof(float));
-    if (!h) {
+    return 0;
+}
+
+// Compute 1 / (pi * m) for taps start..start+len-1, m = n - alpha. Returns
+// the index of the center tap (m = 0) within the tile, or -1.
+static int tile_reciprocals(int start, int len, float alpha, float* inv) {
+    int center = -1;
+    for (int j = 0; j < len; j++) {
+        float m = start + j - alpha;
+        if (m == 0.0f) {
+            center = j;
+            inv[j] = 0.0f;
+        } else {
+            inv[j] = (float)(1.0 / (M_PI * m));
+        }
+    }
+    return center;
+}
+
+// sin(pi * x) and cos(pi * x) in double precision, with exact reduction of x
+// to [-1, 1]
+static void sincospi(double x, double* s, double* c) {
+    x -= 2.0 * nearbyint(0.5 * x);
+    *s = sin(M_PI * x);
+    *c = cos(M_PI * x);
+}
+
+// Generates sin(pi * edge * m) for consecutive taps by rotating (cos, sin)
+// pairs by pi * edge per tap. The arguments form an arithmetic progression,
+// so no trig function is evaluated after the setup. Each lane advances by
+// FIR_ROTOR_LANES taps per step so the lanes are independent, and the pairs
+// are pulled back to unit length after every tile; in double precision the
+// values stay within float rounding of sin for millions of taps. Unlike
+// fir_sinpi, the argument is never rounded to float, which matters once
+// edge * m grows large.
+struct sinc_rotor {
+    double s[FIR_ROTOR_LANES];
+    double c[FIR_ROTOR_LANES];
+    double step_s;      // sin and cos of one step (FIR_ROTOR_LANES taps)
+    double step_c;
+};
+
+// Start the sequence at tap 0, m = -alpha
+static void rotor_init(struct sinc_rotor* r, float edge, float alpha) {
+    double s, c, tap_s, tap_c;
+    sincospi(-(double)edge * alpha, &s, &c);
+    sincospi(edge, &tap_s, &tap_c);
+    sincospi((double)edge * FIR_ROTOR_LANES, &r->step_s, &r->step_c);
+
+    for (int l = 0; l < FIR_ROTOR_LANES; l++) {
+        r->s[l] = s;
+        r->c[l] = c;
+        double t = s * tap_c + c * tap_s;
+        c = c * tap_c - s * tap_s;
+        s = t;
+    }
+}
+
+// Write the next len (<= FIR_TILE) values to out
+static void rotor_next(struct sinc_rotor* r, int len, float* out) {
+    double s[FIR_ROTOR_LANES];
+    double c[FIR_ROTOR_LANES];
+    const double step_s = r->step_s;
+    const double step_c = r->step_c;
+    float tile[FIR_TILE];
+
+    for (int l = 0; l < FIR_ROTOR_LANES; l++) {
+        s[l] = r->s[l];
+        c[l] = r->c[l];
+    }
+    for (int j = 0; j < len; j += FIR_ROTOR_LANES) {
+        for (int l = 0; l < FIR_ROTOR_LANES; l++) {
+            tile[j + l] = (float)s[l];
+            double t = s[l] * step_c + c[l] * step_s;
+            c[l] = c[l] * step_c - s[l] * step_s;
+            s[l] = t;
+        }
+    }
+    // One Newton step towards s^2 + c^2 = 1 keeps the amplitude from drifting
+    for (int l = 0; l < FIR_ROTOR_LANES; l++) {
+        double g = 1.5 - 0.5 * (s[l] * s[l] + c[l] * c[l]);
+        r->s[l] = s[l] * g;
+        r->c[l] = c[l] * g;
+    }
+    memcpy(out, tile, len * sizeof(float));
+}
+
+// Contribution of one cutoff edge (relative to Nyquist) to taps
+// start..start+len-1. A band [left, right] contributes
+// right * sinc(right * m) - left * sinc(left * m), i.e.
+// (sin(pi * right * m) - sin(pi * left * m)) / (pi * m), and the band width
+// at m = 0; sign is +1 for right edges and -1 for left edges. The sines come
+// from rotor (positioned at start) if given, otherwise from fir_sinpi.
+static void edge_contribution(float edge, float sign, int start, int len, float alpha,
+                              struct sinc_rotor* rotor, const float* inv, int center, float* c) {
+    if (rotor) {
+        rotor_next(rotor, len, c);
+    } else {
+        float arg[FIR_TILE];
+        for (int j = 0; j < len; j++) {
+            arg[j] = edge * (start + j - alpha);
+        }
+        fir_sinpi(arg, c, len);
+    }
+    for (int j = 0; j < len; j++) {
+        c[j] = sign * c[j] * inv[j];
+    }
+    if (center >= 0) {
+        c[center] = sign * edge;
+    }
+}
+
+// Frequency (relative to Nyquist) at which the gain is normalized to 1: the
+// middle of the first passband
+static float scale_frequency(const float* cutoffs, float nyquist) {
+    if (cutoffs[0] == 0.0f) {
+        return 0.0f;
+    }
+    if (cutoffs[1] == nyquist) {
+        return 1.0f;
+    }
+    return 0.5f * (cutoffs[0] + cutoffs[1]) / nyquist;
+}
+
+// Add the response at scale_freq of taps start..start+len-1 to *gain. With
+// mirror set, the taps stand for themselves and their mirror images
+// numtaps-1-n as well.
+static void gain_contribution(const float* t, int start, int len, int numtaps, float scale_freq,
+                              int mirror, double* gain) {
+    float alpha = 0.5f * (numtaps - 1);
+    float arg[FIR_TILE];
+    float c[FIR_TILE];
+    for (int j = 0; j < len; j++) {
+        arg[j] = (start + j - alpha) * scale_freq;
+    }
+    fir_cospi(arg, c, len);
+
+    double sum = 0.0;
+    for (int j = 0; j < len; j++) {
+        int twice = mirror && numtaps - 1 - (start + j) != start + j;
+        sum += (twice ? 2.0 : 1.0) * t[j] * c[j];
+    }
+    *gain += sum;
+}
+
+// Scale taps in place to unity gain
+static void scale_taps(float* taps, int numtaps, double gain) {
+    // Avoid division by zero
+    if (fabs(gain) < 1e-10) {
+        gain = 1.0;
+    }
+    float scale = (float)(1.0 / gain);
+    for (int n = 0; n < numtaps; n++) {
+        taps[n] *= scale;
+    }
+}
+
+// Scale windowed coefficients to unity gain in the middle of the first
+// passband and write them to out
+static void normalize_taps(const float* h, int numtaps, const float* cutoffs, float nyquist,
+                           float* out) {
+    float scale_freq = scale_frequency(cutoffs, nyquist);
+    double gain = 0.0;
+    for (int start = 0; start < numtaps; start += FIR_TILE) {
+        int len = numtaps - start < FIR_TILE ? numtaps - start : FIR_TILE;
+        gain_contribution(h + start, start, len, numtaps, scale_freq, 0, &gain);
+    }
+    memcpy(out, h, numtaps * sizeof(float));
+    scale_taps(out, numtaps, gain);
+}
+
+// Window the ideal response h of taps start..start+len-1 (first half), write
+// the taps and their mirror images to out and add them to the gain
+static void finish_tile(float* h, const float* w, int start, int len, int numtaps,
+                        float scale_freq, float* out, double* gain) {
+    for (int j = 0; j < len; j++) {
+        h[j] *= w[j];
+        out[start + j] = h[j];
+        out[numtaps - 1 - start - j] = h[j];
+    }
+    gain_contribution(h, start, len, numtaps, scale_freq, 1, gain);
+}
+
+// Create a FIR filter using the window method. The taps are symmetric, so
+// only the first half is computed; each tile of it is summed over the
+// cutoffs, windowed, written to out with its mirror image and added to the
+// gain in one pass, and the final scaling is one multiply per tap.
+int firwin(int numtaps, int cutoff_count, const float* cutoffs, float fs, 
+           enum fir_filter_window_type window, float* out) {
+    // Validate inputs
+    if (!out || validate_cutoffs(numtaps, cutoff_count, cutoffs, fs) != 0) {
         return -1;
     }
     
-    // Compute the ideal filter response
+    float nyquist = fs / 2.0f;
     float alpha = 0.5f * (numtaps - 1);
+    float scale_freq = scale_frequency(cutoffs, nyquist);
+    int half = (numtaps + 1) / 2;
+
+    // One sine generator per cutoff for large designs
+    struct sinc_rotor* rotors = NULL;
+    if (numtaps >= FIR_ROTOR_MIN_TAPS) {
+        rotors = (struct sinc_rotor*)malloc(cutoff_count * sizeof(struct sinc_rotor));
+        if (!rotors) {
+            return -1;
+        }
+        for (int i = 0; i < cutoff_count; i++) {
+            rotor_init(&rotors[i], cutoffs[i] / nyquist, alpha);
+        }
+    }
     
     // Process each pair of cutoffs as a passband
-    for (int i = 0; i < cutoff_count; i += 2) {
-        float left = cutoffs[i] / nyquist;
-        float right = cutoffs[i+1] / nyquist;
-        
-        for (int n = 0; n < numtaps; n++) {
-            float m = n - alpha;
-            h[n] += right * sinc(right * m) - left * sinc(left * m);
+    float inv[FIR_TILE];
+    float c[FIR_TILE];
+    float h[FIR_TILE];
+    float w[FIR_TILE];
+    double gain = 0.0;
+    for (int start = 0; start < half; start += FIR_TILE) {
+        int len = half - start < FIR_TILE ? half - start : FIR_TILE;
+        int center = tile_reciprocals(start, len, alpha, inv);
+
+        memset(h, 0, len * sizeof(float));
+        for (int i = 0; i < cutoff_count; i++) {
+            float edge = cutoffs[i] / nyquist;
+            if (edge == 0.0f) {
+                continue;
+            }
+            edge_contribution(edge, (i % 2) ? 1.0f : -1.0f, start, len, alpha,
+                              rotors ? &rotors[i] : NULL, inv, center, c);
+            for (int j = 0; j < len; j++) {
+                h[j] += c[j];
+            }
         }
+
+        // Unknown window types get no window (all ones)
+        window_values(window, numtaps, start, len, w);
+        finish_tile(h, w, start, len, numtaps, scale_freq, out, &gain);
     }
+    scale_taps(out, numtaps, gain);
     
-    // Apply the window
-    apply_window(h, numtaps, window);
-    
-    // Normalize the filter coefficients
-    // Find the frequency at which to normalize (middle of first passband)
-    float scale_freq;
-    if (cutoffs[0] == 0.0f) {
-        scale_freq = 0.0f;
-    } else if (cutoffs[1] == nyquist) {
-        scale_freq = 1.0f;
-    } else {
-        scale_freq = 0.5f * (cutoffs[0] + cutoffs[1]) / nyquist;
+    free(rotors);
+    return 0;
+}
+
+struct firwin_design {
+    int numtaps;
+    int cutoff_count;
+    float fs;
+    float alpha;
+    int half;           // Taps in the first half; the rest mirror them
+    float* cutoffs;
+    float* inv;         // 1 / (pi * m) for each tap of the first half, 0 at the center
+    float* window;      // Window values of the first half
+    float* contrib;     // Contribution of each cutoff edge, cutoff_count rows of half
+    float* taps;        // Current design
+};
+
+// Recompute the contribution of cutoff edge i
+static void design_update_edge(struct firwin_design* d, int i) {
+    float edge = d->cutoffs[i] / (d->fs / 2.0f);
+    float sign = (i % 2) ? 1.0f : -1.0f;
+    float* row = d->contrib + (size_t)i * d->half;
+    struct sinc_rotor rotor;
+    if (d->numtaps >= FIR_ROTOR_MIN_TAPS) {
+        rotor_init(&rotor, edge, d->alpha);
     }
-    
-    // Calculate the scaling factor
-    float scale = 0.0f;
-    for (int n = 0; n < numtaps; n++) {
-        float m = n - alpha;
-        scale += h[n] * cosf(M_PI * m * scale_freq);
+
+    for (int start = 0; start < d->half; start += FIR_TILE) {
+        int len = d->half - start < FIR_TILE ? d->half - start : FIR_TILE;
+        if (edge == 0.0f) {
+            memset(row + start, 0, len * sizeof(float));
+            continue;
+        }
+        int center = -1;
+        if (d->alpha >= start && d->alpha < start + len && d->alpha == (int)d->alpha) {
+            center = (int)d->alpha - start;
+        }
+        edge_contribution(edge, sign, start, len, d->alpha,
+                          d->numtaps >= FIR_ROTOR_MIN_TAPS ? &rotor : NULL, d->inv + start,
+                          center, row + start);
     }
-    
-    // Avoid division by zero
-    if (fabsf(scale) < 1e-10f) {
-        scale = 1.0f;
+}
+
+// Sum the edge contributions, apply the window and normalize, tile by tile
+// in the same order as firwin
+static void design_finish(struct firwin_design* d) {
+    float scale_freq = scale_frequency(d->cutoffs, d->fs / 2.0f);
+    float h[FIR_TILE];
+    double gain = 0.0;
+
+    for (int start = 0; start < d->half; start += FIR_TILE) {
+        int len = d->half - start < FIR_TILE ? d->half - start : FIR_TILE;
+        memset(h, 0, len * sizeof(float));
+        for (int i = 0; i < d->cutoff_count; i++) {
+            const float* row = d->contrib + (size_t)i * d->half + start;
+            for (int j = 0; j < len; j++) {
+                h[j] += row[j];
+            }
+        }
+        finish_tile(h, d->window + start, start, len, d->numtaps, scale_freq, d->taps, &gain);
     }
-    
-    // Apply scaling and copy to output
-    for (int n = 0; n < numtaps; n++) {
-        out[n] = h[n] / scale;
+    scale_taps(d->taps, d->numtaps, gain);
+}
+
+struct firwin_design* firwin_design_create(int numtaps, int cutoff_count, const float* cutoffs,
+                                           float fs, enum fir_filter_window_type window) {
+    if (validate_cutoffs(numtaps, cutoff_count, cutoffs, fs) != 0) {
+        return NULL;
+    }
+
+    struct firwin_design* d = (struct firwin_design*)calloc(1, sizeof(struct firwin_design));
+    if (!d) {
+        return NULL;
+    }
+
+    d->numtaps = numtaps;
+    d->cutoff_count = cutoff_count;
+    d->fs = fs;
+    d->alpha = 0.5f * (numtaps - 1);
+    d->half = (numtaps + 1) / 2;
+    d->cutoffs = (float*)malloc(cutoff_count * sizeof(float));
+    d->inv = (float*)malloc(d->half * sizeof(float));
+    d->window = (float*)malloc(d->half * sizeof(float));
+    d->contrib = (float*)malloc((size_t)cutoff_count * d->half * sizeof(float));
+    d->taps = (float*)malloc(numtaps * sizeof(float));
+    if (!d->cutoffs || !d->inv || !d->window || !d->contrib || !d->taps) {
+        firwin_design_destroy(d);
+        return NULL;
+    }
+
+    // Unknown window types design without a window, as firwin does
+    for (int start = 0; start < d->half; start += FIR_TILE) {
+        int len = d->half - start < FIR_TILE ? d->half - start : FIR_TILE;
+        window_values(window, numtaps, start, len, d->window + start);
+        tile_reciprocals(start, len, d->alpha, d->inv + start);
+    }
+
+    memcpy(d->cutoffs, cutoffs, cutoff_count * sizeof(float));
+    for (int i = 0; i < cutoff_count; i++) {
+        design_update_edge(d, i);
+    }
+    design_finish(d);
+    return d;
+}
+
+void firwin_design_destroy(struct firwin_design* design) {
+    if (!design) return;
+    free(design->cutoffs);
+    free(design->inv);
+    free(design->window);
+    free(design->contrib);
+    free(design->taps);
+    free(design);
+}
+
+int firwin_design_set_cutoffs(struct firwin_design* design, const float* cutoffs) {
+    if (!design || validate_cutoffs(design->numtaps, design->cutoff_count, cutoffs,
+                                    design->fs) != 0) {
+        return -1;
+    }
+
+    int changed = 0;
+    for (int i = 0; i < design->cutoff_count; i++) {
+        if (cutoffs[i] != design->cutoffs[i]) {
+            design->cutoffs[i] = cutoffs[i];
+            design_update_edge(design, i);
+            changed = 1;
+        }
+    }
+    if (changed) {
+        design_finish(design);
+    }
+    return 0;
+}
+
+int firwin_design_set_cutoff(struct firwin_design* design, int index, float cutoff) {
+    if (!design || index < 0 || index >= design->cutoff_count) {
+        return -1;
+    }
+
+    // Validate the full set with the new value before touching the design
+    float saved = design->cutoffs[index];
+    design->cutoffs[index] = cutoff;
+    int valid = validate_cutoffs(design->numtaps, design->cutoff_count, design->cutoffs,
+                                 design->fs) == 0;
+    design->cutoffs[index] = saved;
+    if (!valid) {
+        return -1;
+    }
+
+    if (cutoff != saved) {
+        design->cutoffs[index] = cutoff;
+        design_update_edge(design, index);
+        design_finish(design);
     }
-    
-    free(h);
     return 0;
 }
+
+int firwin_design_taps(const struct firwin_design* design, float* out) {
+    if (!design || !out) {
+        return -1;
+    }
+    memcpy(out, design->taps, design->numtaps * sizeof(float));
+    return 0;
+}
+
+// Width of the Gaussian that smooths the band edges in firwin_fft, times
+// numtaps, in cycles per sample. With an FFT of at least 1.5 * numtaps the
+// aliased copies are below 1e-12 relative; wider would divide by smaller
+// values at the ends of the filter.
+#define FIR_FFT_SIGMA 1.4
+
+// The smoothed edges are evaluated this many standard deviations out; the
+// rest of the Gaussian is below double rounding
+#define FIR_FFT_REACH 7.5
+
+// Shorter designs are left to firwin: the smoothing would span most of the
+// spectrum, and the direct sum is cheap anyway
+#define FIR_FFT_MIN_TAPS 64
+
+// Twiddle factors are recomputed exactly every this many bins
+#define FIR_FFT_RESEED 256
+
+// Standard normal cumulative distribution function
+static double normal_cdf(double x) {
+    return 0.5 * erfc(-x * M_SQRT1_2);
+}
+
+// Add bins first..last of the smoothed response (center[k] is bin k) to the
+// spectrum at k + shift, with the linear phase of a delay of
+// alpha = (numtaps - 1) / 2 samples: exp(-2 pi i k alpha / fft_len), i.e.
+// k * (numtaps - 1) / fft_len half-turns. The phase is rotated from bin to
+// bin and reduced exactly in integers every FIR_FFT_RESEED bins.
+static void fold_bins(const double* center, int first, int last, int shift, int numtaps,
+                      int fft_len, double* re, double* im) {
+    double step_c = cos(M_PI * (numtaps - 1) / fft_len);
+    double step_s = -sin(M_PI * (numtaps - 1) / fft_len);
+
+    for (int start = first; start <= last; start += FIR_FFT_RESEED) {
+        int end = last - start < FIR_FFT_RESEED ? last : start + FIR_FFT_RESEED - 1;
+        long long turns = ((long long)start * (numtaps - 1)) % (2LL * fft_len);
+        double wc = cos(M_PI * (double)turns / fft_len);
+        double ws = -sin(M_PI * (double)turns / fft_len);
+
+        for (int k = start; k <= end; k++) {
+            re[k + shift] += center[k] * wc;
+            im[k + shift] += center[k] * ws;
+            double t = wc * step_c - ws * step_s;
+            ws = wc * step_s + ws * step_c;
+            wc = t;
+        }
+    }
+}
+
+// Create a FIR filter using the window method, with the ideal response
+// obtained by one inverse FFT instead of a sum of sincs.
+//
+// The ideal multiband response (edges at +-cutoff) is smoothed by a narrow
+// Gaussian, which has a closed form (normal_cdf steps), and sampled on a grid
+// of fft_len >= 1.5 * numtaps bins. The inverse DFT of those samples is, by
+// Poisson summation, the ideal impulse response times the Gaussian's
+// transform exp(-2 pi^2 sigma^2 t^2), plus copies shifted by multiples of
+// fft_len that the transform has decayed to nothing. Dividing the Gaussian
+// back out leaves the ideal response at every tap.
+int firwin_fft(int numtaps, int cutoff_count, const float* cutoffs, float fs,
+               enum fir_filter_window_type window, float* out) {
+    // Validate inputs
+    if (!out || validate_cutoffs(numtaps, cutoff_count, cutoffs, fs) != 0) {
+        return -1;
+    }
+    if (numtaps < FIR_FFT_MIN_TAPS) {
+        return firwin(numtaps, cutoff_count, cutoffs, fs, window, out);
+    }
+
+    int fft_len = 64;
+    while (fft_len < numtaps + numtaps / 2 + 1) {
+        fft_len *= 2;
+    }
+    double sigma = FIR_FFT_SIGMA / numtaps * fft_len;    // In bins
+    int reach = (int)ceil(FIR_FFT_REACH * sigma);
+    int max_bin = fft_len / 2 + reach + 1;                 // Bins -max_bin..max_bin
+    int bins = 2 * max_bin + 1;
+
+    // The response is real, so only bins 0..fft_len/2 of the spectrum are kept
+    double* re = (double*)calloc(fft_len / 2 + 1, sizeof(double));
+    double* im = (double*)calloc(fft_len / 2 + 1, sizeof(double));
+    double* grid = (double*)calloc(bins, sizeof(double));
+    double* y = (double*)malloc(fft_len * sizeof(double));
+    float* h = (float*)malloc(numtaps * sizeof(float));
+    if (!re || !im || !grid || !y || !h) {
+        free(re);
+        free(im);
+        free(grid);
+        free(y);
+        free(h);
+        return -1;
+    }
+
+    // Each cutoff gives a rising (left) or falling (right) edge at +cutoff
+    // and the mirrored edge at -cutoff; Nyquist is bin fft_len / 2. First
+    // the sharp response: a step at the first bin at or after each edge.
+    float nyquist = fs / 2.0f;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int side = -1; side <= 1; side += 2) {
+            for (int i = 0; i < cutoff_count; i++) {
+                double pos = side * (double)cutoffs[i] / nyquist * (fft_len / 2);
+                double sign = ((i % 2) ? -1.0 : 1.0) * side;
+                int first = (int)ceil(pos);
+                if (pass == 0) {
+                    grid[first + max_bin] += sign;
+                    continue;
+                }
+
+                // Then replace the step by the smoothed one near the edge
+                int lo = first - reach < -max_bin ? -max_bin : first - reach;
+                int hi = first + reach > max_bin ? max_bin : first + reach;
+                for (int k = lo; k <= hi; k++) {
+                    grid[k + max_bin] += sign * (normal_cdf((k - pos) / sigma) - (k >= first));
+                }
+            }
+        }
+        for (int k = 1; pass == 0 && k < bins; k++) {
+            grid[k] += grid[k - 1];
+        }
+    }
+
+    // Bins -max_bin..-fft_len/2 alias onto fft_len/2 and below; the other
+    // bins above fft_len/2 are the conjugate half of the spectrum
+    const double* center = grid + max_bin;
+    fold_bins(center, -max_bin, -fft_len / 2, fft_len, numtaps, fft_len, re, im);
+    fold_bins(center, 0, fft_len / 2, 0, numtaps, fft_len, re, im);
+
+    int result = fir_fft_real_inverse(re, im, fft_len, y);
+
+    // Divide out the Gaussian's transform
+    double alpha = 0.5 * (numtaps - 1);
+    double decay = 2.0 * M_PI * M_PI * (sigma / fft_len) * (sigma / fft_len);
+    for (int n = 0; result == 0 && n <= (numtaps - 1) / 2; n++) {
+        double m = n - alpha;
+        double scale = exp(decay * m * m) / fft_len;
+        h[n] = (float)(y[n] * scale);
+        h[numtaps - 1 - n] = (float)(y[numtaps - 1 - n] * scale);
+    }
+
+    // Apply the window and normalize, as firwin does
+    if (result == 0) {
+        result = fir_window_apply(window, numtaps, h);
+    }
+    if (result == 0) {
+        normalize_taps(h, numtaps, cutoffs, nyquist, out);
+    }
+
+    free(re);
+    free(im);
+    free(grid);
+    free(y);
+    free(h);
+    return result;
+}
+
+// Create a FIR filter with an arbitrary frequency response using the
+// frequency sampling method
+int firwin2(int numtaps, int count, const float* freq, const float* gain, float fs,
+            enum fir_filter_window_type window, float* out) {
+    // Validate inputs
+    if (numtaps <= 0 || count < 2 || !freq || !gain || !out || fs <= 0.0f) {
+        return -1;
+    }
+
+    // The response must be given from 0 to Nyquist with non-decreasing
+    // frequencies; neither end may be a step
+    float nyquist = fs / 2.0f;
+    if (freq[0] != 0.0f || freq[count-1] != nyquist) {
+        return -1;
+    }
+    if (freq[1] == 0.0f || freq[count-2] == nyquist) {
+        return -1;
+    }
+    for (int i = 1; i < count; i++) {
+        if (freq[i] < freq[i-1]) {
+            return -1;
+        }
+        // A step is one repeated frequency, as in scipy
+        if (i >= 2 && freq[i] == freq[i-1] && freq[i-1] == freq[i-2]) {
+            return -1;
+        }
+    }
+
+    // Even number of taps can't have response at Nyquist
+    if (numtaps % 2 == 0 && gain[count-1] != 0.0f) {
+        return -1;
+    }
+
+    // Sample the response on a uniform grid, as scipy does by default
+    int nfreqs = 2;
+    while (nfreqs - 1 < numtaps) {
+        nfreqs = 2 * (nfreqs - 1) + 1;
+    }
+    double* grid = (double*)malloc(nfreqs * sizeof(double));
+    if (!grid) {
+        return -1;
+    }
+
+    int seg = 0;
+    for (int k = 0; k < nfreqs; k++) {
+        double f = (double)nyquist * k / (nfreqs - 1);
+        while (seg < count - 2 && f >= freq[seg+1]) {
+            seg++;
+        }
+        double f0 = freq[seg];
+        double f1 = freq[seg+1];
+        // A grid point on a step takes the mean of the gains on either
+        // side, as scipy does
+        if (seg > 0 && f == f0 && freq[seg-1] == f0) {
+            grid[k] = 0.5 * ((double)gain[seg-1] + gain[seg]);
+        } else {
+            double t = (f - f0) / (f1 - f0);
+            if (t > 1.0) t = 1.0;
+            grid[k] = gain[seg] + t * (gain[seg+1] - gain[seg]);
+        }
+    }
+
+    // Inverse real DFT of the grid with a linear phase shift of (numtaps-1)/2
+    // samples; only the first numtaps points of the result are needed. With
+    // m = n - (numtaps-1)/2 the phase of bin k is 2 pi k m / fft_len, i.e.
+    // k * (2m) / fft_len half-turns, which is reduced exactly in integers.
+    long long fft_len = 2 * (nfreqs - 1);
+    float arg[FIR_TILE];
+    float c[FIR_TILE];
+    for (int n = 0; n < numtaps; n++) {
+        long long m2 = 2LL * n - (numtaps - 1);
+        double nyq_sign = (m2 % 2) ? 0.0 : ((m2 / 2) % 2 ? -1.0 : 1.0);
+        double acc = grid[0] + grid[nfreqs-1] * nyq_sign;
+        for (int start = 1; start < nfreqs - 1; start += FIR_TILE) {
+            int len = nfreqs - 1 - start < FIR_TILE ? nfreqs - 1 - start : FIR_TILE;
+            for (int j = 0; j < len; j++) {
+                long long phase = ((start + j) * m2) % (2 * fft_len);
+                arg[j] = (float)phase / (float)fft_len;
+            }
+            fir_cospi(arg, c, len);
+            for (int j = 0; j < len; j++) {
+                acc += 2.0 * grid[start + j] * c[j];
+            }
+        }
+        out[n] = (float)(acc / fft_len);
+    }
+
+    free(grid);
+
+    return fir_window_apply(window, numtaps, out);
+}
+
+// Create a Hilbert transformer by windowing the ideal response
+// h[m] = 2 / (pi * m) for odd m and 0 for even m, m = n - (numtaps-1)/2
+int firhilbert(int numtaps, enum fir_filter_window_type window, float* out) {
+    // Validate inputs
+    if (numtaps < 3 || numtaps % 2 == 0 || !out) {
+        return -1;
+    }
+
+    int center = (numtaps - 1) / 2;
+    for (int m = 0; m <= center; m++) {
+        if (m % 2) {
+            float h = 2.0f / ((float)M_PI * m);
+            out[center + m] = h;
+            out[center - m] = -h;
+        } else {
+            out[center + m] = 0.0f;
+            out[center - m] = 0.0f;
+        }
+    }
+
+    return fir_window_apply(window, numtaps, out);
+}
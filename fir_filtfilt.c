@@ -0,0 +1,182 @@
+#include "fir_filtfilt.h"
+#include "fir_alloc.h"
+#include "fir_kernel.h"
+#include "fir_pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Segments shorter than this are not worth a worker of their own
+#define FIR_FILTFILT_MIN_SEGMENT 16384
+
+// One segment of a filtering pass
+struct filtfilt_segment {
+    const float* rtaps;
+    int numtaps;
+    const float* x;     // Input including numtaps - 1 samples of history
+    float* y;           // Output
+    int start;          // First output index
+    int count;          // Number of outputs
+    int reverse_len;    // If nonzero, y[reverse_len - 1 - i] receives output i
+};
+
+static void filter_segment(const struct filtfilt_segment* seg) {
+    // The same kernel choice as fir_stream; each output is computed the same
+    // way wherever a segment boundary falls
+    void (*kernel)(const float*, int, const float*, float*, int) =
+        seg->numtaps >= FIR_KERNEL_BLOCKED_MIN_TAPS && seg->numtaps <= FIR_KERNEL_BLOCKED_MAX_TAPS
+        ? fir_kernel_blocked : fir_kernel_direct;
+
+    // Filter in small pieces so reversed output can be staged on the stack
+    float tmp[256];
+    for (int done = 0; done < seg->count; done += 256) {
+        int i0 = seg->start + done;
+        int len = seg->count - done < 256 ? seg->count - done : 256;
+
+        if (!seg->reverse_len) {
+            kernel(seg->rtaps, seg->numtaps, seg->x + i0, seg->y + i0, len);
+            continue;
+        }
+
+        kernel(seg->rtaps, seg->numtaps, seg->x + i0, tmp, len);
+        for (int i = 0; i < len; i++) {
+            seg->y[seg->reverse_len - 1 - (i0 + i)] = tmp[i];
+        }
+    }
+}
+
+// Workers shared by all calls: created on first use and replaced by a larger
+// pool when a call asks for more threads. One call uses them at a time.
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct fir_pool* pool;
+static int pool_size;
+static int pool_teardown_registered;
+
+// Stop the shared workers at exit, after any call still using them
+static void pool_teardown(void) {
+    pthread_mutex_lock(&pool_lock);
+    fir_pool_destroy(pool);
+    pool = NULL;
+    pool_size = 0;
+    pthread_mutex_unlock(&pool_lock);
+}
+
+struct filtfilt_job {
+    const struct filtfilt_segment* seg;
+    int count;
+};
+
+static void filter_segment_worker(void* arg, int worker) {
+    const struct filtfilt_job* job = (const struct filtfilt_job*)arg;
+    if (worker < job->count) {
+        filter_segment(&job->seg[worker]);
+    }
+}
+
+// Compute outputs [start, start + count) of one pass, split across the
+// shared workers
+static void filter_pass(struct filtfilt_segment proto, int nthreads) {
+    int max_threads = proto.count / FIR_FILTFILT_MIN_SEGMENT;
+    if (nthreads > max_threads) nthreads = max_threads;
+
+    // Short passes, and passes of calls that find the workers busy or cannot
+    // create them, run on the calling thread
+    if (nthreads < 2 || pthread_mutex_trylock(&pool_lock) != 0) {
+        filter_segment(&proto);
+        return;
+    }
+    if (!pool_teardown_registered) {
+        pool_teardown_registered = atexit(pool_teardown) == 0;
+    }
+    if (pool_size < nthreads) {
+        fir_pool_destroy(pool);
+        pool = fir_pool_create(nthreads, NULL);
+        pool_size = pool ? nthreads : 0;
+    }
+    if (!pool) {
+        pthread_mutex_unlock(&pool_lock);
+        filter_segment(&proto);
+        return;
+    }
+
+    struct filtfilt_segment seg[nthreads];
+    int first = proto.start;
+    for (int t = 0; t < nthreads; t++) {
+        int end = proto.start + (int)((long long)proto.count * (t + 1) / nthreads);
+        seg[t] = proto;
+        seg[t].start = first;
+        seg[t].count = end - first;
+        first = end;
+    }
+
+    struct filtfilt_job job = { seg, nthreads };
+    fir_pool_run(pool, filter_segment_worker, &job);
+    pthread_mutex_unlock(&pool_lock);
+}
+
+int fir_filtfilt(const float* taps, int numtaps, const float* in, float* out, int n,
+                 int nthreads) {
+    if (!taps || numtaps <= 0 || !in || !out) {
+        return -1;
+    }
+
+    const int padlen = 3 * numtaps;
+    if (n <= padlen) {
+        return -1;
+    }
+
+    if (nthreads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = cpus > 0 ? (int)cpus : 1;
+    }
+
+    const int hist = numtaps - 1;
+    const int len = n + 2 * padlen;
+
+    float* rtaps = (float*)fir_alloc(numtaps * sizeof(float), "fir_filtfilt.taps");
+    float* fwd = (float*)fir_alloc((size_t)(hist + len) * sizeof(float), "fir_filtfilt.fwd");
+    float* bwd = (float*)fir_alloc((size_t)(hist + len) * sizeof(float), "fir_filtfilt.bwd");
+    if (!rtaps || !fwd || !bwd) {
+        fir_free(rtaps);
+        fir_free(fwd);
+        fir_free(bwd);
+        return -1;
+    }
+
+    for (int k = 0; k < numtaps; k++) {
+        rtaps[k] = taps[numtaps - 1 - k];
+    }
+
+    // Odd extension at both ends
+    float* ext = fwd + hist;
+    for (int i = 0; i < n; i++) {
+        ext[padlen + i] = in[i];
+    }
+    for (int j = 1; j <= padlen; j++) {
+        ext[padlen - j] = 2.0f * in[0] - in[j];
+        ext[padlen + n - 1 + j] = 2.0f * in[n - 1] - in[n - 1 - j];
+    }
+
+    // Steady-state initial conditions: the signal is held at its first value
+    for (int k = 0; k < hist; k++) {
+        fwd[k] = ext[0];
+    }
+
+    // Forward pass, written time-reversed into the backward pass input
+    struct filtfilt_segment pass = { rtaps, numtaps, fwd, bwd + hist, 0, len, len };
+    filter_pass(pass, nthreads);
+
+    for (int k = 0; k < hist; k++) {
+        bwd[k] = bwd[hist];
+    }
+
+    // Backward pass; only the outputs that land inside the original signal
+    // are computed, and reversing them back puts them in place
+    struct filtfilt_segment back = { rtaps, numtaps, bwd, out, padlen, n, len - padlen };
+    filter_pass(back, nthreads);
+
+    fir_free(rtaps);
+    fir_free(fwd);
+    fir_free(bwd);
+    return 0;
+}
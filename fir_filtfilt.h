@@ -0,0 +1,27 @@
+#ifndef FIR_FILTFILT_H
+#define FIR_FILTFILT_H
+
+/**
+ * @brief Zero-phase forward-backward filtering, like scipy.signal.filtfilt.
+ *
+ * The signal is extended at both ends by 3 * numtaps samples of odd
+ * reflection and filtered forward and then backward, with the filter state
+ * initialized to the steady state of the first sample (as scipy does with
+ * lfilter_zi). Each pass is split into segments that are filtered in
+ * parallel on worker threads kept for the life of the process (created on
+ * the first call that needs them); the result does not depend on the number
+ * of threads. Signals too short to split, and calls made while another call
+ * is using the workers, are filtered on the calling thread.
+ *
+ * @param taps Filter coefficients, e.g. designed with firwin()
+ * @param numtaps Number of taps
+ * @param in Input samples
+ * @param out Output samples (may be the same buffer as in)
+ * @param n Number of samples (must be greater than 3 * numtaps)
+ * @param nthreads Number of threads to use, or 0 to use one per online CPU
+ * @return 0 on success, -1 on error
+ */
+int fir_filtfilt(const float* taps, int numtaps, const float* in, float* out, int n,
+                 int nthreads);
+
+#endif
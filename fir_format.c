@@ -0,0 +1,236 @@
+#include "fir_format.h"
+#include "fir_cpu.h"
+#include <math.h>
+#include <string.h>
+
+#define SCALE_S16 32768.0f
+#define SCALE_S24 8388608.0f
+#define SCALE_S32 2147483648.0f
+
+int fir_format_size(enum fir_sample_format format) {
+    switch (format) {
+        case FIR_FORMAT_F32: return 4;
+        case FIR_FORMAT_S16: return 2;
+        case FIR_FORMAT_S24: return 3;
+        case FIR_FORMAT_S32: return 4;
+        default:             return -1;
+    }
+}
+
+void fir_dither_init(struct fir_dither* dither, uint32_t seed) {
+    if (!dither) return;
+    for (int i = 0; i < FIR_DITHER_LANES; i++) {
+        // xorshift32 must not start at 0
+        uint32_t s = seed * 2654435761u + (uint32_t)i * 40503u + 1u;
+        dither->state[i] = s ? s : 1u;
+    }
+}
+
+// The two 16-bit halves of a xorshift32 output are two uniform variables;
+// their difference is triangular in (-1, 1)
+static inline float dither_next(uint32_t* s) {
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *s = x;
+    return (float)((int32_t)(x >> 16) - (int32_t)(x & 0xFFFF)) * (1.0f / 65536.0f);
+}
+
+static inline int32_t to_int(float v, float lo, float hi) {
+    v = rintf(v);
+    if (v < lo) v = lo;
+    if (v > hi) return (int32_t)hi;
+    return (int32_t)v;
+}
+
+static void to_float_scalar(const unsigned char* in, enum fir_sample_format format, int stride,
+                            float* out, int n) {
+    const int step = fir_format_size(format) * stride;
+    switch (format) {
+        case FIR_FORMAT_F32:
+            for (int i = 0; i < n; i++) {
+                memcpy(&out[i], in + (size_t)i * step, sizeof(float));
+            }
+            break;
+        case FIR_FORMAT_S16:
+            for (int i = 0; i < n; i++) {
+                int16_t v;
+                memcpy(&v, in + (size_t)i * step, sizeof(v));
+                out[i] = v * (1.0f / SCALE_S16);
+            }
+            break;
+        case FIR_FORMAT_S24:
+            for (int i = 0; i < n; i++) {
+                const unsigned char* p = in + (size_t)i * step;
+                int32_t v = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+                out[i] = v * (1.0f / SCALE_S24);
+            }
+            break;
+        case FIR_FORMAT_S32:
+            for (int i = 0; i < n; i++) {
+                int32_t v;
+                memcpy(&v, in + (size_t)i * step, sizeof(v));
+                out[i] = (float)v * (1.0f / SCALE_S32);
+            }
+            break;
+    }
+}
+
+// Dither lanes are assigned by position (lane i % 8), the same as in the
+// vector versions, so both produce the same output
+static void from_float_scalar(const float* in, unsigned char* out, enum fir_sample_format format,
+                              int stride, int n, struct fir_dither* dither) {
+    const int step = fir_format_size(format) * stride;
+    for (int i = 0; i < n; i++) {
+        unsigned char* p = out + (size_t)i * step;
+        float d = (dither && format != FIR_FORMAT_F32)
+                  ? dither_next(&dither->state[i % FIR_DITHER_LANES]) : 0.0f;
+        switch (format) {
+            case FIR_FORMAT_F32:
+                memcpy(p, &in[i], sizeof(float));
+                break;
+            case FIR_FORMAT_S16: {
+                int16_t v = (int16_t)to_int(in[i] * SCALE_S16 + d, -32768.0f, 32767.0f);
+                memcpy(p, &v, sizeof(v));
+                break;
+            }
+            case FIR_FORMAT_S24: {
+                int32_t v = to_int(in[i] * SCALE_S24 + d, -8388608.0f, 8388607.0f);
+                p[0] = (unsigned char)v;
+                p[1] = (unsigned char)(v >> 8);
+                p[2] = (unsigned char)(v >> 16);
+                break;
+            }
+            case FIR_FORMAT_S32: {
+                // 2^31 - 1 is not a float, so the upper limit is checked before converting
+                float v = rintf(in[i] * SCALE_S32 + d);
+                int32_t s = v >= SCALE_S32 ? INT32_MAX : v < -SCALE_S32 ? INT32_MIN : (int32_t)v;
+                memcpy(p, &s, sizeof(s));
+                break;
+            }
+        }
+    }
+}
+
+#if FIR_X86
+__attribute__((target("avx2,fma")))
+static void to_float_avx2(const unsigned char* in, enum fir_sample_format format, float* out, int n) {
+    int i = 0;
+    if (format == FIR_FORMAT_S16) {
+        const __m256 scale = _mm256_set1_ps(1.0f / SCALE_S16);
+        for (; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(in + 2 * (size_t)i)));
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+        }
+        to_float_scalar(in + 2 * (size_t)i, format, 1, out + i, n - i);
+    } else {
+        const __m256 scale = _mm256_set1_ps(1.0f / SCALE_S32);
+        for (; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(in + 4 * (size_t)i));
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+        }
+        to_float_scalar(in + 4 * (size_t)i, format, 1, out + i, n - i);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256 dither_next_avx2(__m256i* s) {
+    __m256i x = *s;
+    x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+    x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+    *s = x;
+    __m256i d = _mm256_sub_epi32(_mm256_srli_epi32(x, 16), _mm256_and_si256(x, _mm256_set1_epi32(0xFFFF)));
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(d), _mm256_set1_ps(1.0f / 65536.0f));
+}
+
+__attribute__((target("avx2,fma")))
+static void from_float_avx2(const float* in, unsigned char* out, enum fir_sample_format format,
+                            int n, struct fir_dither* dither) {
+    __m256i state = dither ? _mm256_loadu_si256((const __m256i*)dither->state) : _mm256_setzero_si256();
+    int i = 0;
+    if (format == FIR_FORMAT_S16) {
+        const __m256 scale = _mm256_set1_ps(SCALE_S16);
+        const __m256 lo = _mm256_set1_ps(-32768.0f);
+        const __m256 hi = _mm256_set1_ps(32767.0f);
+        for (; i + 8 <= n; i += 8) {
+            __m256 v = _mm256_mul_ps(_mm256_loadu_ps(in + i), scale);
+            if (dither) {
+                v = _mm256_add_ps(v, dither_next_avx2(&state));
+            }
+            v = _mm256_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            __m256i s = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v, lo), hi));
+            __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+            _mm_storeu_si128((__m128i*)(out + 2 * (size_t)i), packed);
+        }
+    } else {
+        const __m256 scale = _mm256_set1_ps(SCALE_S32);
+        const __m256 lo = _mm256_set1_ps(-SCALE_S32);
+        for (; i + 8 <= n; i += 8) {
+            __m256 v = _mm256_mul_ps(_mm256_loadu_ps(in + i), scale);
+            if (dither) {
+                v = _mm256_add_ps(v, dither_next_avx2(&state));
+            }
+            v = _mm256_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            v = _mm256_max_ps(v, lo);
+            __m256i s = _mm256_cvtps_epi32(v);
+            __m256 over = _mm256_cmp_ps(v, scale, _CMP_GE_OQ);
+            s = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(s),
+                                                     _mm256_castsi256_ps(_mm256_set1_epi32(INT32_MAX)),
+                                                     over));
+            _mm256_storeu_si256((__m256i*)(out + 4 * (size_t)i), s);
+        }
+    }
+    if (dither) {
+        _mm256_storeu_si256((__m256i*)dither->state, state);
+    }
+    from_float_scalar(in + i, out + (size_t)fir_format_size(format) * i, format, 1, n - i, dither);
+}
+#endif
+
+// The vector versions cover contiguous s16 and s32 data
+static int use_avx2(enum fir_sample_format format, int stride) {
+#if FIR_X86
+    static int avx2 = -1;
+    int a = __atomic_load_n(&avx2, __ATOMIC_RELAXED);
+    if (a < 0) {
+        a = fir_cpu_has_avx2();
+        __atomic_store_n(&avx2, a, __ATOMIC_RELAXED);
+    }
+    return a && stride == 1 && (format == FIR_FORMAT_S16 || format == FIR_FORMAT_S32);
+#else
+    (void)format;
+    (void)stride;
+    return 0;
+#endif
+}
+
+int fir_format_to_float(const void* in, enum fir_sample_format format, int stride, float* out, int n) {
+    if (fir_format_size(format) < 0 || stride < 1 || n < 0 || (n > 0 && (!in || !out))) {
+        return -1;
+    }
+#if FIR_X86
+    if (use_avx2(format, stride)) {
+        to_float_avx2((const unsigned char*)in, format, out, n);
+        return 0;
+    }
+#endif
+    to_float_scalar((const unsigned char*)in, format, stride, out, n);
+    return 0;
+}
+
+int fir_format_from_float(const float* in, void* out, enum fir_sample_format format, int stride,
+                          int n, struct fir_dither* dither) {
+    if (fir_format_size(format) < 0 || stride < 1 || n < 0 || (n > 0 && (!in || !out))) {
+        return -1;
+    }
+#if FIR_X86
+    if (use_avx2(format, stride)) {
+        from_float_avx2(in, (unsigned char*)out, format, n, dither);
+        return 0;
+    }
+#endif
+    from_float_scalar(in, (unsigned char*)out, format, stride, n, dither);
+    return 0;
+}
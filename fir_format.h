@@ -0,0 +1,65 @@
+#ifndef FIR_FORMAT_H
+#define FIR_FORMAT_H
+
+#include <stdint.h>
+
+// Sample formats for raw and WAV audio.
+//
+// Integer samples map to floats in [-1, 1): s16 is divided by 2^15, s24 by
+// 2^23 and s32 by 2^31. Converting back rounds to the nearest integer and
+// clips. Samples are little-endian; s24 is packed in 3 bytes.
+
+enum fir_sample_format {
+    FIR_FORMAT_F32,     // 32-bit float
+    FIR_FORMAT_S16,     // 16-bit signed integer
+    FIR_FORMAT_S24,     // 24-bit signed integer, packed
+    FIR_FORMAT_S32      // 32-bit signed integer
+};
+
+// Number of independent generators in a dither state
+#define FIR_DITHER_LANES 8
+
+// State of the TPDF dither added before rounding to an integer format
+struct fir_dither {
+    uint32_t state[FIR_DITHER_LANES];
+};
+
+/**
+ * @brief Get the size of one sample in bytes.
+ *
+ * @return Sample size, or -1 for an unknown format
+ */
+int fir_format_size(enum fir_sample_format format);
+
+/**
+ * @brief Seed a dither state.
+ */
+void fir_dither_init(struct fir_dither* dither, uint32_t seed);
+
+/**
+ * @brief Convert samples to float.
+ *
+ * @param in Input samples
+ * @param format Input format
+ * @param stride Distance between consecutive input samples, in samples (e.g. the channel count for interleaved data)
+ * @param out Output floats (contiguous)
+ * @param n Number of samples
+ * @return 0 on success, -1 on error
+ */
+int fir_format_to_float(const void* in, enum fir_sample_format format, int stride, float* out, int n);
+
+/**
+ * @brief Convert floats to a sample format.
+ *
+ * @param in Input floats (contiguous)
+ * @param out Output samples
+ * @param format Output format
+ * @param stride Distance between consecutive output samples, in samples
+ * @param n Number of samples
+ * @param dither Dither state, or NULL for plain rounding. Triangular dither of +-1 LSB is added for integer formats.
+ * @return 0 on success, -1 on error
+ */
+int fir_format_from_float(const float* in, void* out, enum fir_sample_format format, int stride,
+                          int n, struct fir_dither* dither);
+
+#endif
@@ -0,0 +1,158 @@
+#include "fir_fracdelay.h"
+#include "fir_alloc.h"
+#include "fir_kernel.h"
+#include "fir_math.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Row stride granularity (floats); fir_alloc() aligns the bank to 64 bytes
+#define FIR_FRACDELAY_ROW_ALIGN 16
+
+struct fir_fracdelay {
+    int numtaps;
+    int phases;
+    int stride;     // Floats between consecutive phases
+    float* rows;    // Phases -1..phases+1, reversed taps; the outer phases
+                    // are guards for cubic interpolation
+};
+
+// Reversed taps of phase p (p = -1..phases+1)
+static const float* phase_row(const struct fir_fracdelay* bank, int p) {
+    return bank->rows + (size_t)(p + 1) * bank->stride;
+}
+
+struct fir_fracdelay* fir_fracdelay_create(int numtaps, int phases, float cutoff,
+                                           enum fir_filter_window_type window) {
+    if (numtaps <= 0 || phases < 1 || !(cutoff > 0.0f && cutoff <= 1.0f)) {
+        return NULL;
+    }
+
+    struct fir_fracdelay* bank = (struct fir_fracdelay*)calloc(1, sizeof(struct fir_fracdelay));
+    if (!bank) {
+        return NULL;
+    }
+    bank->numtaps = numtaps;
+    bank->phases = phases;
+    bank->stride = (numtaps + FIR_FRACDELAY_ROW_ALIGN - 1) / FIR_FRACDELAY_ROW_ALIGN *
+                   FIR_FRACDELAY_ROW_ALIGN;
+
+    size_t size = (size_t)(phases + 3) * bank->stride * sizeof(float);
+    bank->rows = (float*)fir_alloc(size, "fir_fracdelay.rows");
+    float* w = (float*)malloc(numtaps * sizeof(float));
+    float* h = (float*)malloc(numtaps * sizeof(float));
+    if (!bank->rows || !w || !h || fir_window(window, numtaps, w) != 0) {
+        fir_free(bank->rows);
+        free(w);
+        free(h);
+        free(bank);
+        return NULL;
+    }
+
+    // Shifted sinc: h[n] = cutoff * sinc(cutoff * (n - alpha - d)), windowed
+    // and scaled to unity gain at DC
+    float alpha = 0.5f * (numtaps - 1);
+    for (int p = -1; p <= phases + 1; p++) {
+        float d = (float)p / phases;
+        for (int n = 0; n < numtaps; n++) {
+            h[n] = cutoff * (n - alpha - d);
+        }
+        fir_sinpi(h, h, numtaps);
+
+        float sum = 0.0f;
+        for (int n = 0; n < numtaps; n++) {
+            float m = n - alpha - d;
+            h[n] = (m == 0.0f ? cutoff : h[n] / ((float)M_PI * m)) * w[n];
+            sum += h[n];
+        }
+
+        float* row = bank->rows + (size_t)(p + 1) * bank->stride;
+        for (int n = 0; n < numtaps; n++) {
+            row[numtaps - 1 - n] = h[n] / sum;
+        }
+    }
+
+    free(w);
+    free(h);
+    return bank;
+}
+
+void fir_fracdelay_destroy(struct fir_fracdelay* bank) {
+    if (!bank) return;
+    fir_free(bank->rows);
+    free(bank);
+}
+
+// Find the phases and weights interpolating the given delay. Returns the
+// number of phases used, starting at *first.
+static int interp_weights(const struct fir_fracdelay* bank, float delay,
+                          enum fir_fracdelay_interp interp, int* first, float* weight) {
+    float pos = delay * bank->phases;
+    int p = (int)floorf(pos);
+    if (p >= bank->phases) {
+        p = bank->phases - 1;
+    }
+    float f = pos - p;
+
+    if (interp == FIR_FRACDELAY_CUBIC) {
+        *first = p - 1;
+        weight[0] = -f * (f - 1.0f) * (f - 2.0f) / 6.0f;
+        weight[1] = (f + 1.0f) * (f - 1.0f) * (f - 2.0f) / 2.0f;
+        weight[2] = -(f + 1.0f) * f * (f - 2.0f) / 2.0f;
+        weight[3] = (f + 1.0f) * f * (f - 1.0f) / 6.0f;
+        return 4;
+    }
+
+    *first = p;
+    weight[0] = 1.0f - f;
+    weight[1] = f;
+    return 2;
+}
+
+static int valid_args(const struct fir_fracdelay* bank, float delay,
+                      enum fir_fracdelay_interp interp) {
+    return bank && delay >= 0.0f && delay <= 1.0f &&
+           (interp == FIR_FRACDELAY_LINEAR || interp == FIR_FRACDELAY_CUBIC);
+}
+
+int fir_fracdelay_taps(const struct fir_fracdelay* bank, float delay,
+                       enum fir_fracdelay_interp interp, float* out) {
+    if (!valid_args(bank, delay, interp) || !out) {
+        return -1;
+    }
+
+    int first;
+    float weight[4];
+    int count = interp_weights(bank, delay, interp, &first, weight);
+    const int numtaps = bank->numtaps;
+
+    for (int n = 0; n < numtaps; n++) {
+        out[n] = 0.0f;
+    }
+    for (int i = 0; i < count; i++) {
+        const float* row = phase_row(bank, first + i);
+        for (int n = 0; n < numtaps; n++) {
+            out[n] += weight[i] * row[numtaps - 1 - n];
+        }
+    }
+    return 0;
+}
+
+float fir_fracdelay_apply(const struct fir_fracdelay* bank, const float* x, float delay,
+                          enum fir_fracdelay_interp interp) {
+    if (!valid_args(bank, delay, interp) || !x) {
+        return 0.0f;
+    }
+
+    int first;
+    float weight[4];
+    int count = interp_weights(bank, delay, interp, &first, weight);
+
+    float y = 0.0f;
+    for (int i = 0; i < count; i++) {
+        float dot;
+        fir_kernel_direct(phase_row(bank, first + i), bank->numtaps, x, &dot, 1);
+        y += weight[i] * dot;
+    }
+    return y;
+}
@@ -0,0 +1,69 @@
+#ifndef FIR_FRACDELAY_H
+#define FIR_FRACDELAY_H
+
+#include "fir_filter.h"
+
+// Fractional-delay filter bank.
+//
+// Windowed-sinc lowpass filters delayed by p / phases of a sample are
+// designed once for every phase p, so a filter for any fractional delay is
+// obtained by interpolating between neighbouring phases instead of running a
+// new design. Each phase is stored contiguously (reversed, padded to a
+// multiple of 16 floats and 64-byte aligned), and neighbouring phases are
+// adjacent in memory.
+
+enum fir_fracdelay_interp {
+    FIR_FRACDELAY_LINEAR,   // Linear interpolation between the two nearest phases
+    FIR_FRACDELAY_CUBIC     // Cubic (4-point Lagrange) interpolation
+};
+
+struct fir_fracdelay;
+
+/**
+ * @brief Create a fractional-delay bank.
+ *
+ * A filter for fractional delay d has a total delay of (numtaps - 1) / 2 + d
+ * samples and unity gain at DC.
+ *
+ * @param numtaps Number of taps of each filter
+ * @param phases Number of designed delays per sample (at least 1)
+ * @param cutoff Passband edge relative to Nyquist (0 < cutoff <= 1)
+ * @param window Window type
+ * @return New bank, or NULL on error
+ */
+struct fir_fracdelay* fir_fracdelay_create(int numtaps, int phases, float cutoff,
+                                           enum fir_filter_window_type window);
+
+/**
+ * @brief Destroy a bank created with fir_fracdelay_create().
+ */
+void fir_fracdelay_destroy(struct fir_fracdelay* bank);
+
+/**
+ * @brief Get the filter for a fractional delay.
+ *
+ * @param bank Bank
+ * @param delay Fractional delay in samples (0 <= delay <= 1)
+ * @param interp Interpolation between phases
+ * @param out Output array (must be pre-allocated with size numtaps)
+ * @return 0 on success, -1 on error
+ */
+int fir_fracdelay_taps(const struct fir_fracdelay* bank, float delay,
+                       enum fir_fracdelay_interp interp, float* out);
+
+/**
+ * @brief Compute one output sample delayed by a fractional delay.
+ *
+ * The filter is applied directly from the stored phases, without building
+ * the interpolated taps.
+ *
+ * @param bank Bank
+ * @param x The most recent numtaps input samples, oldest first
+ * @param delay Fractional delay in samples (0 <= delay <= 1)
+ * @param interp Interpolation between phases
+ * @return Output sample (0 if the arguments are invalid)
+ */
+float fir_fracdelay_apply(const struct fir_fracdelay* bank, const float* x, float delay,
+                          enum fir_fracdelay_interp interp);
+
+#endif
@@ -0,0 +1,83 @@
+#include "fir_hilbert.h"
+#include "fir_alloc.h"
+#include "fir_kernel.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Number of input samples handled per pass over the work buffer
+#define FIR_HILBERT_CHUNK 1024
+
+struct fir_hilbert {
+    int numtaps;
+    int count;      // Nonzero taps after the center
+    int offset;     // 1 if the outermost taps are zero and skipped, else 0
+    float* g;       // Nonzero taps after the center
+    float* buf;     // numtaps-1 samples of history followed by one chunk of input
+};
+
+struct fir_hilbert* fir_hilbert_create(int numtaps, enum fir_filter_window_type window) {
+    if (numtaps < 3 || numtaps % 2 == 0) {
+        return NULL;
+    }
+
+    struct fir_hilbert* hilbert = (struct fir_hilbert*)calloc(1, sizeof(struct fir_hilbert));
+    if (!hilbert) {
+        return NULL;
+    }
+
+    int center = (numtaps - 1) / 2;
+    hilbert->numtaps = numtaps;
+    hilbert->count = (center + 1) / 2;
+    hilbert->offset = center - (2 * hilbert->count - 1);
+    hilbert->g = (float*)fir_alloc(hilbert->count * sizeof(float), "fir_hilbert.taps");
+    hilbert->buf = (float*)fir_alloc((numtaps - 1 + FIR_HILBERT_CHUNK) * sizeof(float),
+                                     "fir_hilbert.buf");
+    float* taps = (float*)malloc(numtaps * sizeof(float));
+    if (!hilbert->g || !hilbert->buf || !taps || firhilbert(numtaps, window, taps) != 0) {
+        free(taps);
+        fir_hilbert_destroy(hilbert);
+        return NULL;
+    }
+
+    for (int k = 0; k < hilbert->count; k++) {
+        hilbert->g[k] = taps[center + 2 * k + 1];
+    }
+    free(taps);
+    return hilbert;
+}
+
+void fir_hilbert_destroy(struct fir_hilbert* hilbert) {
+    if (!hilbert) return;
+    fir_free(hilbert->g);
+    fir_free(hilbert->buf);
+    free(hilbert);
+}
+
+void fir_hilbert_reset(struct fir_hilbert* hilbert) {
+    if (!hilbert) return;
+    memset(hilbert->buf, 0, (hilbert->numtaps - 1) * sizeof(float));
+}
+
+int fir_hilbert_process(struct fir_hilbert* hilbert, const float* in, float* re, float* im, int n) {
+    if (!hilbert || n < 0 || (n > 0 && (!in || !im)) || (re && re == im)) {
+        return -1;
+    }
+
+    const int hist = hilbert->numtaps - 1;
+    const int center = hist / 2;
+    float* buf = hilbert->buf;
+    while (n > 0) {
+        int len = n < FIR_HILBERT_CHUNK ? n : FIR_HILBERT_CHUNK;
+        memcpy(buf + hist, in, len * sizeof(float));
+        fir_kernel_hilbert(hilbert->g, hilbert->count, buf + hilbert->offset, im, len);
+        if (re) {
+            memcpy(re, buf + center, len * sizeof(float));
+        }
+        memmove(buf, buf + len, hist * sizeof(float));
+        in += len;
+        if (re) re += len;
+        im += len;
+        n -= len;
+    }
+    return 0;
+}
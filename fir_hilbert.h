@@ -0,0 +1,50 @@
+#ifndef FIR_HILBERT_H
+#define FIR_HILBERT_H
+
+#include "fir_filter.h"
+
+// Analytic signal generator.
+//
+// Splits a real signal into the in-phase branch (the input delayed to match
+// the filter) and the quadrature branch (the input through a Hilbert
+// transformer designed with firhilbert()). The quadrature filter only
+// multiplies by its nonzero taps, once per antisymmetric pair, so it costs
+// about a quarter of a generic FIR filter of the same length. Like
+// fir_stream, blocks can have any size and processing never allocates.
+
+struct fir_hilbert;
+
+/**
+ * @brief Create an analytic signal generator.
+ *
+ * @param numtaps Number of taps of the Hilbert transformer (odd, at least 3; 4k + 3 is best)
+ * @param window Window type
+ * @return New generator, or NULL on error
+ */
+struct fir_hilbert* fir_hilbert_create(int numtaps, enum fir_filter_window_type window);
+
+/**
+ * @brief Destroy a generator created with fir_hilbert_create().
+ */
+void fir_hilbert_destroy(struct fir_hilbert* hilbert);
+
+/**
+ * @brief Clear the delay line, as if the generator had just been created.
+ */
+void fir_hilbert_reset(struct fir_hilbert* hilbert);
+
+/**
+ * @brief Compute the analytic signal of a block of samples.
+ *
+ * Both outputs are delayed by (numtaps - 1) / 2 samples relative to the input.
+ *
+ * @param hilbert Generator
+ * @param in Input samples
+ * @param re In-phase output (may be NULL, or the same buffer as in)
+ * @param im Quadrature output (may be the same buffer as in, but not as re)
+ * @param n Number of samples
+ * @return 0 on success, -1 on error
+ */
+int fir_hilbert_process(struct fir_hilbert* hilbert, const float* in, float* re, float* im, int n);
+
+#endif
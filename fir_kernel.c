@@ -0,0 +1,299 @@
+#include "fir_kernel.h"
+#include "fir_cpu.h"
+
+void fir_kernel_direct(const float* rtaps, int numtaps, const float* x, float* y, int n) {
+    for (int i = 0; i < n; i++) {
+        const float* xi = x + i;
+        float acc = 0.0f;
+        for (int k = 0; k < numtaps; k++) {
+            acc += rtaps[k] * xi[k];
+        }
+        y[i] = acc;
+    }
+}
+
+// Computes U outputs per pass over the taps; U is a constant in every
+// caller, so the inner loop is fully unrolled
+static inline __attribute__((always_inline))
+void direct_block(const float* rtaps, int numtaps, const float* x, float* y, int n, int prefetch,
+                  const int U) {
+    int i = 0;
+    for (; i + U <= n; i += U) {
+        const float* xi = x + i;
+        if (prefetch) {
+            __builtin_prefetch(xi + numtaps + prefetch);
+        }
+        float acc[8] = {0.0f};
+        for (int k = 0; k < numtaps; k++) {
+            float t = rtaps[k];
+            for (int u = 0; u < U; u++) {
+                acc[u] += t * xi[k + u];
+            }
+        }
+        for (int u = 0; u < U; u++) {
+            y[i + u] = acc[u];
+        }
+    }
+    fir_kernel_direct(rtaps, numtaps, x + i, y + i, n - i);
+}
+
+void fir_kernel_direct_tuned(const float* rtaps, int numtaps, const float* x, float* y, int n,
+                             int unroll, int prefetch) {
+    switch (unroll) {
+        case 2:  direct_block(rtaps, numtaps, x, y, n, prefetch, 2); break;
+        case 4:  direct_block(rtaps, numtaps, x, y, n, prefetch, 4); break;
+        case 8:  direct_block(rtaps, numtaps, x, y, n, prefetch, 8); break;
+        default: direct_block(rtaps, numtaps, x, y, n, prefetch, 1); break;
+    }
+}
+
+typedef void (*blocked_kernel)(const float* rtaps, int numtaps, const float* x, float* y, int n);
+
+static void blocked_scalar(const float* rtaps, int numtaps, const float* x, float* y, int n) {
+    direct_block(rtaps, numtaps, x, y, n, 0, 8);
+}
+
+#if FIR_X86
+// Every output is one FMA chain over the taps in order, whether it falls in a
+// full block or in the masked tail, so the result does not depend on n
+__attribute__((target("avx2,fma")))
+static void blocked_avx2(const float* rtaps, int numtaps, const float* x, float* y, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const float* xi = x + i;
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        for (int k = 0; k < numtaps; k++) {
+            __m256 t = _mm256_broadcast_ss(rtaps + k);
+            acc0 = _mm256_fmadd_ps(t, _mm256_loadu_ps(xi + k), acc0);
+            acc1 = _mm256_fmadd_ps(t, _mm256_loadu_ps(xi + k + 8), acc1);
+        }
+        _mm256_storeu_ps(y + i, acc0);
+        _mm256_storeu_ps(y + i + 8, acc1);
+    }
+    if (i < n) {
+        // The last partial block, with both accumulators masked
+        __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i m0 = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - i), lane);
+        __m256i m1 = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - i - 8), lane);
+        const float* xi = x + i;
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        for (int k = 0; k < numtaps; k++) {
+            __m256 t = _mm256_broadcast_ss(rtaps + k);
+            acc0 = _mm256_fmadd_ps(t, _mm256_maskload_ps(xi + k, m0), acc0);
+            acc1 = _mm256_fmadd_ps(t, _mm256_maskload_ps(xi + k + 8, m1), acc1);
+        }
+        _mm256_maskstore_ps(y + i, m0, acc0);
+        _mm256_maskstore_ps(y + i + 8, m1, acc1);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void blocked_avx512(const float* rtaps, int numtaps, const float* x, float* y, int n) {
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const float* xi = x + i;
+        __m512 acc0 = _mm512_setzero_ps();
+        __m512 acc1 = _mm512_setzero_ps();
+        for (int k = 0; k < numtaps; k++) {
+            __m512 t = _mm512_set1_ps(rtaps[k]);
+            acc0 = _mm512_fmadd_ps(t, _mm512_loadu_ps(xi + k), acc0);
+            acc1 = _mm512_fmadd_ps(t, _mm512_loadu_ps(xi + k + 16), acc1);
+        }
+        _mm512_storeu_ps(y + i, acc0);
+        _mm512_storeu_ps(y + i + 16, acc1);
+    }
+    if (i < n) {
+        // The last partial block, with both accumulators masked
+        int left = n - i;
+        __mmask16 m0 = left >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << left) - 1);
+        __mmask16 m1 = left <= 16 ? (__mmask16)0 : (__mmask16)((1u << (left - 16)) - 1);
+        const float* xi = x + i;
+        __m512 acc0 = _mm512_setzero_ps();
+        __m512 acc1 = _mm512_setzero_ps();
+        for (int k = 0; k < numtaps; k++) {
+            __m512 t = _mm512_set1_ps(rtaps[k]);
+            acc0 = _mm512_fmadd_ps(t, _mm512_maskz_loadu_ps(m0, xi + k), acc0);
+            acc1 = _mm512_fmadd_ps(t, _mm512_maskz_loadu_ps(m1, xi + k + 16), acc1);
+        }
+        _mm512_mask_storeu_ps(y + i, m0, acc0);
+        _mm512_mask_storeu_ps(y + i + 16, m1, acc1);
+    }
+}
+#endif
+
+static blocked_kernel select_blocked(void) {
+#if FIR_X86
+    if (fir_cpu_has_avx512()) return blocked_avx512;
+    if (fir_cpu_has_avx2()) return blocked_avx2;
+#endif
+    return blocked_scalar;
+}
+
+void fir_kernel_blocked(const float* rtaps, int numtaps, const float* x, float* y, int n) {
+    // Selected on first use; concurrent first calls store the same value
+    static blocked_kernel kernel;
+    blocked_kernel k = __atomic_load_n(&kernel, __ATOMIC_RELAXED);
+    if (!k) {
+        k = select_blocked();
+        __atomic_store_n(&kernel, k, __ATOMIC_RELAXED);
+    }
+    k(rtaps, numtaps, x, y, n);
+}
+
+typedef void (*decimate_kernel)(const float* rtaps, int numtaps, const float* x, int factor,
+                                float* y, int n);
+
+static void decimate_scalar(const float* rtaps, int numtaps, const float* x, int factor,
+                            float* y, int n) {
+    for (int i = 0; i < n; i++) {
+        const float* xi = x + i * factor;
+        float acc = 0.0f;
+        for (int k = 0; k < numtaps; k++) {
+            acc += rtaps[k] * xi[k];
+        }
+        y[i] = acc;
+    }
+}
+
+#if FIR_X86
+// The outputs of a decimating filter share no inputs to slide over, so each
+// one is a dot product over the taps, vectorized along them. Four outputs
+// are computed per pass so every vector of taps is loaded once for all of
+// them; an output left over is computed alone with the same arithmetic.
+__attribute__((target("avx2,fma")))
+static inline float decimate_sum_avx2(__m256 acc) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return _mm_cvtss_f32(sum);
+}
+
+__attribute__((target("avx2,fma")))
+static void decimate_avx2(const float* rtaps, int numtaps, const float* x, int factor, float* y,
+                          int n) {
+    const int full = numtaps & ~7;
+    __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i tail = _mm256_cmpgt_epi32(_mm256_set1_epi32(numtaps - full), lane);
+    __m256 tail_taps = _mm256_maskload_ps(rtaps + full, tail);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float* x0 = x + (size_t)i * factor;
+        const float* x1 = x0 + factor;
+        const float* x2 = x1 + factor;
+        const float* x3 = x2 + factor;
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+        for (int k = 0; k < full; k += 8) {
+            __m256 t = _mm256_loadu_ps(rtaps + k);
+            acc0 = _mm256_fmadd_ps(t, _mm256_loadu_ps(x0 + k), acc0);
+            acc1 = _mm256_fmadd_ps(t, _mm256_loadu_ps(x1 + k), acc1);
+            acc2 = _mm256_fmadd_ps(t, _mm256_loadu_ps(x2 + k), acc2);
+            acc3 = _mm256_fmadd_ps(t, _mm256_loadu_ps(x3 + k), acc3);
+        }
+        if (full < numtaps) {
+            acc0 = _mm256_fmadd_ps(tail_taps, _mm256_maskload_ps(x0 + full, tail), acc0);
+            acc1 = _mm256_fmadd_ps(tail_taps, _mm256_maskload_ps(x1 + full, tail), acc1);
+            acc2 = _mm256_fmadd_ps(tail_taps, _mm256_maskload_ps(x2 + full, tail), acc2);
+            acc3 = _mm256_fmadd_ps(tail_taps, _mm256_maskload_ps(x3 + full, tail), acc3);
+        }
+        y[i] = decimate_sum_avx2(acc0);
+        y[i + 1] = decimate_sum_avx2(acc1);
+        y[i + 2] = decimate_sum_avx2(acc2);
+        y[i + 3] = decimate_sum_avx2(acc3);
+    }
+    for (; i < n; i++) {
+        const float* xi = x + (size_t)i * factor;
+        __m256 acc = _mm256_setzero_ps();
+        for (int k = 0; k < full; k += 8) {
+            acc = _mm256_fmadd_ps(_mm256_loadu_ps(rtaps + k), _mm256_loadu_ps(xi + k), acc);
+        }
+        if (full < numtaps) {
+            acc = _mm256_fmadd_ps(tail_taps, _mm256_maskload_ps(xi + full, tail), acc);
+        }
+        y[i] = decimate_sum_avx2(acc);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void decimate_avx512(const float* rtaps, int numtaps, const float* x, int factor, float* y,
+                            int n) {
+    const int full = numtaps & ~15;
+    const __mmask16 tail = (__mmask16)((1u << (numtaps - full)) - 1);
+    __m512 tail_taps = _mm512_maskz_loadu_ps(tail, rtaps + full);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float* x0 = x + (size_t)i * factor;
+        const float* x1 = x0 + factor;
+        const float* x2 = x1 + factor;
+        const float* x3 = x2 + factor;
+        __m512 acc0 = _mm512_setzero_ps();
+        __m512 acc1 = _mm512_setzero_ps();
+        __m512 acc2 = _mm512_setzero_ps();
+        __m512 acc3 = _mm512_setzero_ps();
+        for (int k = 0; k < full; k += 16) {
+            __m512 t = _mm512_loadu_ps(rtaps + k);
+            acc0 = _mm512_fmadd_ps(t, _mm512_loadu_ps(x0 + k), acc0);
+            acc1 = _mm512_fmadd_ps(t, _mm512_loadu_ps(x1 + k), acc1);
+            acc2 = _mm512_fmadd_ps(t, _mm512_loadu_ps(x2 + k), acc2);
+            acc3 = _mm512_fmadd_ps(t, _mm512_loadu_ps(x3 + k), acc3);
+        }
+        if (tail) {
+            acc0 = _mm512_fmadd_ps(tail_taps, _mm512_maskz_loadu_ps(tail, x0 + full), acc0);
+            acc1 = _mm512_fmadd_ps(tail_taps, _mm512_maskz_loadu_ps(tail, x1 + full), acc1);
+            acc2 = _mm512_fmadd_ps(tail_taps, _mm512_maskz_loadu_ps(tail, x2 + full), acc2);
+            acc3 = _mm512_fmadd_ps(tail_taps, _mm512_maskz_loadu_ps(tail, x3 + full), acc3);
+        }
+        y[i] = _mm512_reduce_add_ps(acc0);
+        y[i + 1] = _mm512_reduce_add_ps(acc1);
+        y[i + 2] = _mm512_reduce_add_ps(acc2);
+        y[i + 3] = _mm512_reduce_add_ps(acc3);
+    }
+    for (; i < n; i++) {
+        const float* xi = x + (size_t)i * factor;
+        __m512 acc = _mm512_setzero_ps();
+        for (int k = 0; k < full; k += 16) {
+            acc = _mm512_fmadd_ps(_mm512_loadu_ps(rtaps + k), _mm512_loadu_ps(xi + k), acc);
+        }
+        if (tail) {
+            acc = _mm512_fmadd_ps(tail_taps, _mm512_maskz_loadu_ps(tail, xi + full), acc);
+        }
+        y[i] = _mm512_reduce_add_ps(acc);
+    }
+}
+#endif
+
+static decimate_kernel select_decimate(void) {
+#if FIR_X86
+    if (fir_cpu_has_avx512()) return decimate_avx512;
+    if (fir_cpu_has_avx2()) return decimate_avx2;
+#endif
+    return decimate_scalar;
+}
+
+void fir_kernel_decimate(const float* rtaps, int numtaps, const float* x, int factor,
+                         float* y, int n) {
+    // Selected on first use; concurrent first calls store the same value
+    static decimate_kernel kernel;
+    decimate_kernel k = __atomic_load_n(&kernel, __ATOMIC_RELAXED);
+    if (!k) {
+        k = select_decimate();
+        __atomic_store_n(&kernel, k, __ATOMIC_RELAXED);
+    }
+    k(rtaps, numtaps, x, factor, y, n);
+}
+
+void fir_kernel_hilbert(const float* g, int count, const float* x, float* y, int n) {
+    const int c = 2 * count - 1;
+    for (int i = 0; i < n; i++) {
+        const float* xc = x + i + c;
+        float acc = 0.0f;
+        for (int k = 0; k < count; k++) {
+            acc += g[k] * (xc[-2 * k - 1] - xc[2 * k + 1]);
+        }
+        y[i] = acc;
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef FIR_KERNEL_H
+#define FIR_KERNEL_H
+
+// Convolution kernels shared by the filter engines (internal header).
+
+/**
+ * @brief Direct-form FIR kernel.
+ *
+ * Computes y[i] = sum(rtaps[k] * x[i + k], k = 0..numtaps-1) for i in [0, n).
+ * x must hold numtaps - 1 + n samples: the history followed by the input.
+ *
+ * @param rtaps Taps in reverse order
+ * @param numtaps Number of taps
+ * @param x Input samples, including numtaps - 1 samples of history
+ * @param y Output samples
+ * @param n Number of outputs
+ */
+void fir_kernel_direct(const float* rtaps, int numtaps, const float* x, float* y, int n);
+
+/**
+ * @brief Direct-form FIR kernel with tuning parameters.
+ *
+ * Same result as fir_kernel_direct() (bit for bit), but computes unroll
+ * outputs per pass over the taps, so each tap is loaded once for all of
+ * them, and optionally prefetches the input ahead of the current window.
+ *
+ * @param unroll Outputs per pass: 1, 2, 4 or 8 (other values act as 1)
+ * @param prefetch Prefetch distance in samples beyond the current window, or 0 for none
+ */
+void fir_kernel_direct_tuned(const float* rtaps, int numtaps, const float* x, float* y, int n,
+                             int unroll, int prefetch);
+
+// Range of tap counts for which the filter engines use fir_kernel_blocked()
+#define FIR_KERNEL_BLOCKED_MIN_TAPS 32
+#define FIR_KERNEL_BLOCKED_MAX_TAPS 512
+
+/**
+ * @brief Register-blocked direct-form FIR kernel.
+ *
+ * Same operation as fir_kernel_direct(), with a run-time selected variant
+ * per instruction set: a block of consecutive outputs is kept in vector
+ * registers (16 with AVX2, 32 with AVX-512) and each tap is broadcast once
+ * per block while the input window slides under it. Without AVX2 it is
+ * fir_kernel_direct_tuned() with 8 outputs per pass.
+ *
+ * Each output is accumulated over the taps in order with the same arithmetic
+ * wherever it falls, so results do not depend on n or on how a signal is
+ * split into calls. They may differ from fir_kernel_direct() in the last
+ * bits, because the vector variants use fused multiply-add.
+ */
+void fir_kernel_blocked(const float* rtaps, int numtaps, const float* x, float* y, int n);
+
+/**
+ * @brief Decimating direct-form FIR kernel.
+ *
+ * Like fir_kernel_direct(), but output i is computed at input position
+ * i * factor: y[i] = sum(rtaps[k] * x[i * factor + k], k = 0..numtaps-1).
+ *
+ * With AVX2 or AVX-512 each output is a vector dot product over the taps.
+ * Every output is computed with the same arithmetic wherever it falls, so
+ * results do not depend on n or on how a signal is split into calls, but
+ * may differ from fir_kernel_direct() in the last bits.
+ */
+void fir_kernel_decimate(const float* rtaps, int numtaps, const float* x, int factor,
+                         float* y, int n);
+
+/**
+ * @brief Hilbert transformer kernel.
+ *
+ * Exploits the antisymmetry and the zero even taps of a Hilbert transformer
+ * of 4 * count - 1 taps, h[c + m] = -h[c - m] = g[(m - 1) / 2] for odd m, with
+ * c = 2 * count - 1: y[i] = sum(g[k] * (x[i + c - 2k - 1] - x[i + c + 2k + 1]),
+ * k = 0..count-1). Each output costs count multiplications instead of
+ * 4 * count - 1. x must hold 4 * count - 2 + n samples.
+ *
+ * @param g Taps at odd offsets 1, 3, 5, ... after the center
+ * @param count Number of such taps
+ * @param x Input samples, including 4 * count - 2 samples of history
+ * @param y Output samples
+ * @param n Number of outputs
+ */
+void fir_kernel_hilbert(const float* g, int count, const float* x, float* y, int n);
+
+#endif
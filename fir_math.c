@@ -0,0 +1,163 @@
+#include "fir_math.h"
+#include "fir_cpu.h"
+#include <math.h>
+#include <string.h>
+
+// The argument is reduced to x = k/2 + r with integer k and |r| <= 1/4, then
+// sin(pi*r) and cos(pi*r) are evaluated with Taylor polynomials (truncation
+// error below 3e-8 relative on that interval) and combined by quadrant:
+//
+//   q = k mod 4      0        1        2        3
+//   sin(pi*x)    sin(pi*r) cos(pi*r) -sin(pi*r) -cos(pi*r)
+//
+// cos(pi*x) is sin(pi*x) one quadrant further, so both share one kernel.
+
+#define S1  3.14159265358979f      //  pi
+#define S3 -5.16771278004997f      // -pi^3 / 3!
+#define S5  2.55016403987735f      //  pi^5 / 5!
+#define S7 -0.599264529320792f     // -pi^7 / 7!
+#define S9  0.0821458866111282f    //  pi^9 / 9!
+
+#define C0  1.0f
+#define C2 -4.93480220054468f      // -pi^2 / 2!
+#define C4  4.05871212641677f      //  pi^4 / 4!
+#define C6 -1.33526276885459f      // -pi^6 / 6!
+#define C8  0.235330630358893f     //  pi^8 / 8!
+#define C10 -0.0258068913900140f   // -pi^10 / 10!
+
+typedef void (*trig_kernel)(const float* x, float* y, int n, int quadrant);
+
+static void trig_scalar(const float* x, float* y, int n, int quadrant) {
+    for (int i = 0; i < n; i++) {
+        float v = x[i];
+        float k = nearbyintf(v + v);
+        float r = v - 0.5f * k;
+        int q = (int)(k - 4.0f * floorf(0.25f * k)) + quadrant;
+
+        float r2 = r * r;
+        float res;
+        if (q & 1) {
+            res = C0 + r2 * (C2 + r2 * (C4 + r2 * (C6 + r2 * (C8 + r2 * C10))));
+        } else {
+            res = r * (S1 + r2 * (S3 + r2 * (S5 + r2 * (S7 + r2 * S9))));
+        }
+        y[i] = (q & 2) ? -res : res;
+    }
+}
+
+#if FIR_X86
+__attribute__((target("avx2,fma")))
+static inline __m256 trig_avx2_block(__m256 v, __m256i quadrant) {
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    const __m256 four = _mm256_set1_ps(4.0f);
+
+    __m256 k = _mm256_round_ps(_mm256_add_ps(v, v), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(k, half, v);
+    __m256 kmod = _mm256_fnmadd_ps(_mm256_floor_ps(_mm256_mul_ps(k, quarter)), four, k);
+    __m256i q = _mm256_add_epi32(_mm256_cvtps_epi32(kmod), quadrant);
+
+    __m256 r2 = _mm256_mul_ps(r, r);
+    __m256 s = _mm256_fmadd_ps(r2, _mm256_set1_ps(S9), _mm256_set1_ps(S7));
+    s = _mm256_fmadd_ps(r2, s, _mm256_set1_ps(S5));
+    s = _mm256_fmadd_ps(r2, s, _mm256_set1_ps(S3));
+    s = _mm256_fmadd_ps(r2, s, _mm256_set1_ps(S1));
+    s = _mm256_mul_ps(r, s);
+
+    __m256 c = _mm256_fmadd_ps(r2, _mm256_set1_ps(C10), _mm256_set1_ps(C8));
+    c = _mm256_fmadd_ps(r2, c, _mm256_set1_ps(C6));
+    c = _mm256_fmadd_ps(r2, c, _mm256_set1_ps(C4));
+    c = _mm256_fmadd_ps(r2, c, _mm256_set1_ps(C2));
+    c = _mm256_fmadd_ps(r2, c, _mm256_set1_ps(C0));
+
+    // Bit 0 of q selects the polynomial, bit 1 the sign
+    __m256 odd = _mm256_castsi256_ps(_mm256_slli_epi32(q, 31));
+    __m256 res = _mm256_blendv_ps(s, c, odd);
+    __m256i sign = _mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30);
+    return _mm256_xor_ps(res, _mm256_castsi256_ps(sign));
+}
+
+__attribute__((target("avx2,fma")))
+static void trig_avx2(const float* x, float* y, int n, int quadrant) {
+    const __m256i quad = _mm256_set1_epi32(quadrant);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(y + i, trig_avx2_block(_mm256_loadu_ps(x + i), quad));
+    }
+
+    // The tail goes through the same vector code so every element of a call
+    // is computed identically
+    if (i < n) {
+        float tmp[8] = {0};
+        memcpy(tmp, x + i, (n - i) * sizeof(float));
+        _mm256_storeu_ps(tmp, trig_avx2_block(_mm256_loadu_ps(tmp), quad));
+        memcpy(y + i, tmp, (n - i) * sizeof(float));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void trig_avx512(const float* x, float* y, int n, int quadrant) {
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 quarter = _mm512_set1_ps(0.25f);
+    const __m512 four = _mm512_set1_ps(4.0f);
+    const __m512i quad = _mm512_set1_epi32(quadrant);
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i two = _mm512_set1_epi32(2);
+
+    for (int i = 0; i < n; i += 16) {
+        __mmask16 m = n - i >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (n - i)) - 1);
+        __m512 v = _mm512_maskz_loadu_ps(m, x + i);
+
+        __m512 k = _mm512_roundscale_ps(_mm512_add_ps(v, v), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m512 r = _mm512_fnmadd_ps(k, half, v);
+        __m512 fl = _mm512_roundscale_ps(_mm512_mul_ps(k, quarter), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        __m512 kmod = _mm512_fnmadd_ps(fl, four, k);
+        __m512i q = _mm512_add_epi32(_mm512_cvtps_epi32(kmod), quad);
+
+        __m512 r2 = _mm512_mul_ps(r, r);
+        __m512 s = _mm512_fmadd_ps(r2, _mm512_set1_ps(S9), _mm512_set1_ps(S7));
+        s = _mm512_fmadd_ps(r2, s, _mm512_set1_ps(S5));
+        s = _mm512_fmadd_ps(r2, s, _mm512_set1_ps(S3));
+        s = _mm512_fmadd_ps(r2, s, _mm512_set1_ps(S1));
+        s = _mm512_mul_ps(r, s);
+
+        __m512 c = _mm512_fmadd_ps(r2, _mm512_set1_ps(C10), _mm512_set1_ps(C8));
+        c = _mm512_fmadd_ps(r2, c, _mm512_set1_ps(C6));
+        c = _mm512_fmadd_ps(r2, c, _mm512_set1_ps(C4));
+        c = _mm512_fmadd_ps(r2, c, _mm512_set1_ps(C2));
+        c = _mm512_fmadd_ps(r2, c, _mm512_set1_ps(C0));
+
+        __m512 res = _mm512_mask_blend_ps(_mm512_test_epi32_mask(q, one), s, c);
+        __m512i sign = _mm512_slli_epi32(_mm512_and_si512(q, two), 30);
+        res = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(res), sign));
+        _mm512_mask_storeu_ps(y + i, m, res);
+    }
+}
+#endif
+
+static trig_kernel select_kernel(void) {
+#if FIR_X86
+    if (fir_cpu_has_avx512()) return trig_avx512;
+    if (fir_cpu_has_avx2()) return trig_avx2;
+#endif
+    return trig_scalar;
+}
+
+static void trig(const float* x, float* y, int n, int quadrant) {
+    // Selected on first use; concurrent first calls store the same value
+    static trig_kernel kernel;
+    trig_kernel k = __atomic_load_n(&kernel, __ATOMIC_RELAXED);
+    if (!k) {
+        k = select_kernel();
+        __atomic_store_n(&kernel, k, __ATOMIC_RELAXED);
+    }
+    k(x, y, n, quadrant);
+}
+
+void fir_sinpi(const float* x, float* y, int n) {
+    trig(x, y, n, 0);
+}
+
+void fir_cospi(const float* x, float* y, int n) {
+    trig(x, y, n, 1);
+}
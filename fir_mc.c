@@ -0,0 +1,261 @@
+#include "fir_mc.h"
+#include "fir_alloc.h"
+#include "fir_kernel.h"
+#include "fir_numa.h"
+#include "fir_pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Number of input samples handled per pass over a channel's work buffer
+#define FIR_MC_CHUNK 1024
+
+// Delay lines are padded to a multiple of this many floats (one cache line)
+// so channels of different workers never share a line
+#define FIR_MC_ALIGN 16
+
+// Upper bound on the number of CPUs per node that are considered
+#define FIR_MC_MAX_CPUS 4096
+
+// Channels of one NUMA node
+struct mc_group {
+    int node;
+    void* region;       // Taps and delay lines of the group, placed on the node
+    float* rtaps;       // Taps in reverse order
+};
+
+struct fir_mc {
+    int numtaps;
+    int channels;
+    int group_count;
+    struct mc_group* groups;
+    int worker_count;
+    struct fir_pool* pool;
+    int* worker_group;      // Group of each worker
+    int* worker_first;      // First channel of each worker
+    int* worker_channels;   // Number of channels of each worker
+    int* channel_worker;
+    float** buf;            // Per channel: numtaps-1 samples of history and one chunk
+
+    // Current job
+    const float* const* in;
+    float* const* out;
+    int n;
+    int reset;
+};
+
+static size_t round_up(size_t x, size_t align) {
+    return (x + align - 1) / align * align;
+}
+
+static void mc_worker(void* arg, int worker) {
+    struct fir_mc* mc = (struct fir_mc*)arg;
+    const int hist = mc->numtaps - 1;
+    const float* rtaps = mc->groups[mc->worker_group[worker]].rtaps;
+    int first = mc->worker_first[worker];
+    int last = first + mc->worker_channels[worker];
+
+    for (int ch = first; ch < last; ch++) {
+        float* buf = mc->buf[ch];
+        if (mc->reset) {
+            memset(buf, 0, hist * sizeof(float));
+            continue;
+        }
+
+        const float* in = mc->in[ch];
+        float* out = mc->out[ch];
+        int n = mc->n;
+        while (n > 0) {
+            int len = n < FIR_MC_CHUNK ? n : FIR_MC_CHUNK;
+            memcpy(buf + hist, in, len * sizeof(float));
+            fir_kernel_direct(rtaps, mc->numtaps, buf, out, len);
+            memmove(buf, buf + len, hist * sizeof(float));
+            in += len;
+            out += len;
+            n -= len;
+        }
+    }
+}
+
+struct fir_mc* fir_mc_create(const float* taps, int numtaps, int channels, int threads_per_node) {
+    if (!taps || numtaps <= 0 || channels <= 0 || threads_per_node < 0) {
+        return NULL;
+    }
+
+    struct fir_mc* mc = (struct fir_mc*)calloc(1, sizeof(struct fir_mc));
+    if (!mc) {
+        return NULL;
+    }
+    mc->numtaps = numtaps;
+    mc->channels = channels;
+
+    // Nodes with usable CPUs, and how many workers each can take
+    int node_count = fir_numa_node_count();
+    int* nodes = (int*)malloc(node_count * sizeof(int));
+    int* node_cpus = (int*)malloc(node_count * sizeof(int));
+    int* cpus = (int*)malloc(FIR_MC_MAX_CPUS * sizeof(int));
+    mc->groups = (struct mc_group*)calloc(node_count, sizeof(struct mc_group));
+    mc->channel_worker = (int*)malloc(channels * sizeof(int));
+    mc->buf = (float**)calloc(channels, sizeof(float*));
+    if (!nodes || !node_cpus || !cpus || !mc->groups || !mc->channel_worker || !mc->buf) {
+        goto fail;
+    }
+
+    int usable = 0;
+    for (int node = 0; node < node_count; node++) {
+        int count = fir_numa_node_cpus(node, cpus, FIR_MC_MAX_CPUS);
+        if (count > 0) {
+            nodes[usable] = node;
+            node_cpus[usable] = count;
+            usable++;
+        }
+    }
+    if (usable == 0) {
+        // Topology unreadable: run unrestricted on node 0
+        nodes[0] = 0;
+        node_cpus[0] = 1;
+        usable = 1;
+    }
+
+    // One group per node, each with an even share of the channels
+    int max_workers = 0;
+    for (int g = 0; g < usable; g++) {
+        int share = (int)((long long)channels * (g + 1) / usable - (long long)channels * g / usable);
+        if (share > 0) {
+            int threads = threads_per_node > 0 ? threads_per_node : node_cpus[g];
+            max_workers += threads < share ? threads : share;
+        }
+    }
+    mc->worker_group = (int*)malloc(max_workers * sizeof(int));
+    mc->worker_first = (int*)malloc(max_workers * sizeof(int));
+    mc->worker_channels = (int*)malloc(max_workers * sizeof(int));
+    int* worker_node = (int*)malloc(max_workers * sizeof(int));
+    if (!mc->worker_group || !mc->worker_first || !mc->worker_channels || !worker_node) {
+        free(worker_node);
+        goto fail;
+    }
+
+    const size_t taps_size = round_up(numtaps, FIR_MC_ALIGN) * sizeof(float);
+    const size_t buf_size = round_up(numtaps - 1 + FIR_MC_CHUNK, FIR_MC_ALIGN) * sizeof(float);
+
+    for (int g = 0; g < usable; g++) {
+        int first = (int)((long long)channels * g / usable);
+        int share = (int)((long long)channels * (g + 1) / usable) - first;
+        if (share == 0) {
+            continue;
+        }
+
+        // Place the group's memory on its node before anything touches it
+        struct mc_group* group = &mc->groups[mc->group_count++];
+        group->node = nodes[g];
+        group->region = fir_alloc_on_node(taps_size + share * buf_size, "fir_mc.region",
+                                          group->node);
+        if (!group->region) {
+            free(worker_node);
+            goto fail;
+        }
+
+        group->rtaps = (float*)group->region;
+        for (int k = 0; k < numtaps; k++) {
+            group->rtaps[k] = taps[numtaps - 1 - k];
+        }
+        for (int c = 0; c < share; c++) {
+            mc->buf[first + c] = (float*)((char*)group->region + taps_size + c * buf_size);
+        }
+
+        // Split the group's channels between its workers
+        int threads = threads_per_node > 0 ? threads_per_node : node_cpus[g];
+        if (threads > share) {
+            threads = share;
+        }
+        for (int t = 0; t < threads; t++) {
+            int w = mc->worker_count++;
+            int lo = first + (int)((long long)share * t / threads);
+            int hi = first + (int)((long long)share * (t + 1) / threads);
+            mc->worker_group[w] = mc->group_count - 1;
+            mc->worker_first[w] = lo;
+            mc->worker_channels[w] = hi - lo;
+            worker_node[w] = usable > 1 ? group->node : -1;
+            for (int ch = lo; ch < hi; ch++) {
+                mc->channel_worker[ch] = w;
+            }
+        }
+    }
+
+    mc->pool = fir_pool_create(mc->worker_count, worker_node);
+    free(worker_node);
+    if (!mc->pool) {
+        goto fail;
+    }
+
+    free(nodes);
+    free(node_cpus);
+    free(cpus);
+
+    // The workers clear their own delay lines, faulting the pages in on
+    // their node
+    fir_mc_reset(mc);
+    return mc;
+
+fail:
+    free(nodes);
+    free(node_cpus);
+    free(cpus);
+    fir_mc_destroy(mc);
+    return NULL;
+}
+
+void fir_mc_destroy(struct fir_mc* mc) {
+    if (!mc) return;
+    fir_pool_destroy(mc->pool);
+    for (int g = 0; g < mc->group_count; g++) {
+        fir_free(mc->groups[g].region);
+    }
+    free(mc->groups);
+    free(mc->worker_group);
+    free(mc->worker_first);
+    free(mc->worker_channels);
+    free(mc->channel_worker);
+    free(mc->buf);
+    free(mc);
+}
+
+void fir_mc_reset(struct fir_mc* mc) {
+    if (!mc) return;
+    mc->reset = 1;
+    fir_pool_run(mc->pool, mc_worker, mc);
+    mc->reset = 0;
+}
+
+int fir_mc_process(struct fir_mc* mc, const float* const* in, float* const* out, int n) {
+    if (!mc || !in || !out || n < 0) {
+        return -1;
+    }
+    for (int ch = 0; ch < mc->channels; ch++) {
+        if (n > 0 && (!in[ch] || !out[ch])) {
+            return -1;
+        }
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    mc->in = in;
+    mc->out = out;
+    mc->n = n;
+    fir_pool_run(mc->pool, mc_worker, mc);
+    return 0;
+}
+
+int fir_mc_placement(const struct fir_mc* mc, int channel, struct fir_mc_placement* placement) {
+    if (!mc || channel < 0 || channel >= mc->channels || !placement) {
+        return -1;
+    }
+
+    int worker = mc->channel_worker[channel];
+    const struct mc_group* group = &mc->groups[mc->worker_group[worker]];
+    placement->node = group->node;
+    placement->state_node = fir_numa_node_of(mc->buf[channel]);
+    placement->taps_node = fir_numa_node_of(group->rtaps);
+    placement->worker = worker;
+    return 0;
+}
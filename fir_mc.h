@@ -0,0 +1,65 @@
+#ifndef FIR_MC_H
+#define FIR_MC_H
+
+// Multi-channel filtering with NUMA-aware placement.
+//
+// The channels are split into one group per NUMA node (only nodes with CPUs
+// this process may use are counted). Each group's copy of the taps and its
+// channels' delay lines are allocated on the group's node, and the group is
+// filtered by worker threads restricted to that node's CPUs, so no memory
+// traffic crosses nodes. On a single-node machine this is simply a
+// multi-threaded multi-channel filter.
+
+struct fir_mc;
+
+// Where a channel's data and worker ended up
+struct fir_mc_placement {
+    int node;           // Node the channel's group was assigned to
+    int state_node;     // Node actually holding the delay line (-1 if unknown)
+    int taps_node;      // Node actually holding the group's taps (-1 if unknown)
+    int worker;         // Index of the worker thread filtering the channel
+};
+
+/**
+ * @brief Create a multi-channel filter.
+ *
+ * @param taps Filter coefficients shared by all channels (copied once per node)
+ * @param numtaps Number of taps
+ * @param channels Number of channels
+ * @param threads_per_node Worker threads per node, or 0 for one per CPU of the node
+ * @return New filter, or NULL on error
+ */
+struct fir_mc* fir_mc_create(const float* taps, int numtaps, int channels, int threads_per_node);
+
+/**
+ * @brief Stop the workers and destroy a filter created with fir_mc_create().
+ */
+void fir_mc_destroy(struct fir_mc* mc);
+
+/**
+ * @brief Clear the delay lines of all channels.
+ */
+void fir_mc_reset(struct fir_mc* mc);
+
+/**
+ * @brief Filter one block on every channel.
+ *
+ * @param mc Filter
+ * @param in Input sample arrays, one per channel
+ * @param out Output sample arrays, one per channel (may be the same as in)
+ * @param n Number of samples per channel
+ * @return 0 on success, -1 on error
+ */
+int fir_mc_process(struct fir_mc* mc, const float* const* in, float* const* out, int n);
+
+/**
+ * @brief Query where a channel's state, taps and worker are placed.
+ *
+ * @param mc Filter
+ * @param channel Channel index
+ * @param placement Output placement
+ * @return 0 on success, -1 on error
+ */
+int fir_mc_placement(const struct fir_mc* mc, int channel, struct fir_mc_placement* placement);
+
+#endif
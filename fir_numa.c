@@ -0,0 +1,121 @@
+#define _GNU_SOURCE
+#include "fir_numa.h"
+#include <dirent.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Memory policy constants from linux/mempolicy.h
+#define FIR_MPOL_PREFERRED 1
+#define FIR_MPOL_F_NODE (1 << 0)
+#define FIR_MPOL_F_ADDR (1 << 1)
+
+#define FIR_NUMA_MAX_NODES 1024
+
+int fir_numa_node_count(void) {
+    DIR* dir = opendir("/sys/devices/system/node");
+    if (!dir) {
+        return 1;
+    }
+
+    int count = 1;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int node;
+        char tail;
+        if (sscanf(entry->d_name, "node%d%c", &node, &tail) == 1 &&
+            node >= 0 && node < FIR_NUMA_MAX_NODES && node + 1 > count) {
+            count = node + 1;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+int fir_numa_node_cpus(int node, int* cpus, int max) {
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return 0;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        // No topology information: every CPU is on node 0
+        if (node != 0) {
+            return 0;
+        }
+        int count = 0;
+        for (int cpu = 0; cpu < CPU_SETSIZE && count < max; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                cpus[count++] = cpu;
+            }
+        }
+        return count;
+    }
+
+    // The list looks like "0-3,8-11"
+    char line[4096];
+    int count = 0;
+    if (fgets(line, sizeof(line), f)) {
+        char* p = line;
+        while (*p && *p != '\n') {
+            char* end;
+            long first = strtol(p, &end, 10);
+            if (end == p) break;
+            long last = first;
+            p = end;
+            if (*p == '-') {
+                last = strtol(p + 1, &end, 10);
+                p = end;
+            }
+            for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &allowed) && count < max) {
+                    cpus[count++] = (int)cpu;
+                }
+            }
+            if (*p == ',') p++;
+        }
+    }
+    fclose(f);
+    return count;
+}
+
+int fir_numa_bind(void* addr, size_t len, int node) {
+    if (node < 0 || node >= FIR_NUMA_MAX_NODES) {
+        return -1;
+    }
+    unsigned long mask[FIR_NUMA_MAX_NODES / (8 * sizeof(unsigned long))];
+    memset(mask, 0, sizeof(mask));
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+
+    long r = syscall(SYS_mbind, addr, len, FIR_MPOL_PREFERRED, mask,
+                     (unsigned long)FIR_NUMA_MAX_NODES, 0);
+    return r == 0 ? 0 : -1;
+}
+
+int fir_numa_node_of(const void* addr) {
+    int node = -1;
+    long r = syscall(SYS_get_mempolicy, &node, NULL, 0UL, addr,
+                     (unsigned long)(FIR_MPOL_F_NODE | FIR_MPOL_F_ADDR));
+    return r == 0 ? node : -1;
+}
+
+int fir_numa_run_on_node(int node) {
+    int cpus[CPU_SETSIZE];
+    int count = fir_numa_node_cpus(node, cpus, CPU_SETSIZE);
+    if (count == 0) {
+        return -1;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; i < count; i++) {
+        CPU_SET(cpus[i], &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0 ? 0 : -1;
+}
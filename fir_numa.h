@@ -0,0 +1,51 @@
+#ifndef FIR_NUMA_H
+#define FIR_NUMA_H
+
+#include <stddef.h>
+
+// NUMA topology and memory placement helpers (internal header).
+//
+// Implemented with the Linux sysfs topology and the mbind/get_mempolicy
+// system calls, so no libnuma is needed. On systems without NUMA support
+// everything is reported as node 0.
+
+/**
+ * @brief Number of NUMA node ids (the highest node id + 1).
+ */
+int fir_numa_node_count(void);
+
+/**
+ * @brief Get the CPUs of a node that this process may run on.
+ *
+ * @param node Node id
+ * @param cpus Output array of CPU ids
+ * @param max Size of cpus
+ * @return Number of CPUs (0 if the node has none or does not exist)
+ */
+int fir_numa_node_cpus(int node, int* cpus, int max);
+
+/**
+ * @brief Prefer a node for the pages of a memory range that are not yet allocated.
+ *
+ * @param addr Page-aligned start of the range
+ * @param len Length in bytes
+ * @param node Node id
+ * @return 0 on success, -1 if not supported
+ */
+int fir_numa_bind(void* addr, size_t len, int node);
+
+/**
+ * @brief Node holding the page at an address (the page must be allocated).
+ *
+ * @return Node id, or -1 if unknown
+ */
+int fir_numa_node_of(const void* addr);
+
+/**
+ * @brief Restrict the calling thread to the CPUs of a node.
+ *
+ * @return 0 on success, -1 on error
+ */
+int fir_numa_run_on_node(int node);
+
+#endif
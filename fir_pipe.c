@@ -0,0 +1,367 @@
+#define _GNU_SOURCE
+#include "fir_filter.h"
+#include "fir_cli.h"
+#include "fir_stream.h"
+#include "fir_wav.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Input frames read per block
+#define PIPE_BLOCK 65536
+
+// Output buffer size when stdout is not a pipe
+#define PIPE_OUT_SIZE (1 << 20)
+
+// Output side: a page-aligned buffer that is filled and flushed. When stdout
+// is a pipe, full buffers are handed to it with vmsplice instead of being
+// copied. The pipe then refers to the buffer's pages until the reader has
+// consumed them, which the writer cannot observe, so the pages are given
+// away (SPLICE_F_GIFT) and the buffer is replaced by fresh ones.
+struct output {
+    int fd;
+    int use_vmsplice;
+    size_t size;
+    char* buf;
+    size_t fill;
+};
+
+void print_usage(const char* prog_name) {
+    fprintf(stderr, "Usage: %s [options] <numtaps> <fs> <window_type> <cutoff1> [cutoff2 ...]\n", prog_name);
+    fprintf(stderr, "  Filters samples from stdin to stdout.\n");
+    fprintf(stderr, "  -f format:   Input format: f32 (default), s16, s24, s32, cf32 (interleaved complex float) or wav\n");
+    fprintf(stderr, "  -o format:   Output format: f32, s16, s24 or s32 (default: same as the input)\n");
+    fprintf(stderr, "  -c channels: Number of interleaved channels of raw input (default 1)\n");
+    fprintf(stderr, "  -d factor:   Keep every factor-th output sample (default 1)\n");
+    fprintf(stderr, "  -D:          Add TPDF dither when writing integer samples\n");
+    fprintf(stderr, "  The filter arguments are the same as for auto_test. WAV input gives WAV output.\n");
+    fprintf(stderr, "\nExample: %s -f s16 -d 4 101 48000 hann 0 5000 < in.raw > out.raw\n", prog_name);
+    fprintf(stderr, "Example: %s -f wav -o s16 -D 101 96000 hann 0 20000 < in.wav > out.wav\n", prog_name);
+}
+
+static int parse_format(const char* str, enum fir_sample_format* format) {
+    if (strcmp(str, "f32") == 0) *format = FIR_FORMAT_F32;
+    else if (strcmp(str, "s16") == 0) *format = FIR_FORMAT_S16;
+    else if (strcmp(str, "s24") == 0) *format = FIR_FORMAT_S24;
+    else if (strcmp(str, "s32") == 0) *format = FIR_FORMAT_S32;
+    else return -1;
+    return 0;
+}
+
+static int write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t r = write(fd, data, len);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += r;
+        len -= r;
+    }
+    return 0;
+}
+
+static int output_init(struct output* out, int fd) {
+    memset(out, 0, sizeof(*out));
+    out->fd = fd;
+    out->size = PIPE_OUT_SIZE;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode)) {
+        int size = fcntl(fd, F_SETPIPE_SZ, PIPE_OUT_SIZE);
+        if (size < 0) {
+            size = fcntl(fd, F_GETPIPE_SZ);
+        }
+        if (size > 0) {
+            out->size = size;
+            out->use_vmsplice = 1;
+        }
+    }
+
+    void* p = mmap(NULL, out->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    out->buf = p == MAP_FAILED ? NULL : (char*)p;
+    return out->buf ? 0 : -1;
+}
+
+static int output_flush(struct output* out) {
+    char* data = out->buf;
+    size_t len = out->fill;
+    int gifted = 0;
+
+    while (len > 0 && out->use_vmsplice) {
+        struct iovec iov = { data, len };
+        ssize_t r = vmsplice(out->fd, &iov, 1, SPLICE_F_GIFT);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            // Not supported here: copy from now on
+            out->use_vmsplice = 0;
+            break;
+        }
+        gifted = 1;
+        data += r;
+        len -= r;
+    }
+    if (len > 0 && write_all(out->fd, data, len) != 0) {
+        return -1;
+    }
+
+    // Unmapping leaves the gifted pages to the pipe; new writes go to fresh
+    // pages
+    if (gifted) {
+        munmap(out->buf, out->size);
+        void* p = mmap(NULL, out->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            out->buf = NULL;
+            return -1;
+        }
+        out->buf = (char*)p;
+    }
+    out->fill = 0;
+    return 0;
+}
+
+static int output_free(struct output* out) {
+    int result = out->fill > 0 ? output_flush(out) : 0;
+    if (out->buf) {
+        munmap(out->buf, out->size);
+    }
+    return result;
+}
+
+// Read up to len bytes, stopping early only at end of input
+static ssize_t read_full(int fd, char* data, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t r = read(fd, data + got, len - got);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (r == 0) break;
+        got += r;
+    }
+    return got;
+}
+
+int main(int argc, char* argv[]) {
+    enum fir_sample_format in_format = FIR_FORMAT_F32;
+    enum fir_sample_format out_format = FIR_FORMAT_F32;
+    int have_out_format = 0;
+    int channels = 1;
+    int wav = 0;
+    int factor = 1;
+    int dither = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:o:c:d:D")) != -1) {
+        if (opt == 'f') {
+            if (strcmp(optarg, "cf32") == 0) {
+                in_format = FIR_FORMAT_F32;
+                channels = 2;
+            } else if (strcmp(optarg, "wav") == 0) {
+                wav = 1;
+            } else if (parse_format(optarg, &in_format) != 0) {
+                fprintf(stderr, "Error: Unknown sample format '%s'.\n", optarg);
+                return 1;
+            }
+        } else if (opt == 'o') {
+            if (parse_format(optarg, &out_format) != 0) {
+                fprintf(stderr, "Error: Unknown sample format '%s'.\n", optarg);
+                return 1;
+            }
+            have_out_format = 1;
+        } else if (opt == 'c') {
+            channels = atoi(optarg);
+            if (channels < 1) {
+                fprintf(stderr, "Error: Number of channels must be at least 1.\n");
+                return 1;
+            }
+        } else if (opt == 'd') {
+            factor = atoi(optarg);
+            if (factor < 1) {
+                fprintf(stderr, "Error: Decimation factor must be at least 1.\n");
+                return 1;
+            }
+        } else if (opt == 'D') {
+            dither = 1;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Check minimum number of arguments
+    if (argc - optind < 4) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // Parse the filter arguments
+    int numtaps = atoi(argv[optind]);
+    float fs = (float)atof(argv[optind + 1]);
+    int window_type = parse_window_type(argv[optind + 2]);
+    if (window_type == -1) {
+        fprintf(stderr, "Error: Invalid window type.\n");
+        return 1;
+    }
+
+    int num_cutoffs = argc - optind - 3;
+    if (num_cutoffs % 2 != 0) {
+        fprintf(stderr, "Error: Number of cutoff frequencies must be even.\n");
+        return 1;
+    }
+
+    float* cutoffs = (float*)malloc(num_cutoffs * sizeof(float));
+    float* h = (float*)malloc((numtaps > 0 ? numtaps : 1) * sizeof(float));
+    if (!cutoffs || !h) {
+        fprintf(stderr, "Error: Memory allocation failed.\n");
+        return 1;
+    }
+    for (int i = 0; i < num_cutoffs; i++) {
+        cutoffs[i] = (float)atof(argv[optind + 3 + i]);
+    }
+
+    if (firwin(numtaps, num_cutoffs, cutoffs, fs, window_type, h) != 0) {
+        fprintf(stderr, "Error designing filter.\n");
+        return 1;
+    }
+    free(cutoffs);
+
+    // The container decides the input layout; the output gets the same
+    // header at the decimated rate
+    struct fir_wav_info info;
+    long long remaining = -1;   // Input frames left, if the header says
+    if (wav) {
+        if (fir_wav_read_header(STDIN_FILENO, &info) != 0) {
+            fprintf(stderr, "Error: Unsupported or invalid WAV input.\n");
+            return 1;
+        }
+        in_format = info.format;
+        channels = info.channels;
+        remaining = info.frames;
+    }
+    if (!have_out_format) {
+        out_format = in_format;
+    }
+    if (wav) {
+        info.format = out_format;
+        info.rate = (info.rate + factor / 2) / factor;
+        info.frames = -1;
+        if (fir_wav_write_header(STDOUT_FILENO, &info) != 0) {
+            perror("write");
+            return 1;
+        }
+    }
+
+    // One stream per channel, each reading and writing its own column of
+    // the interleaved frames
+    const int in_sample = fir_format_size(in_format);
+    const int out_sample = fir_format_size(out_format);
+    const size_t in_frame = (size_t)in_sample * channels;
+    const size_t out_frame = (size_t)out_sample * channels;
+    struct fir_stream** streams = (struct fir_stream**)calloc(channels, sizeof(struct fir_stream*));
+    if (!streams) {
+        fprintf(stderr, "Error: Memory allocation failed.\n");
+        return 1;
+    }
+    for (int c = 0; c < channels; c++) {
+        streams[c] = fir_stream_create(h, numtaps);
+        if (!streams[c]) {
+            fprintf(stderr, "Error: Memory allocation failed.\n");
+            return 1;
+        }
+        if (fir_stream_set_format(streams[c], in_format, out_format, channels, dither) != 0) {
+            fprintf(stderr, "Error: Unsupported sample format conversion.\n");
+            return 1;
+        }
+    }
+    free(h);
+
+    char* raw = (char*)malloc(PIPE_BLOCK * in_frame);
+    struct output out;
+    if (!raw || output_init(&out, STDOUT_FILENO) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed.\n");
+        return 1;
+    }
+    if (out.size < 2 * out_frame) {
+        fprintf(stderr, "Error: Output frames of %zu bytes do not fit the output pipe (%zu bytes).\n",
+                out_frame, out.size);
+        return 1;
+    }
+
+    int status = 0;
+    long long written = 0;
+    for (;;) {
+        // Chunks after a WAV data chunk of known size are not samples
+        size_t want = PIPE_BLOCK * in_frame;
+        if (remaining >= 0 && (long long)PIPE_BLOCK > remaining) {
+            want = (size_t)remaining * in_frame;
+        }
+        ssize_t got = want > 0 ? read_full(STDIN_FILENO, raw, want) : 0;
+        if (got < 0) {
+            perror("read");
+            status = 1;
+            break;
+        }
+
+        // A trailing partial frame is dropped
+        int n = (int)(got / in_frame);
+        if (remaining >= 0) {
+            remaining -= n;
+        }
+
+        // The streams convert, filter and write straight into the output
+        // buffer, in pieces that fit the space left in it
+        int pos = 0;
+        while (pos < n && status == 0) {
+            int room = (int)((out.size - out.fill) / out_frame);
+            int len = n - pos;
+            if ((long long)room * factor < len) {
+                len = room * factor;
+            }
+
+            int count = 0;
+            for (int c = 0; c < channels; c++) {
+                count = fir_stream_decimate_raw(streams[c], raw + pos * in_frame + (size_t)c * in_sample,
+                                                out.buf + out.fill + (size_t)c * out_sample,
+                                                len, factor);
+            }
+            out.fill += count * out_frame;
+            written += count;
+            pos += len;
+
+            if (out.fill + out_frame > out.size && output_flush(&out) != 0) {
+                perror("write");
+                status = 1;
+            }
+        }
+        if (status != 0 || got < (ssize_t)(PIPE_BLOCK * in_frame)) break;
+    }
+
+    if (output_free(&out) != 0 && status == 0) {
+        perror("write");
+        status = 1;
+    }
+
+    // Fill in the sizes when writing to a file; on a pipe they stay unknown
+    struct stat st;
+    if (wav && status == 0 && fstat(STDOUT_FILENO, &st) == 0 && S_ISREG(st.st_mode)) {
+        info.frames = written;
+        if (fir_wav_finish(STDOUT_FILENO, &info) != 0) {
+            perror("Error: Cannot fill in the WAV sizes");
+            status = 1;
+        }
+    }
+
+    for (int c = 0; c < channels; c++) {
+        fir_stream_destroy(streams[c]);
+    }
+    free(streams);
+    free(raw);
+    return status;
+}
@@ -0,0 +1,123 @@
+#include "fir_pool.h"
+#include "fir_numa.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+struct pool_worker {
+    struct fir_pool* pool;
+    int index;
+    int node;
+    pthread_t thread;
+};
+
+struct fir_pool {
+    int size;
+    struct pool_worker* workers;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned long generation;   // Incremented for every job
+    int pending;                // Workers still running the current job
+    int stop;
+    void (*fn)(void* arg, int worker);
+    void* arg;
+};
+
+static void* worker_main(void* p) {
+    struct pool_worker* worker = (struct pool_worker*)p;
+    struct fir_pool* pool = worker->pool;
+
+    if (worker->node >= 0) {
+        fir_numa_run_on_node(worker->node);
+    }
+
+    // Generation 0 is never run, so a job posted before this thread got
+    // here is not missed
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->stop) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->stop) {
+            break;
+        }
+        seen = pool->generation;
+
+        pthread_mutex_unlock(&pool->lock);
+        pool->fn(pool->arg, worker->index);
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+struct fir_pool* fir_pool_create(int workers, const int* nodes) {
+    if (workers < 1) {
+        return NULL;
+    }
+
+    struct fir_pool* pool = (struct fir_pool*)calloc(1, sizeof(struct fir_pool));
+    if (!pool) {
+        return NULL;
+    }
+    pool->workers = (struct pool_worker*)calloc(workers, sizeof(struct pool_worker));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (int i = 0; i < workers; i++) {
+        struct pool_worker* worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        worker->node = nodes ? nodes[i] : -1;
+        if (pthread_create(&worker->thread, NULL, worker_main, worker) != 0) {
+            // Shut down the workers started so far
+            pool->size = i;
+            fir_pool_destroy(pool);
+            return NULL;
+        }
+        pool->size = i + 1;
+    }
+    return pool;
+}
+
+void fir_pool_destroy(struct fir_pool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->size; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->workers);
+    free(pool);
+}
+
+void fir_pool_run(struct fir_pool* pool, void (*fn)(void* arg, int worker), void* arg) {
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->pending = pool->size;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,27 @@
+#ifndef FIR_POOL_H
+#define FIR_POOL_H
+
+// Persistent worker threads for the parallel engines (internal header).
+
+struct fir_pool;
+
+/**
+ * @brief Create a pool of worker threads.
+ *
+ * @param workers Number of workers (at least 1)
+ * @param nodes NUMA node each worker is restricted to, or NULL for no restriction
+ * @return New pool, or NULL on error
+ */
+struct fir_pool* fir_pool_create(int workers, const int* nodes);
+
+/**
+ * @brief Stop the workers and destroy the pool.
+ */
+void fir_pool_destroy(struct fir_pool* pool);
+
+/**
+ * @brief Run fn(arg, worker) on every worker and wait until all have returned.
+ */
+void fir_pool_run(struct fir_pool* pool, void (*fn)(void* arg, int worker), void* arg);
+
+#endif
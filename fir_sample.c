@@ -0,0 +1,196 @@
+#include "fir_sample.h"
+#include "fir_alloc.h"
+#include "fir_cpu.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Taps are padded to a multiple of this, one AVX-512 vector, so the kernels
+// have no tails
+#define FIR_SAMPLE_WIDTH 16
+
+typedef float (*sample_kernel)(struct fir_sample* filter, float x);
+
+struct fir_sample {
+    sample_kernel push;     // Per form and instruction set
+    enum fir_sample_form form;
+    int len;                // Padded length of the tap and state vectors
+    int pos;                // Direct form: start of the window; transposed: current slot
+    float h0;               // Direct form: the first tap
+
+    // Direct form: taps h[1..len] and 2 * len samples of history, newest
+    // first from pos. Transposed form: h[0..len) twice in a row and one
+    // partial output per slot, slot pos being the next output.
+    float* taps;
+    float* state;
+};
+
+// The first tap is applied to the new sample separately and the dot product
+// only reads samples stored by earlier calls, so the vector loads never wait
+// for the store of the new sample
+static inline void direct_store(struct fir_sample* f, float x) {
+    f->pos = f->pos == 0 ? f->len - 1 : f->pos - 1;
+    f->state[f->pos] = x;
+    f->state[f->pos + f->len] = x;
+}
+
+static float direct_scalar(struct fir_sample* f, float x) {
+    const float* w = f->state + f->pos;
+    const float* h = f->taps;
+    float acc = 0.0f;
+    for (int k = 0; k < f->len; k++) {
+        acc += h[k] * w[k];
+    }
+    direct_store(f, x);
+    return f->h0 * x + acc;
+}
+
+// Output t + j collects h[j] * x in slot (t + j) % len. The taps are read at
+// an offset that moves with t, while the slots stay put, so each vector of
+// partial sums is loaded from exactly where the previous call stored it.
+static inline const float* transposed_taps(struct fir_sample* f) {
+    return f->taps + f->len - f->pos;
+}
+
+static inline float transposed_finish(struct fir_sample* f) {
+    float y = f->state[f->pos];
+    f->state[f->pos] = 0.0f;
+    f->pos = f->pos + 1 == f->len ? 0 : f->pos + 1;
+    return y;
+}
+
+static float transposed_scalar(struct fir_sample* f, float x) {
+    const float* h = transposed_taps(f);
+    float* s = f->state;
+    for (int k = 0; k < f->len; k++) {
+        s[k] += h[k] * x;
+    }
+    return transposed_finish(f);
+}
+
+#if FIR_X86
+__attribute__((target("avx2,fma")))
+static float direct_avx2(struct fir_sample* f, float x) {
+    const float* w = f->state + f->pos;
+    const float* h = f->taps;
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (int k = 0; k < f->len; k += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(h + k), _mm256_loadu_ps(w + k), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(h + k + 8), _mm256_loadu_ps(w + k + 8), acc1);
+    }
+    direct_store(f, x);
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return f->h0 * x + _mm_cvtss_f32(sum);
+}
+
+__attribute__((target("avx2,fma")))
+static float transposed_avx2(struct fir_sample* f, float x) {
+    const float* h = transposed_taps(f);
+    float* s = f->state;
+    __m256 xv = _mm256_set1_ps(x);
+    for (int k = 0; k < f->len; k += 8) {
+        _mm256_store_ps(s + k, _mm256_fmadd_ps(_mm256_loadu_ps(h + k), xv, _mm256_load_ps(s + k)));
+    }
+    return transposed_finish(f);
+}
+
+__attribute__((target("avx512f")))
+static float direct_avx512(struct fir_sample* f, float x) {
+    const float* w = f->state + f->pos;
+    const float* h = f->taps;
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    int k = 0;
+    for (; k + 32 <= f->len; k += 32) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(h + k), _mm512_loadu_ps(w + k), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(h + k + 16), _mm512_loadu_ps(w + k + 16), acc1);
+    }
+    if (k < f->len) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(h + k), _mm512_loadu_ps(w + k), acc0);
+    }
+    direct_store(f, x);
+    return f->h0 * x + _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+__attribute__((target("avx512f")))
+static float transposed_avx512(struct fir_sample* f, float x) {
+    const float* h = transposed_taps(f);
+    float* s = f->state;
+    __m512 xv = _mm512_set1_ps(x);
+    for (int k = 0; k < f->len; k += 16) {
+        _mm512_store_ps(s + k, _mm512_fmadd_ps(_mm512_loadu_ps(h + k), xv, _mm512_load_ps(s + k)));
+    }
+    return transposed_finish(f);
+}
+#endif
+
+static sample_kernel select_kernel(enum fir_sample_form form) {
+    const int transposed = form == FIR_SAMPLE_TRANSPOSED;
+#if FIR_X86
+    if (fir_cpu_has_avx512()) return transposed ? transposed_avx512 : direct_avx512;
+    if (fir_cpu_has_avx2()) return transposed ? transposed_avx2 : direct_avx2;
+#endif
+    return transposed ? transposed_scalar : direct_scalar;
+}
+
+static size_t state_size(const struct fir_sample* filter) {
+    const size_t len = filter->form == FIR_SAMPLE_DIRECT ? 2 * (size_t)filter->len : (size_t)filter->len;
+    return len * sizeof(float);
+}
+
+struct fir_sample* fir_sample_create(const float* taps, int numtaps, enum fir_sample_form form) {
+    if (!taps || numtaps <= 0 || (form != FIR_SAMPLE_DIRECT && form != FIR_SAMPLE_TRANSPOSED)) {
+        return NULL;
+    }
+
+    struct fir_sample* filter = (struct fir_sample*)calloc(1, sizeof(struct fir_sample));
+    if (!filter) {
+        return NULL;
+    }
+    filter->form = form;
+    filter->push = select_kernel(form);
+
+    // The direct form's vectors leave out the first tap, the transposed
+    // form's slots must outnumber the taps; neither is empty
+    int len = form == FIR_SAMPLE_DIRECT ? numtaps - 1 : numtaps;
+    len = len > 0 ? len : 1;
+    filter->len = (len + FIR_SAMPLE_WIDTH - 1) / FIR_SAMPLE_WIDTH * FIR_SAMPLE_WIDTH;
+
+    const size_t taps_size = 2 * (size_t)filter->len * sizeof(float);
+    filter->taps = (float*)fir_alloc(taps_size, "fir_sample.taps");
+    filter->state = (float*)fir_alloc(state_size(filter), "fir_sample.state");
+    if (!filter->taps || !filter->state) {
+        fir_sample_destroy(filter);
+        return NULL;
+    }
+    memset(filter->taps, 0, taps_size);
+    if (form == FIR_SAMPLE_DIRECT) {
+        filter->h0 = taps[0];
+        memcpy(filter->taps, taps + 1, (numtaps - 1) * sizeof(float));
+    } else {
+        memcpy(filter->taps, taps, numtaps * sizeof(float));
+        memcpy(filter->taps + filter->len, taps, numtaps * sizeof(float));
+    }
+    fir_sample_reset(filter);
+    return filter;
+}
+
+void fir_sample_destroy(struct fir_sample* filter) {
+    if (!filter) return;
+    fir_free(filter->taps);
+    fir_free(filter->state);
+    free(filter);
+}
+
+void fir_sample_reset(struct fir_sample* filter) {
+    if (!filter) return;
+    memset(filter->state, 0, state_size(filter));
+    filter->pos = 0;
+}
+
+float fir_sample_push(struct fir_sample* filter, float x) {
+    return filter->push(filter, x);
+}
@@ -0,0 +1,58 @@
+#ifndef FIR_SAMPLE_H
+#define FIR_SAMPLE_H
+
+// Sample-by-sample FIR filter for control loops.
+//
+// fir_sample_push() takes one input sample and returns the matching output
+// right away, with no block buffering, at a cost of numtaps multiply-adds
+// and no data movement:
+//
+// - FIR_SAMPLE_DIRECT keeps the history in a circular buffer of twice the
+//   filter length, with every sample written twice, so the most recent
+//   samples are always contiguous and the output is one vector dot product.
+// - FIR_SAMPLE_TRANSPOSED is the transposed direct form: each input adds its
+//   products with all taps to the partial sums of the next numtaps outputs,
+//   kept in a circular set of slots, and the oldest slot is the output.
+//   There is no final horizontal sum, and each output is accumulated from
+//   the oldest input to the newest.
+//
+// Both are meant for filters up to a few hundred taps, e.g. from firwin().
+// The taps are padded to a multiple of the vector width.
+
+enum fir_sample_form {
+    FIR_SAMPLE_DIRECT = 0,
+    FIR_SAMPLE_TRANSPOSED = 1
+};
+
+struct fir_sample;
+
+/**
+ * @brief Create a sample-by-sample filter.
+ *
+ * @param taps Filter coefficients (copied)
+ * @param numtaps Number of taps
+ * @param form Filter structure
+ * @return New filter, or NULL on error
+ */
+struct fir_sample* fir_sample_create(const float* taps, int numtaps, enum fir_sample_form form);
+
+/**
+ * @brief Destroy a filter created with fir_sample_create().
+ */
+void fir_sample_destroy(struct fir_sample* filter);
+
+/**
+ * @brief Clear the history, as if the filter had just been created.
+ */
+void fir_sample_reset(struct fir_sample* filter);
+
+/**
+ * @brief Filter one sample.
+ *
+ * @param filter Filter (not checked for NULL, to keep the call short)
+ * @param x Input sample
+ * @return Output sample
+ */
+float fir_sample_push(struct fir_sample* filter, float x);
+
+#endif
@@ -0,0 +1,395 @@
+#define _GNU_SOURCE
+#include "fir_service.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SERVICE_MAGIC 0x46495231u    // "FIR1"
+#define SERVICE_MAX_CUTOFFS 64
+// Designs run on the server's only thread, so their size is bounded to keep
+// one request from stalling the others (a few milliseconds at most)
+#define SERVICE_MAX_TAPS (1 << 16)
+
+// Clients being served at the same time
+#define SERVICE_MAX_CLIENTS 64
+
+// Time a client has to send its request before it is disconnected
+#define SERVICE_CLIENT_TIMEOUT_MS 2000
+
+// Requests are fixed size, with unused cutoffs zeroed, so a request is also
+// its own cache key
+struct service_request {
+    uint32_t magic;
+    int32_t numtaps;
+    int32_t window;
+    int32_t cutoff_count;
+    float fs;
+    float cutoffs[SERVICE_MAX_CUTOFFS];
+};
+
+struct service_reply {
+    int32_t status;     // 0 with a memfd attached, or -1
+    int32_t numtaps;
+};
+
+struct service_entry {
+    struct service_request key;
+    int fd;             // Sealed memfd holding the taps, or -1 if unused
+};
+
+struct service_client {
+    int fd;             // -1 if unused
+    size_t got;
+    long long deadline; // In now_ms() time
+    struct service_request request;
+};
+
+static int fill_request(struct service_request* req, int numtaps, int cutoff_count,
+                        const float* cutoffs, float fs, enum fir_filter_window_type window) {
+    if (numtaps <= 0 || numtaps > SERVICE_MAX_TAPS || cutoff_count <= 0 ||
+        cutoff_count > SERVICE_MAX_CUTOFFS || !cutoffs) {
+        return -1;
+    }
+    memset(req, 0, sizeof(*req));
+    req->magic = SERVICE_MAGIC;
+    req->numtaps = numtaps;
+    req->window = window;
+    req->cutoff_count = cutoff_count;
+    req->fs = fs;
+    memcpy(req->cutoffs, cutoffs, cutoff_count * sizeof(float));
+    return 0;
+}
+
+static int open_socket(const char* path, struct sockaddr_un* addr) {
+    if (!path || strlen(path) >= sizeof(addr->sun_path)) {
+        return -1;
+    }
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    strcpy(addr->sun_path, path);
+    return socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+}
+
+const float* fir_service_design(const char* path, int numtaps, int cutoff_count,
+                                const float* cutoffs, float fs,
+                                enum fir_filter_window_type window) {
+    struct service_request req;
+    if (fill_request(&req, numtaps, cutoff_count, cutoffs, fs, window) != 0) {
+        return NULL;
+    }
+
+    struct sockaddr_un addr;
+    int sock = open_socket(path, &addr);
+    if (sock < 0) {
+        return NULL;
+    }
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        send(sock, &req, sizeof(req), MSG_NOSIGNAL) != (ssize_t)sizeof(req)) {
+        close(sock);
+        return NULL;
+    }
+
+    struct service_reply reply;
+    struct iovec iov = { &reply, sizeof(reply) };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t r;
+    do {
+        r = recvmsg(sock, &msg, MSG_WAITALL | MSG_CMSG_CLOEXEC);
+    } while (r < 0 && errno == EINTR);
+    close(sock);
+
+    int fd = -1;
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (r > 0 && cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+    if (r != (ssize_t)sizeof(reply) || reply.status != 0 || reply.numtaps != numtaps || fd < 0) {
+        if (fd >= 0) close(fd);
+        return NULL;
+    }
+
+    void* taps = mmap(NULL, numtaps * sizeof(float), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return taps == MAP_FAILED ? NULL : (const float*)taps;
+}
+
+void fir_service_release(const float* taps, int numtaps) {
+    if (!taps || numtaps <= 0) return;
+    munmap((void*)taps, numtaps * sizeof(float));
+}
+
+// Design into a new memfd and seal it, so clients can map but never change it
+static int design_memfd(const struct service_request* req) {
+    size_t size = req->numtaps * sizeof(float);
+    int fd = memfd_create("firwin", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        return -1;
+    }
+    if (ftruncate(fd, size) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    float* taps = (float*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (taps == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    int result = firwin(req->numtaps, req->cutoff_count, req->cutoffs, req->fs,
+                        (enum fir_filter_window_type)req->window, taps);
+    munmap(taps, size);
+
+    if (result != 0 ||
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void send_reply(int sock, int numtaps, int fd) {
+    struct service_reply reply = { fd >= 0 ? 0 : -1, numtaps };
+    struct iovec iov = { &reply, sizeof(reply) };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    if (fd >= 0) {
+        memset(&control, 0, sizeof(control));
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+    sendmsg(sock, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+// Look the request up in the cache, designing and adding it if needed.
+// Returns the memfd (owned by the cache), or -1.
+static int lookup(struct service_entry* cache, int max_entries, int* next,
+                  struct service_request* req) {
+    // Normalize the key: unused cutoffs do not matter
+    memset(req->cutoffs + req->cutoff_count, 0,
+           (SERVICE_MAX_CUTOFFS - req->cutoff_count) * sizeof(float));
+
+    for (int i = 0; i < max_entries; i++) {
+        if (cache[i].fd >= 0 && memcmp(&cache[i].key, req, sizeof(*req)) == 0) {
+            return cache[i].fd;
+        }
+    }
+
+    int fd = design_memfd(req);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // Replace the oldest entry; clients that mapped it keep their pages
+    struct service_entry* entry = &cache[*next];
+    *next = (*next + 1) % max_entries;
+    if (entry->fd >= 0) {
+        close(entry->fd);
+    }
+    entry->key = *req;
+    entry->fd = fd;
+    return fd;
+}
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+// Remove a socket left behind by a server that is gone. Anything else at
+// path (a file, a directory, a symlink) and a socket with a live server are
+// left alone and make the server fail.
+static int clear_path(const char* path, const struct sockaddr_un* addr) {
+    struct stat st;
+    if (lstat(path, &st) != 0) {
+        return errno == ENOENT ? 0 : -1;
+    }
+    if (!S_ISSOCK(st.st_mode)) {
+        errno = EEXIST;
+        return -1;
+    }
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0) {
+        return -1;
+    }
+    int live = connect(probe, (const struct sockaddr*)addr, sizeof(*addr)) == 0;
+    close(probe);
+    if (live) {
+        errno = EADDRINUSE;
+        return -1;
+    }
+    return unlink(path) == 0 || errno == ENOENT ? 0 : -1;
+}
+
+int fir_service_serve(const char* path, int max_entries, volatile sig_atomic_t* stop) {
+    if (max_entries < 1 || !stop) {
+        return -1;
+    }
+
+    struct sockaddr_un addr;
+    int listener = open_socket(path, &addr);
+    if (listener < 0) {
+        return -1;
+    }
+    if (clear_path(path, &addr) != 0 ||
+        bind(listener, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(listener, SERVICE_MAX_CLIENTS) != 0) {
+        close(listener);
+        return -1;
+    }
+
+    struct service_entry* cache = (struct service_entry*)calloc(max_entries, sizeof(struct service_entry));
+    struct service_client clients[SERVICE_MAX_CLIENTS];
+    struct pollfd fds[SERVICE_MAX_CLIENTS + 1];
+    if (!cache) {
+        close(listener);
+        unlink(path);
+        return -1;
+    }
+    for (int i = 0; i < max_entries; i++) {
+        cache[i].fd = -1;
+    }
+    for (int i = 0; i < SERVICE_MAX_CLIENTS; i++) {
+        clients[i].fd = -1;
+    }
+    int next = 0;
+    int result = 0;
+
+    // SIGINT and SIGTERM are let through only while waiting in ppoll(), so a
+    // signal that sets *stop just after the check still ends the wait
+    sigset_t block, wait_mask;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, &wait_mask);
+
+    while (!*stop) {
+        // Wait until the earliest client deadline at most
+        long long now = now_ms();
+        long long wake = -1;
+        fds[0].fd = listener;
+        fds[0].events = POLLIN;
+        for (int i = 0; i < SERVICE_MAX_CLIENTS; i++) {
+            fds[i + 1].fd = clients[i].fd;
+            fds[i + 1].events = POLLIN;
+            if (clients[i].fd >= 0 && (wake < 0 || clients[i].deadline < wake)) {
+                wake = clients[i].deadline;
+            }
+        }
+        struct timespec timeout;
+        if (wake >= 0) {
+            long long wait = wake > now ? wake - now : 0;
+            timeout.tv_sec = wait / 1000;
+            timeout.tv_nsec = wait % 1000 * 1000000;
+        }
+
+        if (ppoll(fds, SERVICE_MAX_CLIENTS + 1, wake >= 0 ? &timeout : NULL, &wait_mask) < 0) {
+            if (errno == EINTR) continue;
+            result = -1;
+            break;
+        }
+        now = now_ms();
+
+        // Requests arrive in pieces at most; a client is answered and
+        // disconnected as soon as its request is complete, or dropped when
+        // it has not sent it in time
+        for (int i = 0; i < SERVICE_MAX_CLIENTS; i++) {
+            struct service_client* c = &clients[i];
+            if (c->fd < 0) {
+                continue;
+            }
+            if (!(fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR))) {
+                if (now >= c->deadline) {
+                    close(c->fd);
+                    c->fd = -1;
+                }
+                continue;
+            }
+
+            ssize_t r = recv(c->fd, (char*)&c->request + c->got, sizeof(c->request) - c->got,
+                             MSG_DONTWAIT);
+            if (r < 0 && (errno == EAGAIN || errno == EINTR)) {
+                continue;
+            }
+            if (r > 0) {
+                c->got += r;
+                if (c->got < sizeof(c->request)) {
+                    continue;
+                }
+                struct service_request* req = &c->request;
+                int fd = -1;
+                if (req->magic == SERVICE_MAGIC && req->numtaps > 0 &&
+                    req->numtaps <= SERVICE_MAX_TAPS && req->cutoff_count > 0 &&
+                    req->cutoff_count <= SERVICE_MAX_CUTOFFS) {
+                    fd = lookup(cache, max_entries, &next, req);
+                }
+                send_reply(c->fd, req->numtaps, fd);
+            }
+            close(c->fd);
+            c->fd = -1;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int sock = accept4(listener, NULL, NULL, SOCK_CLOEXEC);
+            if (sock >= 0) {
+                int slot = -1;
+                for (int i = 0; i < SERVICE_MAX_CLIENTS && slot < 0; i++) {
+                    if (clients[i].fd < 0) slot = i;
+                }
+                if (slot < 0) {
+                    // Too busy: the client sees the connection close
+                    close(sock);
+                } else {
+                    clients[slot].fd = sock;
+                    clients[slot].got = 0;
+                    clients[slot].deadline = now + SERVICE_CLIENT_TIMEOUT_MS;
+                }
+            }
+        }
+    }
+
+    pthread_sigmask(SIG_SETMASK, &wait_mask, NULL);
+
+    for (int i = 0; i < SERVICE_MAX_CLIENTS; i++) {
+        if (clients[i].fd >= 0) close(clients[i].fd);
+    }
+    for (int i = 0; i < max_entries; i++) {
+        if (cache[i].fd >= 0) close(cache[i].fd);
+    }
+    free(cache);
+    close(listener);
+    unlink(path);
+    return result;
+}
@@ -0,0 +1,54 @@
+#ifndef FIR_SERVICE_H
+#define FIR_SERVICE_H
+
+#include "fir_filter.h"
+#include <signal.h>
+
+// Local filter design service.
+//
+// A server (see fir_designd) designs filters with firwin() on behalf of the
+// processes of one host and keeps the results in a cache. Each design lives
+// in a sealed memfd that is passed to clients over the Unix socket
+// (SCM_RIGHTS), so every client maps the same read-only pages: repeated
+// requests are neither redesigned nor copied.
+
+/**
+ * @brief Design a filter through the service, like firwin().
+ *
+ * @param path Path of the server's Unix socket
+ * @param numtaps Number of taps (at most 65536)
+ * @param cutoff_count Number of cutoffs (at most 64)
+ * @param cutoffs Cutoff frequencies in Hz
+ * @param fs Sampling frequency in Hz
+ * @param window Window type
+ * @return Read-only taps shared with the server, to be released with fir_service_release(), or NULL on error
+ */
+const float* fir_service_design(const char* path, int numtaps, int cutoff_count,
+                                const float* cutoffs, float fs,
+                                enum fir_filter_window_type window);
+
+/**
+ * @brief Release taps returned by fir_service_design().
+ *
+ * @param taps Taps
+ * @param numtaps Number of taps, as requested
+ */
+void fir_service_release(const float* taps, int numtaps);
+
+/**
+ * @brief Run a design server until *stop becomes nonzero (e.g. set by a signal handler).
+ *
+ * The socket is created at path and removed on return. A socket file left behind by a server that is no longer running is replaced;
+ * if anything else exists at path, or another server is listening on it, the call fails.
+ *
+ * SIGINT and SIGTERM are blocked in the calling thread while the server runs, except while it waits for clients, so a handler for
+ * them that sets *stop is never missed. Clients that do not send a complete request within 2 seconds are disconnected.
+ *
+ * @param path Path of the Unix socket
+ * @param max_entries Maximum number of cached designs; the oldest is dropped when full
+ * @param stop Stop flag
+ * @return 0 when stopped, -1 on error
+ */
+int fir_service_serve(const char* path, int max_entries, volatile sig_atomic_t* stop);
+
+#endif
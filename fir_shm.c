@@ -0,0 +1,342 @@
+#include "fir_shm.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SHM_CONTROL_MAGIC 0x46495243u   // "FIRC"
+#define SHM_BANK_MAGIC 0x46495242u      // "FIRB"
+
+// Attempts to attach while generations are being swapped
+#define SHM_ATTACH_TRIES 16
+
+// Control object: the current generation (0 if none has been published)
+struct shm_control {
+    uint32_t magic;
+    uint32_t reserved;
+    int64_t generation;
+};
+
+// Header of a generation object; the taps follow it
+struct shm_header {
+    uint32_t magic;
+    int32_t numtaps;
+    int32_t filters;
+    int32_t reserved;
+    int64_t generation;
+} __attribute__((aligned(64)));
+
+struct fir_shm_writer {
+    char name[NAME_MAX];
+    int fd;
+    struct shm_header* header;
+    size_t size;
+};
+
+struct fir_shm_bank {
+    char name[NAME_MAX];
+    const struct shm_control* control;
+    const struct shm_header* header;
+    size_t size;
+};
+
+static int generation_name(char* out, const char* name, long long generation) {
+    int len = snprintf(out, NAME_MAX, "%s.%lld", name, generation);
+    return (len > 0 && len < NAME_MAX) ? 0 : -1;
+}
+
+static size_t bank_size(int numtaps, int filters) {
+    return sizeof(struct shm_header) + (size_t)numtaps * filters * sizeof(float);
+}
+
+// Map the control object, creating it if needed
+static struct shm_control* map_control(const char* name, int writable) {
+    int fd = writable ? shm_open(name, O_RDWR | O_CREAT, 0644) : shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        ((size_t)st.st_size < sizeof(struct shm_control) &&
+         (!writable || ftruncate(fd, sizeof(struct shm_control)) != 0))) {
+        close(fd);
+        return NULL;
+    }
+
+    void* p = mmap(NULL, sizeof(struct shm_control), writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                   MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+
+    struct shm_control* control = (struct shm_control*)p;
+    if (writable) {
+        uint32_t zero = 0;
+        __atomic_compare_exchange_n(&control->magic, &zero, SHM_CONTROL_MAGIC, 0,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+    if (__atomic_load_n(&control->magic, __ATOMIC_RELAXED) != SHM_CONTROL_MAGIC) {
+        munmap(p, sizeof(struct shm_control));
+        return NULL;
+    }
+    return control;
+}
+
+struct fir_shm_writer* fir_shm_bank_create(const char* name, int numtaps, int filters) {
+    if (!name || name[0] != '/' || numtaps <= 0 || filters <= 0) {
+        return NULL;
+    }
+
+    struct shm_control* control = map_control(name, 1);
+    if (!control) {
+        return NULL;
+    }
+    long long generation = __atomic_load_n(&control->generation, __ATOMIC_ACQUIRE) + 1;
+    munmap(control, sizeof(struct shm_control));
+
+    struct fir_shm_writer* writer = (struct fir_shm_writer*)calloc(1, sizeof(struct fir_shm_writer));
+    if (!writer) {
+        return NULL;
+    }
+
+    // Another writer may be preparing the next generation; take the first
+    // free number
+    for (;;) {
+        if (generation_name(writer->name, name, generation) != 0) {
+            free(writer);
+            return NULL;
+        }
+        writer->fd = shm_open(writer->name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (writer->fd >= 0) {
+            break;
+        }
+        if (errno != EEXIST) {
+            free(writer);
+            return NULL;
+        }
+        generation++;
+    }
+
+    writer->size = bank_size(numtaps, filters);
+    void* p = MAP_FAILED;
+    if (ftruncate(writer->fd, writer->size) == 0) {
+        p = mmap(NULL, writer->size, PROT_READ | PROT_WRITE, MAP_SHARED, writer->fd, 0);
+    }
+    if (p == MAP_FAILED) {
+        close(writer->fd);
+        shm_unlink(writer->name);
+        free(writer);
+        return NULL;
+    }
+
+    writer->header = (struct shm_header*)p;
+    writer->header->numtaps = numtaps;
+    writer->header->filters = filters;
+    writer->header->generation = generation;
+    return writer;
+}
+
+float* fir_shm_writer_taps(struct fir_shm_writer* writer, int index) {
+    if (!writer || index < 0 || index >= writer->header->filters) {
+        return NULL;
+    }
+    return (float*)(writer->header + 1) + (size_t)index * writer->header->numtaps;
+}
+
+void fir_shm_writer_abort(struct fir_shm_writer* writer) {
+    if (!writer) return;
+    munmap(writer->header, writer->size);
+    close(writer->fd);
+    shm_unlink(writer->name);
+    free(writer);
+}
+
+long long fir_shm_bank_commit(struct fir_shm_writer* writer) {
+    if (!writer) {
+        return -1;
+    }
+
+    // The name of the bank is the generation name without its suffix
+    char name[NAME_MAX];
+    strcpy(name, writer->name);
+    *strrchr(name, '.') = '\0';
+
+    long long generation = writer->header->generation;
+    writer->header->magic = SHM_BANK_MAGIC;
+    munmap(writer->header, writer->size);
+    writer->header = NULL;
+
+    // From here on nobody can open the bank for writing
+    int ok = fchmod(writer->fd, 0444) == 0;
+    close(writer->fd);
+
+    struct shm_control* control = ok ? map_control(name, 1) : NULL;
+    if (!control) {
+        shm_unlink(writer->name);
+        free(writer);
+        return -1;
+    }
+
+    // Switch to the new generation unless a newer one got there first
+    int64_t old = __atomic_load_n(&control->generation, __ATOMIC_RELAXED);
+    while (old < generation &&
+           !__atomic_compare_exchange_n(&control->generation, &old, generation, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    munmap(control, sizeof(struct shm_control));
+
+    char old_name[NAME_MAX];
+    if (old >= generation) {
+        shm_unlink(writer->name);
+        generation = -1;
+    } else if (old > 0 && generation_name(old_name, name, old) == 0) {
+        shm_unlink(old_name);
+    }
+    free(writer);
+    return generation;
+}
+
+long long fir_shm_bank_publish(const char* name, const float* taps, int numtaps, int filters) {
+    if (!taps) {
+        return -1;
+    }
+    struct fir_shm_writer* writer = fir_shm_bank_create(name, numtaps, filters);
+    if (!writer) {
+        return -1;
+    }
+    memcpy(fir_shm_writer_taps(writer, 0), taps, (size_t)numtaps * filters * sizeof(float));
+    return fir_shm_bank_commit(writer);
+}
+
+int fir_shm_bank_unlink(const char* name) {
+    struct shm_control* control = name ? map_control(name, 0) : NULL;
+    if (!control) {
+        return -1;
+    }
+    long long generation = __atomic_load_n(&control->generation, __ATOMIC_ACQUIRE);
+    munmap((void*)control, sizeof(struct shm_control));
+
+    char gen_name[NAME_MAX];
+    if (generation > 0 && generation_name(gen_name, name, generation) == 0) {
+        shm_unlink(gen_name);
+    }
+    return shm_unlink(name);
+}
+
+// Map the current generation. Returns the header, or NULL if there is none
+// or it could not be mapped.
+static const struct shm_header* map_current(const char* name, const struct shm_control* control,
+                                            size_t* size) {
+    for (int attempt = 0; attempt < SHM_ATTACH_TRIES; attempt++) {
+        long long generation = __atomic_load_n(&control->generation, __ATOMIC_ACQUIRE);
+        char gen_name[NAME_MAX];
+        if (generation <= 0 || generation_name(gen_name, name, generation) != 0) {
+            return NULL;
+        }
+
+        // A generation that was just replaced may be gone already: try again
+        int fd = shm_open(gen_name, O_RDONLY, 0);
+        if (fd < 0) {
+            if (errno == ENOENT) continue;
+            return NULL;
+        }
+
+        struct stat st;
+        void* p = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(struct shm_header)) {
+            p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (p == MAP_FAILED) {
+            return NULL;
+        }
+
+        const struct shm_header* header = (const struct shm_header*)p;
+        if (header->magic != SHM_BANK_MAGIC || header->generation != generation ||
+            bank_size(header->numtaps, header->filters) > (size_t)st.st_size) {
+            munmap(p, st.st_size);
+            return NULL;
+        }
+        *size = st.st_size;
+        return header;
+    }
+    return NULL;
+}
+
+struct fir_shm_bank* fir_shm_bank_attach(const char* name) {
+    if (!name || strlen(name) >= NAME_MAX) {
+        return NULL;
+    }
+
+    struct fir_shm_bank* bank = (struct fir_shm_bank*)calloc(1, sizeof(struct fir_shm_bank));
+    if (!bank) {
+        return NULL;
+    }
+    strcpy(bank->name, name);
+    bank->control = map_control(name, 0);
+    if (bank->control) {
+        bank->header = map_current(name, bank->control, &bank->size);
+    }
+    if (!bank->header) {
+        fir_shm_bank_detach(bank);
+        return NULL;
+    }
+    return bank;
+}
+
+void fir_shm_bank_detach(struct fir_shm_bank* bank) {
+    if (!bank) return;
+    if (bank->header) {
+        munmap((void*)bank->header, bank->size);
+    }
+    if (bank->control) {
+        munmap((void*)bank->control, sizeof(struct shm_control));
+    }
+    free(bank);
+}
+
+int fir_shm_bank_refresh(struct fir_shm_bank* bank) {
+    if (!bank) {
+        return -1;
+    }
+    if (__atomic_load_n(&bank->control->generation, __ATOMIC_ACQUIRE) == bank->header->generation) {
+        return 0;
+    }
+
+    size_t size;
+    const struct shm_header* header = map_current(bank->name, bank->control, &size);
+    if (!header) {
+        return -1;
+    }
+    munmap((void*)bank->header, bank->size);
+    bank->header = header;
+    bank->size = size;
+    return 1;
+}
+
+const float* fir_shm_bank_taps(const struct fir_shm_bank* bank, int index) {
+    if (!bank || index < 0 || index >= bank->header->filters) {
+        return NULL;
+    }
+    return (const float*)(bank->header + 1) + (size_t)index * bank->header->numtaps;
+}
+
+int fir_shm_bank_numtaps(const struct fir_shm_bank* bank) {
+    return bank ? bank->header->numtaps : -1;
+}
+
+int fir_shm_bank_filters(const struct fir_shm_bank* bank) {
+    return bank ? bank->header->filters : -1;
+}
+
+long long fir_shm_bank_generation(const struct fir_shm_bank* bank) {
+    return bank ? bank->header->generation : -1;
+}
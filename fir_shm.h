@@ -0,0 +1,110 @@
+#ifndef FIR_SHM_H
+#define FIR_SHM_H
+
+// Filter banks shared between processes.
+//
+// A bank of filters (e.g. designed with firwin()) is published under a name
+// in POSIX shared memory, and any number of processes attach to it and use
+// the taps in place: the bank exists once per host instead of once per
+// process, and attaching is only a mapping. Published banks are read-only.
+//
+// Every publication creates a new generation; a small control object holds
+// the current generation number, which is switched atomically once the new
+// bank is complete. Attached readers keep the generation they mapped until
+// they call fir_shm_bank_refresh(), so a bank never changes under a reader.
+
+struct fir_shm_writer;
+struct fir_shm_bank;
+
+/**
+ * @brief Start a new generation of a bank, to be filled in place.
+ *
+ * @param name Name of the bank, e.g. "/lowpass_bank" (a POSIX shared memory name)
+ * @param numtaps Number of taps of each filter
+ * @param filters Number of filters
+ * @return Writer, or NULL on error
+ */
+struct fir_shm_writer* fir_shm_bank_create(const char* name, int numtaps, int filters);
+
+/**
+ * @brief Get the taps of one filter of a bank being written.
+ *
+ * @return Space for numtaps taps, e.g. to pass to firwin() as output
+ */
+float* fir_shm_writer_taps(struct fir_shm_writer* writer, int index);
+
+/**
+ * @brief Publish a bank: make it read-only and switch the current generation to it.
+ *
+ * The previous generation is unlinked; processes still attached to it keep it until they refresh or detach. The writer is freed.
+ *
+ * @return The new generation number, or -1 on error
+ */
+long long fir_shm_bank_commit(struct fir_shm_writer* writer);
+
+/**
+ * @brief Discard a bank being written. The writer is freed.
+ */
+void fir_shm_writer_abort(struct fir_shm_writer* writer);
+
+/**
+ * @brief Publish a bank from taps in memory.
+ *
+ * @param name Name of the bank
+ * @param taps Taps of all filters, filters * numtaps values, one filter after the other
+ * @param numtaps Number of taps of each filter
+ * @param filters Number of filters
+ * @return The new generation number, or -1 on error
+ */
+long long fir_shm_bank_publish(const char* name, const float* taps, int numtaps, int filters);
+
+/**
+ * @brief Remove a published bank. Attached processes keep their mappings.
+ *
+ * @return 0 on success, -1 on error
+ */
+int fir_shm_bank_unlink(const char* name);
+
+/**
+ * @brief Attach to the current generation of a published bank.
+ *
+ * @param name Name of the bank
+ * @return Bank, or NULL on error (e.g. nothing published yet)
+ */
+struct fir_shm_bank* fir_shm_bank_attach(const char* name);
+
+/**
+ * @brief Detach from a bank. Taps obtained from it become invalid.
+ */
+void fir_shm_bank_detach(struct fir_shm_bank* bank);
+
+/**
+ * @brief Switch to the current generation if a newer one has been published.
+ *
+ * Taps obtained before a switch become invalid.
+ *
+ * @return 1 if the bank switched, 0 if it is current, -1 on error (the bank is left unchanged)
+ */
+int fir_shm_bank_refresh(struct fir_shm_bank* bank);
+
+/**
+ * @brief Get the taps of one filter (read-only).
+ */
+const float* fir_shm_bank_taps(const struct fir_shm_bank* bank, int index);
+
+/**
+ * @brief Get the number of taps of each filter.
+ */
+int fir_shm_bank_numtaps(const struct fir_shm_bank* bank);
+
+/**
+ * @brief Get the number of filters.
+ */
+int fir_shm_bank_filters(const struct fir_shm_bank* bank);
+
+/**
+ * @brief Get the generation the bank is attached to.
+ */
+long long fir_shm_bank_generation(const struct fir_shm_bank* bank);
+
+#endif
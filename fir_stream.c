@@ -0,0 +1,260 @@
+#include "fir_stream.h"
+#include "fir_alloc.h"
+#include "fir_ffa.h"
+#include "fir_kernel.h"
+#include "fir_tune.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Convolution engines of the undecimated entry points, chosen by the number
+// of taps when the stream is created
+enum stream_engine {
+    ENGINE_DIRECT,      // fir_kernel_direct_tuned() with the tuned unroll and prefetch
+    ENGINE_BLOCKED,     // fir_kernel_blocked()
+    ENGINE_FFA          // Fast FIR algorithm, see fir_ffa.h; only with FIR_STREAM_FFA
+};
+
+struct fir_stream {
+    int numtaps;
+    float* rtaps;   // Taps in reverse order, so each output is a forward dot product
+    float* buf;     // numtaps-1 samples of history followed by one block of input
+    float* y;       // One block of output for the raw entry points
+    int phase;      // Input samples to skip before the next decimated output
+
+    // Formats of the raw entry points
+    enum fir_sample_format in_format;
+    enum fir_sample_format out_format;
+    int channels;
+    int dither;
+    struct fir_dither dither_state;
+
+    // Kernel configuration: the default, or from the autotuner
+    int block;      // Input samples handled per pass over the work buffer
+    int unroll;
+    int prefetch;
+    enum stream_engine engine;
+    struct fir_ffa* ffa;    // For ENGINE_FFA
+};
+
+struct fir_stream* fir_stream_create(const float* taps, int numtaps) {
+    return fir_stream_create_flags(taps, numtaps, 0);
+}
+
+struct fir_stream* fir_stream_create_flags(const float* taps, int numtaps, int flags) {
+    if (!taps || numtaps <= 0 || (flags & ~(FIR_STREAM_FFA | FIR_STREAM_TUNED))) {
+        return NULL;
+    }
+
+    struct fir_stream* stream = (struct fir_stream*)calloc(1, sizeof(struct fir_stream));
+    if (!stream) {
+        return NULL;
+    }
+
+    // Only tuned streams look at the tuning file
+    struct fir_tune_config config;
+    if (flags & FIR_STREAM_TUNED) {
+        fir_tune_lookup(numtaps, &config);
+    } else {
+        fir_tune_default(&config);
+    }
+    stream->block = config.block;
+    stream->unroll = config.unroll;
+    stream->prefetch = config.prefetch;
+    stream->engine = numtaps >= FIR_KERNEL_BLOCKED_MIN_TAPS && numtaps <= FIR_KERNEL_BLOCKED_MAX_TAPS
+                         ? ENGINE_BLOCKED : ENGINE_DIRECT;
+
+    stream->numtaps = numtaps;
+    stream->rtaps = (float*)fir_alloc(numtaps * sizeof(float), "fir_stream.taps");
+    stream->buf = (float*)fir_alloc((numtaps - 1 + (size_t)stream->block) * sizeof(float),
+                                    "fir_stream.buf");
+    stream->y = (float*)fir_alloc(stream->block * sizeof(float), "fir_stream.out");
+    if (!stream->rtaps || !stream->buf || !stream->y) {
+        fir_stream_destroy(stream);
+        return NULL;
+    }
+
+    for (int k = 0; k < numtaps; k++) {
+        stream->rtaps[k] = taps[numtaps - 1 - k];
+    }
+
+    int parallel = flags & FIR_STREAM_FFA ? fir_ffa_parallel(numtaps, stream->block) : 0;
+    if (parallel > 0) {
+        stream->ffa = fir_ffa_create(stream->rtaps, numtaps, parallel, stream->block);
+        if (!stream->ffa) {
+            fir_stream_destroy(stream);
+            return NULL;
+        }
+        stream->engine = ENGINE_FFA;
+    }
+    stream->in_format = FIR_FORMAT_F32;
+    stream->out_format = FIR_FORMAT_F32;
+    stream->channels = 1;
+    fir_dither_init(&stream->dither_state, 0);
+    return stream;
+}
+
+void fir_stream_destroy(struct fir_stream* stream) {
+    if (!stream) return;
+    fir_free(stream->rtaps);
+    fir_free(stream->buf);
+    fir_free(stream->y);
+    fir_ffa_destroy(stream->ffa);
+    free(stream);
+}
+
+void fir_stream_reset(struct fir_stream* stream) {
+    if (!stream) return;
+    memset(stream->buf, 0, (stream->numtaps - 1) * sizeof(float));
+    stream->phase = 0;
+}
+
+// Compute n outputs from the work buffer x (history followed by input)
+static void run_engine(struct fir_stream* stream, const float* x, float* y, int n) {
+    switch (stream->engine) {
+        case ENGINE_FFA:
+            fir_ffa_process(stream->ffa, x, y, n);
+            break;
+        case ENGINE_BLOCKED:
+            fir_kernel_blocked(stream->rtaps, stream->numtaps, x, y, n);
+            break;
+        default:
+            fir_kernel_direct_tuned(stream->rtaps, stream->numtaps, x, y, n, stream->unroll,
+                                    stream->prefetch);
+            break;
+    }
+}
+
+int fir_stream_process(struct fir_stream* stream, const float* in, float* out, int n) {
+    if (!stream || n < 0 || (n > 0 && (!in || !out))) {
+        return -1;
+    }
+
+    const int hist = stream->numtaps - 1;
+    float* buf = stream->buf;
+
+    while (n > 0) {
+        int len = n < stream->block ? n : stream->block;
+
+        // Append the chunk after the history; this must happen before any
+        // output is written so that in-place filtering works
+        memcpy(buf + hist, in, len * sizeof(float));
+
+        run_engine(stream, buf, out, len);
+
+        // Keep the most recent numtaps-1 samples as history for the next chunk
+        memmove(buf, buf + len, hist * sizeof(float));
+
+        in += len;
+        out += len;
+        n -= len;
+    }
+    return 0;
+}
+
+int fir_stream_decimate(struct fir_stream* stream, const float* in, float* out, int n,
+                        int factor) {
+    if (!stream || n < 0 || factor < 1 || (n > 0 && (!in || !out))) {
+        return -1;
+    }
+
+    const int hist = stream->numtaps - 1;
+    float* buf = stream->buf;
+    int phase = stream->phase % factor;
+    int written = 0;
+
+    while (n > 0) {
+        int len = n < stream->block ? n : stream->block;
+
+        // Output is written behind the input read position, so in-place works
+        memcpy(buf + hist, in, len * sizeof(float));
+
+        if (phase < len) {
+            int count = (len - phase + factor - 1) / factor;
+            fir_kernel_decimate(stream->rtaps, stream->numtaps, buf + phase, factor,
+                                out + written, count);
+            written += count;
+            phase += count * factor;
+        }
+        phase -= len;
+
+        memmove(buf, buf + len, hist * sizeof(float));
+
+        in += len;
+        n -= len;
+    }
+
+    stream->phase = phase;
+    return written;
+}
+
+int fir_stream_set_format(struct fir_stream* stream, enum fir_sample_format in_format,
+                          enum fir_sample_format out_format, int channels, int dither) {
+    if (!stream || fir_format_size(in_format) < 0 || fir_format_size(out_format) < 0 ||
+        channels < 1) {
+        return -1;
+    }
+    stream->in_format = in_format;
+    stream->out_format = out_format;
+    stream->channels = channels;
+    stream->dither = dither != 0;
+    return 0;
+}
+
+int fir_stream_process_raw(struct fir_stream* stream, const void* in, void* out, int n) {
+    if (!stream) {
+        return -1;
+    }
+
+    // Leave the decimation phase alone, like fir_stream_process()
+    int phase = stream->phase;
+    int result = fir_stream_decimate_raw(stream, in, out, n, 1);
+    stream->phase = phase;
+    return result < 0 ? -1 : 0;
+}
+
+int fir_stream_decimate_raw(struct fir_stream* stream, const void* in, void* out, int n, int factor) {
+    if (!stream || n < 0 || factor < 1 || (n > 0 && (!in || !out))) {
+        return -1;
+    }
+
+    const int hist = stream->numtaps - 1;
+    const size_t in_step = (size_t)fir_format_size(stream->in_format) * stream->channels;
+    const size_t out_step = (size_t)fir_format_size(stream->out_format) * stream->channels;
+    struct fir_dither* dither = stream->dither ? &stream->dither_state : NULL;
+    const unsigned char* src = (const unsigned char*)in;
+    unsigned char* dst = (unsigned char*)out;
+    float* buf = stream->buf;
+    float* y = stream->y;
+    int phase = stream->phase % factor;
+    int written = 0;
+
+    while (n > 0) {
+        int len = n < stream->block ? n : stream->block;
+
+        // Convert straight into the delay line, and the chunk's outputs while
+        // they are still in cache
+        fir_format_to_float(src, stream->in_format, stream->channels, buf + hist, len);
+
+        if (phase < len) {
+            int count = (len - phase + factor - 1) / factor;
+            if (factor == 1) {
+                run_engine(stream, buf, y, count);
+            } else {
+                fir_kernel_decimate(stream->rtaps, stream->numtaps, buf + phase, factor, y, count);
+            }
+            fir_format_from_float(y, dst + written * out_step, stream->out_format,
+                                  stream->channels, count, dither);
+            written += count;
+            phase += count * factor;
+        }
+        phase -= len;
+
+        memmove(buf, buf + len, hist * sizeof(float));
+
+        src += len * in_step;
+        n -= len;
+    }
+
+    stream->phase = phase;
+    return written;
+}
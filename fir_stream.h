@@ -0,0 +1,124 @@
+#ifndef FIR_STREAM_H
+#define FIR_STREAM_H
+
+#include "fir_format.h"
+
+// Streaming FIR filter engine.
+//
+// A stream owns a copy of the taps and the delay line, so a signal can be
+// fed through it block by block (of any size) and the output is identical to
+// filtering the whole signal at once. All buffers are allocated on creation;
+// processing never allocates.
+
+struct fir_stream;
+
+// Options of fir_stream_create_flags()
+enum fir_stream_flags {
+    FIR_STREAM_FFA = 1,     // Run filters of 64 to 512 taps on a fast FIR algorithm
+    FIR_STREAM_TUNED = 2    // Use the kernel configuration stored by the autotuner (fir_tune.h)
+};
+
+/**
+ * @brief Create a streaming filter.
+ *
+ * @param taps Filter coefficients, e.g. designed with firwin() (copied)
+ * @param numtaps Number of taps
+ * @return New stream, or NULL on error
+ */
+struct fir_stream* fir_stream_create(const float* taps, int numtaps);
+
+/**
+ * @brief Create a streaming filter with options.
+ *
+ * With FIR_STREAM_FFA, filters of 64 to 512 taps are computed with a fast FIR algorithm, which takes 20 to 35% less time than the
+ * default engine. Its rounding depends on where each block starts, so the output then matches filtering the whole signal at once only
+ * up to float rounding, not bit for bit. The decimating entry points are not affected.
+ *
+ * With FIR_STREAM_TUNED, the block size and kernel parameters stored by fir_tune() for the nearest number of taps are used instead of
+ * the defaults. The tuning file is read on the first such call, and with fir_tune_set_auto(1) a number of taps without a stored
+ * configuration is tuned first, which takes seconds. The output does not depend on the configuration.
+ *
+ * @param taps Filter coefficients, e.g. designed with firwin() (copied)
+ * @param numtaps Number of taps
+ * @param flags Bitwise or of fir_stream_flags, or 0 for the same stream as fir_stream_create()
+ * @return New stream, or NULL on error
+ */
+struct fir_stream* fir_stream_create_flags(const float* taps, int numtaps, int flags);
+
+/**
+ * @brief Destroy a stream created with fir_stream_create() or fir_stream_create_flags().
+ */
+void fir_stream_destroy(struct fir_stream* stream);
+
+/**
+ * @brief Clear the delay line, as if the stream had just been created.
+ */
+void fir_stream_reset(struct fir_stream* stream);
+
+/**
+ * @brief Filter a block of samples.
+ *
+ * @param stream Stream
+ * @param in Input samples
+ * @param out Output samples (may be the same buffer as in)
+ * @param n Number of samples
+ * @return 0 on success, -1 on error
+ */
+int fir_stream_process(struct fir_stream* stream, const float* in, float* out, int n);
+
+/**
+ * @brief Filter and decimate a block of samples.
+ *
+ * Only every factor-th output is computed. The decimation phase carries over
+ * between calls, so a signal can be split into blocks of any size; the first
+ * output of a fresh stream corresponds to the first input sample.
+ *
+ * @param stream Stream
+ * @param in Input samples
+ * @param out Output samples (room for n / factor + 1 samples; may be the same buffer as in)
+ * @param n Number of input samples
+ * @param factor Decimation factor (at least 1, should not change between calls)
+ * @return Number of output samples written, or -1 on error
+ */
+int fir_stream_decimate(struct fir_stream* stream, const float* in, float* out, int n,
+                        int factor);
+
+/**
+ * @brief Set the sample formats used by fir_stream_process_raw() and fir_stream_decimate_raw().
+ *
+ * The raw entry points convert the input while copying it into the delay
+ * line and convert each chunk of output right after the kernel has produced
+ * it, so integer data is filtered without separate conversion passes.
+ * The default is contiguous float in and out, without dither.
+ *
+ * @param stream Stream
+ * @param in_format Input sample format
+ * @param out_format Output sample format
+ * @param channels Number of interleaved channels in the input and output; the stream filters one of them
+ * @param dither Nonzero to add TPDF dither when the output format is an integer format
+ * @return 0 on success, -1 on error
+ */
+int fir_stream_set_format(struct fir_stream* stream, enum fir_sample_format in_format,
+                          enum fir_sample_format out_format, int channels, int dither);
+
+/**
+ * @brief Filter a block of samples in the formats set with fir_stream_set_format().
+ *
+ * @param stream Stream
+ * @param in First input sample of the filtered channel
+ * @param out First output sample of the filtered channel (may be the same buffer as in if both formats have the same size)
+ * @param n Number of samples (frames)
+ * @return 0 on success, -1 on error
+ */
+int fir_stream_process_raw(struct fir_stream* stream, const void* in, void* out, int n);
+
+/**
+ * @brief Filter and decimate a block of samples in the formats set with fir_stream_set_format().
+ *
+ * Works like fir_stream_decimate().
+ *
+ * @return Number of output samples written, or -1 on error
+ */
+int fir_stream_decimate_raw(struct fir_stream* stream, const void* in, void* out, int n, int factor);
+
+#endif
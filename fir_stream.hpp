@@ -0,0 +1,226 @@
+#ifndef FIR_STREAM_HPP
+#define FIR_STREAM_HPP
+
+// C++20 coroutine interface to the streaming filter engine (header only).
+//
+// fir::async_generator<T> is a minimal asynchronous generator: its body may
+// co_await anything (socket reads, timers, other generators) and co_yield
+// values, and the consumer pulls them with `co_await gen.next()`. The value
+// is handed over in the coroutine frame, so yielding never allocates.
+//
+// fir::filter() turns an async source of sample blocks into an async
+// sequence of filtered blocks:
+//
+//     fir::async_generator<std::span<const float>> read_blocks(socket&);
+//
+//     float taps[51];
+//     float cutoffs[2] = {0.0f, 1000.0f};
+//     firwin(51, 2, cutoffs, 48000.0f, HAMMING, taps);
+//
+//     auto filtered = fir::filter(fir::stream(taps), read_blocks(sock));
+//     while (auto block = co_await filtered.next()) {
+//         send(*block);
+//     }
+//
+// Each yielded span points into one output buffer owned by the filter
+// coroutine and allocated when it starts; it stays valid until the next
+// call to next(). Input blocks larger than that buffer are yielded in
+// several parts. As with fir_stream, the output is the same however the
+// signal is split into blocks.
+
+#include <algorithm>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include "fir_filter.h"
+#include "fir_stream.h"
+}
+
+namespace fir {
+
+/**
+ * @brief Owning handle of a struct fir_stream.
+ */
+class stream {
+public:
+    /**
+     * @brief Create a stream, as fir_stream_create_flags().
+     *
+     * @param taps Filter coefficients, e.g. designed with firwin() (copied)
+     * @param flags Bitwise or of fir_stream_flags
+     * @throws std::invalid_argument if the stream cannot be created
+     */
+    explicit stream(std::span<const float> taps, int flags = 0)
+        : handle_(fir_stream_create_flags(taps.data(), static_cast<int>(taps.size()), flags)) {
+        if (!handle_) {
+            throw std::invalid_argument("fir_stream_create_flags failed");
+        }
+    }
+
+    stream(stream&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    stream& operator=(stream&& other) noexcept {
+        if (this != &other) {
+            fir_stream_destroy(handle_);
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    stream(const stream&) = delete;
+    stream& operator=(const stream&) = delete;
+
+    ~stream() { fir_stream_destroy(handle_); }
+
+    /**
+     * @brief Filter a block of samples, as fir_stream_process().
+     *
+     * @param in Input samples
+     * @param out Output samples, at least in.size() (may be the same buffer as in)
+     * @throws std::invalid_argument if out is too small or the block is too large
+     */
+    void process(std::span<const float> in, std::span<float> out) {
+        if (out.size() < in.size() ||
+            fir_stream_process(handle_, in.data(), out.data(), static_cast<int>(in.size())) != 0) {
+            throw std::invalid_argument("fir_stream_process failed");
+        }
+    }
+
+    /**
+     * @brief Clear the delay line, as fir_stream_reset().
+     */
+    void reset() { fir_stream_reset(handle_); }
+
+    struct fir_stream* get() const { return handle_; }
+
+private:
+    struct fir_stream* handle_;
+};
+
+/**
+ * @brief Asynchronous generator of values of type T.
+ *
+ * The body runs only while the consumer awaits next(), on the consumer's
+ * thread or on whatever resumes the body's own co_await. Exceptions thrown
+ * by the body are rethrown from next().
+ */
+template <typename T>
+class async_generator {
+public:
+    struct promise_type {
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::coroutine_handle<> consumer;
+
+        // Hands control back to the consumer awaiting next()
+        struct yield_awaiter {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                return h.promise().consumer;
+            }
+            void await_resume() const noexcept {}
+        };
+
+        async_generator get_return_object() {
+            return async_generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        yield_awaiter final_suspend() const noexcept { return {}; }
+
+        yield_awaiter yield_value(T v) noexcept(std::is_nothrow_move_constructible_v<T>) {
+            value.emplace(std::move(v));
+            return {};
+        }
+        void return_void() const noexcept {}
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+    };
+
+    struct next_awaiter {
+        std::coroutine_handle<promise_type> gen;
+
+        bool await_ready() const noexcept { return !gen || gen.done(); }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept {
+            gen.promise().consumer = consumer;
+            gen.promise().value.reset();
+            return gen;
+        }
+        std::optional<T> await_resume() {
+            if (!gen) {
+                return std::nullopt;
+            }
+            promise_type& p = gen.promise();
+            if (p.error) {
+                std::rethrow_exception(std::exchange(p.error, nullptr));
+            }
+            if (gen.done()) {
+                return std::nullopt;
+            }
+            return std::move(p.value);
+        }
+    };
+
+    async_generator(async_generator&& other) noexcept : gen_(std::exchange(other.gen_, nullptr)) {}
+
+    async_generator& operator=(async_generator&& other) noexcept {
+        if (this != &other) {
+            if (gen_) gen_.destroy();
+            gen_ = std::exchange(other.gen_, nullptr);
+        }
+        return *this;
+    }
+
+    async_generator(const async_generator&) = delete;
+    async_generator& operator=(const async_generator&) = delete;
+
+    ~async_generator() {
+        if (gen_) gen_.destroy();
+    }
+
+    /**
+     * @brief Run the body to its next co_yield.
+     *
+     * @return Awaitable giving the yielded value, or std::nullopt once the body has finished
+     */
+    next_awaiter next() noexcept { return next_awaiter{gen_}; }
+
+private:
+    explicit async_generator(std::coroutine_handle<promise_type> gen) : gen_(gen) {}
+
+    std::coroutine_handle<promise_type> gen_;
+};
+
+/**
+ * @brief Filter an async sequence of sample blocks.
+ *
+ * @param engine Stream to run the blocks through (moved into the coroutine)
+ * @param source Input blocks; each must stay valid until the next one is requested
+ * @param capacity Size of the output buffer, and the largest block yielded
+ * @return Filtered blocks, each valid until the next call to next()
+ */
+inline async_generator<std::span<const float>> filter(stream engine,
+                                                       async_generator<std::span<const float>> source,
+                                                       std::size_t capacity = 4096) {
+    // The only buffer: allocated once, overwritten by every block
+    std::vector<float> out(capacity > 0 ? capacity : 1);
+    while (std::optional<std::span<const float>> block = co_await source.next()) {
+        std::span<const float> in = *block;
+        while (!in.empty()) {
+            const std::size_t n = std::min(in.size(), out.size());
+            engine.process(in.first(n), out);
+            co_yield std::span<const float>(out.data(), n);
+            in = in.subspan(n);
+        }
+    }
+}
+
+} // namespace fir
+
+#endif
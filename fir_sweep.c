@@ -0,0 +1,171 @@
+#include "fir_sweep.h"
+#include "fir_alloc.h"
+#include "fir_kernel.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Number of input samples handled per pass over the work buffer
+#define FIR_SWEEP_CHUNK 1024
+
+struct fir_sweep {
+    int numtaps;
+    int grid_points;
+    int update_interval;
+    int phase;      // Samples filtered with the current taps, up to update_interval
+    float f_min;
+    float f_max;
+    float* grid;    // grid_points rows of reversed taps
+    float* work;    // Interpolated taps for the current sub-block
+    float* buf;     // numtaps-1 samples of history followed by one chunk of input
+};
+
+struct fir_sweep* fir_sweep_create(int numtaps, float fs, enum fir_filter_window_type window,
+                                   float bandwidth, float f_min, float f_max, int grid_points,
+                                   int update_interval) {
+    if (numtaps <= 0 || grid_points < 2 || update_interval < 1 || bandwidth < 0.0f ||
+        !(f_min < f_max)) {
+        return NULL;
+    }
+
+    struct fir_sweep* sweep = (struct fir_sweep*)calloc(1, sizeof(struct fir_sweep));
+    if (!sweep) {
+        return NULL;
+    }
+    sweep->numtaps = numtaps;
+    sweep->grid_points = grid_points;
+    sweep->update_interval = update_interval;
+    sweep->f_min = f_min;
+    sweep->f_max = f_max;
+    sweep->grid = (float*)fir_alloc((size_t)grid_points * numtaps * sizeof(float), "fir_sweep.grid");
+    sweep->work = (float*)fir_alloc(numtaps * sizeof(float), "fir_sweep.work");
+    sweep->buf = (float*)fir_alloc((numtaps - 1 + FIR_SWEEP_CHUNK) * sizeof(float), "fir_sweep.buf");
+    float* taps = (float*)malloc(numtaps * sizeof(float));
+    if (!sweep->grid || !sweep->work || !sweep->buf || !taps) {
+        free(taps);
+        fir_sweep_destroy(sweep);
+        return NULL;
+    }
+
+    // Only the band edges move between grid points, so a design handle
+    // updates each design incrementally
+    struct firwin_design* design = NULL;
+    for (int g = 0; g < grid_points; g++) {
+        float f = f_min + (f_max - f_min) * g / (grid_points - 1);
+        float cutoffs[2];
+        if (bandwidth == 0.0f) {
+            cutoffs[0] = 0.0f;
+            cutoffs[1] = f;
+        } else {
+            cutoffs[0] = f - 0.5f * bandwidth;
+            cutoffs[1] = f + 0.5f * bandwidth;
+        }
+
+        int ok;
+        if (!design) {
+            design = firwin_design_create(numtaps, 2, cutoffs, fs, window);
+            ok = design != NULL;
+        } else {
+            ok = firwin_design_set_cutoffs(design, cutoffs) == 0;
+        }
+        if (!ok || firwin_design_taps(design, taps) != 0) {
+            firwin_design_destroy(design);
+            free(taps);
+            fir_sweep_destroy(sweep);
+            return NULL;
+        }
+
+        float* row = sweep->grid + (size_t)g * numtaps;
+        for (int k = 0; k < numtaps; k++) {
+            row[k] = taps[numtaps - 1 - k];
+        }
+    }
+
+    firwin_design_destroy(design);
+    free(taps);
+    return sweep;
+}
+
+void fir_sweep_destroy(struct fir_sweep* sweep) {
+    if (!sweep) return;
+    fir_free(sweep->grid);
+    fir_free(sweep->work);
+    fir_free(sweep->buf);
+    free(sweep);
+}
+
+void fir_sweep_reset(struct fir_sweep* sweep) {
+    if (!sweep) return;
+    memset(sweep->buf, 0, (sweep->numtaps - 1) * sizeof(float));
+    sweep->phase = 0;
+}
+
+// Find the grid row below frequency f and the interpolation weight of the
+// row above it
+static const float* grid_position(const struct fir_sweep* sweep, float f, float* weight) {
+    if (f < sweep->f_min) f = sweep->f_min;
+    if (f > sweep->f_max) f = sweep->f_max;
+
+    float pos = (f - sweep->f_min) / (sweep->f_max - sweep->f_min) * (sweep->grid_points - 1);
+    int g = (int)pos;
+    if (g > sweep->grid_points - 2) {
+        g = sweep->grid_points - 2;
+    }
+    *weight = pos - g;
+    return sweep->grid + (size_t)g * sweep->numtaps;
+}
+
+int fir_sweep_process(struct fir_sweep* sweep, const float* in, float* out, int n,
+                      float f_start, float f_end) {
+    if (!sweep || n < 0 || (n > 0 && (!in || !out))) {
+        return -1;
+    }
+
+    const int numtaps = sweep->numtaps;
+    const int hist = numtaps - 1;
+    const int interval = sweep->update_interval;
+    const float slope = n > 0 ? (f_end - f_start) / n : 0.0f;
+    float* buf = sweep->buf;
+    int base = 0;
+
+    while (base < n) {
+        int len = n - base < FIR_SWEEP_CHUNK ? n - base : FIR_SWEEP_CHUNK;
+        memcpy(buf + hist, in + base, len * sizeof(float));
+
+        if (interval == 1) {
+            // Interpolate the outputs of the two neighbouring designs
+            for (int j = 0; j < len; j++) {
+                float a;
+                const float* lo = grid_position(sweep, f_start + slope * (base + j), &a);
+                float y0, y1;
+                fir_kernel_direct(lo, numtaps, buf + j, &y0, 1);
+                fir_kernel_direct(lo + numtaps, numtaps, buf + j, &y1, 1);
+                out[base + j] = y0 + a * (y1 - y0);
+            }
+        } else {
+            // Interpolate the taps once per update_interval samples, counted
+            // across chunks and calls, at the frequency of the middle of
+            // those samples (following this block's sweep past its end)
+            for (int j = 0; j < len;) {
+                if (sweep->phase == 0) {
+                    float a;
+                    const float* lo = grid_position(sweep,
+                                                    f_start + slope * (base + j + 0.5f * (interval - 1)),
+                                                    &a);
+                    const float* hi = lo + numtaps;
+                    for (int k = 0; k < numtaps; k++) {
+                        sweep->work[k] = lo[k] + a * (hi[k] - lo[k]);
+                    }
+                }
+                int count = len - j < interval - sweep->phase ? len - j : interval - sweep->phase;
+                fir_kernel_direct(sweep->work, numtaps, buf + j, out + base + j, count);
+                sweep->phase = (sweep->phase + count) % interval;
+                j += count;
+            }
+        }
+
+        memmove(buf, buf + len, hist * sizeof(float));
+        base += len;
+    }
+    return 0;
+}
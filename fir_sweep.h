@@ -0,0 +1,65 @@
+#ifndef FIR_SWEEP_H
+#define FIR_SWEEP_H
+
+#include "fir_filter.h"
+
+// Time-varying filter with a smoothly swept passband.
+//
+// A grid of firwin() designs is computed once over the sweep range; while
+// filtering, the taps for the current frequency are interpolated linearly
+// between the two nearest grid designs, either for every sample or once per
+// sub-block. The cost per sample is fixed and there are no jumps in the
+// response when the frequency changes.
+
+struct fir_sweep;
+
+/**
+ * @brief Create a swept filter.
+ *
+ * The swept frequency is the cutoff of a lowpass filter if bandwidth is 0,
+ * or the center of a passband of the given width otherwise.
+ *
+ * @param numtaps Number of taps
+ * @param fs Sampling frequency in Hz
+ * @param window Window type
+ * @param bandwidth Width of the passband in Hz, or 0 for a lowpass filter
+ * @param f_min Lowest swept frequency in Hz
+ * @param f_max Highest swept frequency in Hz
+ * @param grid_points Number of designs over [f_min, f_max] (at least 2)
+ * @param update_interval Samples between tap updates: 1 interpolates every sample, larger values interpolate the taps exactly every
+ *        update_interval samples, counted across calls
+ * @return New filter, or NULL on error
+ */
+struct fir_sweep* fir_sweep_create(int numtaps, float fs, enum fir_filter_window_type window,
+                                   float bandwidth, float f_min, float f_max, int grid_points,
+                                   int update_interval);
+
+/**
+ * @brief Destroy a filter created with fir_sweep_create().
+ */
+void fir_sweep_destroy(struct fir_sweep* sweep);
+
+/**
+ * @brief Clear the delay line and start a new tap update interval.
+ */
+void fir_sweep_reset(struct fir_sweep* sweep);
+
+/**
+ * @brief Filter a block while sweeping the frequency.
+ *
+ * Sample i of the block is filtered at frequency f_start + (f_end - f_start) * i / n, clamped to [f_min, f_max]. Passing the previous
+ * block's f_end as the next f_start gives a continuous sweep. With an update_interval above 1, the taps are interpolated at the
+ * frequency of the middle of each interval; for an interval that extends past the block, that frequency follows the block's sweep.
+ *
+ * @param sweep Filter
+ * @param in Input samples
+ * @param out Output samples (may be the same buffer as in)
+ * @param n Number of samples
+ * @param f_start Frequency at the start of the block in Hz
+ * @param f_end Frequency at the end of the block in Hz
+ * @return 0 on success, -1 on error
+ */
+int fir_sweep_process(struct fir_sweep* sweep, const float* in, float* out, int n,
+                      float f_start, float f_end);
+
+#endif
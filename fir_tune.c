@@ -0,0 +1,347 @@
+#include "fir_tune.h"
+#include "fir_kernel.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TUNE_DEFAULT_BLOCK 1024
+#define TUNE_MAX_MODEL 128
+
+// Timing runs per configuration; the fastest counts
+#define TUNE_RUNS 3
+
+// Multiply-adds per timing run (bounded by the sample counts below)
+#define TUNE_WORK (1 << 24)
+
+static const int tune_blocks[] = { 256, 512, 1024, 2048, 4096, 8192 };
+#define TUNE_BLOCKS ((int)(sizeof(tune_blocks) / sizeof(tune_blocks[0])))
+static const int tune_unrolls[] = { 1, 2, 4, 8 };
+static const int tune_prefetches[] = { 0, 16, 64, 256 };
+
+struct tune_entry {
+    char model[TUNE_MAX_MODEL];
+    int numtaps;
+    struct fir_tune_config config;
+};
+
+static pthread_mutex_t tune_lock = PTHREAD_MUTEX_INITIALIZER;
+static int tune_loaded;
+static struct tune_entry* tune_entries;
+static int tune_count;
+static char tune_model[TUNE_MAX_MODEL];
+static int tune_auto;
+
+void fir_tune_default(struct fir_tune_config* config) {
+    if (!config) return;
+    config->block = TUNE_DEFAULT_BLOCK;
+    config->unroll = 1;
+    config->prefetch = 0;
+}
+
+static void tune_path(char* path, size_t size) {
+    const char* env = getenv("FIR_TUNE_FILE");
+    const char* home = getenv("HOME");
+    if (env && *env) {
+        snprintf(path, size, "%s", env);
+    } else {
+        snprintf(path, size, "%s/.firfilter_tune", home ? home : ".");
+    }
+}
+
+// CPU model name from /proc/cpuinfo, with tabs replaced so it can be a field
+static void read_model(char* model) {
+    strcpy(model, "unknown");
+    FILE* f = fopen("/proc/cpuinfo", "r");
+    if (!f) return;
+
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "model name", 10) == 0) {
+            char* value = strchr(line, ':');
+            if (value) {
+                value++;
+                while (*value == ' ') value++;
+                value[strcspn(value, "\n")] = '\0';
+                snprintf(model, TUNE_MAX_MODEL, "%s", value);
+                for (char* c = model; *c; c++) {
+                    if (*c == '\t') *c = ' ';
+                }
+            }
+            break;
+        }
+    }
+    fclose(f);
+}
+
+static int valid_config(const struct fir_tune_config* c) {
+    return c->block >= 1 &&
+           (c->unroll == 1 || c->unroll == 2 || c->unroll == 4 || c->unroll == 8) &&
+           c->prefetch >= 0 && c->prefetch <= 1 << 16;
+}
+
+static int add_entry(const char* model, int numtaps, const struct fir_tune_config* config) {
+    for (int i = 0; i < tune_count; i++) {
+        if (tune_entries[i].numtaps == numtaps && strcmp(tune_entries[i].model, model) == 0) {
+            tune_entries[i].config = *config;
+            return 0;
+        }
+    }
+    struct tune_entry* e = (struct tune_entry*)realloc(tune_entries, (tune_count + 1) * sizeof(*e));
+    if (!e) {
+        return -1;
+    }
+    tune_entries = e;
+    snprintf(e[tune_count].model, TUNE_MAX_MODEL, "%s", model);
+    e[tune_count].numtaps = numtaps;
+    e[tune_count].config = *config;
+    tune_count++;
+    return 0;
+}
+
+// Add the entries of the file at path, replacing those already known; the
+// caller holds tune_lock.
+// Lines are: model <tab> numtaps <tab> block <tab> unroll <tab> prefetch
+static void read_locked(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return;
+
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        char* tab = strchr(line, '\t');
+        if (!tab) continue;
+        *tab = '\0';
+
+        int numtaps;
+        struct fir_tune_config c;
+        if (sscanf(tab + 1, "%d\t%d\t%d\t%d", &numtaps, &c.block, &c.unroll, &c.prefetch) == 4 &&
+            numtaps > 0 && valid_config(&c)) {
+            // The engines' buffers are sized for the blocks the tuner tries
+            if (c.block < tune_blocks[0]) c.block = tune_blocks[0];
+            if (c.block > tune_blocks[TUNE_BLOCKS - 1]) c.block = tune_blocks[TUNE_BLOCKS - 1];
+            add_entry(line, numtaps, &c);
+        }
+    }
+    fclose(f);
+}
+
+// Load the file once per process; the caller holds tune_lock
+static void load_locked(void) {
+    if (tune_loaded) return;
+    tune_loaded = 1;
+    read_model(tune_model);
+
+    char path[4096];
+    tune_path(path, sizeof(path));
+    read_locked(path);
+}
+
+// Store one entry. Other processes may have tuned other lengths since the
+// file was loaded, so under an exclusive lock on path.lock the file is read
+// again, the entry added, and everything written to a temporary file that
+// is moved into place, so readers never see a partial file; the caller
+// holds tune_lock.
+static int save_locked(int numtaps, const struct fir_tune_config* config) {
+    char path[4096];
+    char lock[4200];
+    char tmp[4200];
+    tune_path(path, sizeof(path));
+    snprintf(lock, sizeof(lock), "%s.lock", path);
+    snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path, (long)getpid());
+
+    int lock_fd = open(lock, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lock_fd < 0) {
+        return -1;
+    }
+    if (flock(lock_fd, LOCK_EX) != 0) {
+        close(lock_fd);
+        return -1;
+    }
+
+    read_locked(path);
+    int result = add_entry(tune_model, numtaps, config);
+    FILE* f = result == 0 ? fopen(tmp, "w") : NULL;
+    if (!f) {
+        result = -1;
+    }
+    for (int i = 0; f && i < tune_count; i++) {
+        const struct tune_entry* e = &tune_entries[i];
+        fprintf(f, "%s\t%d\t%d\t%d\t%d\n", e->model, e->numtaps, e->config.block,
+                e->config.unroll, e->config.prefetch);
+    }
+    if (f && (fclose(f) != 0 || rename(tmp, path) != 0)) {
+        remove(tmp);
+        result = -1;
+    }
+
+    flock(lock_fd, LOCK_UN);
+    close(lock_fd);
+    return result;
+}
+
+// Entry of this CPU model with the nearest number of taps (within a factor
+// of 2); the caller holds tune_lock
+static const struct tune_entry* find_locked(int numtaps) {
+    const struct tune_entry* best = NULL;
+    double best_ratio = 2.0;
+    for (int i = 0; i < tune_count; i++) {
+        const struct tune_entry* e = &tune_entries[i];
+        if (strcmp(e->model, tune_model) != 0) continue;
+        double ratio = e->numtaps > numtaps ? (double)e->numtaps / numtaps : (double)numtaps / e->numtaps;
+        if (ratio <= best_ratio) {
+            best = e;
+            best_ratio = ratio;
+        }
+    }
+    return best;
+}
+
+int fir_tune_lookup(int numtaps, struct fir_tune_config* config) {
+    if (!config) {
+        return 0;
+    }
+    fir_tune_default(config);
+    if (numtaps <= 0) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&tune_lock);
+    load_locked();
+    const struct tune_entry* e = find_locked(numtaps);
+    int exact = e && e->numtaps == numtaps;
+    if (e) {
+        *config = e->config;
+    }
+    pthread_mutex_unlock(&tune_lock);
+
+    // In auto mode, every new length is measured once; a configuration that
+    // was measured but could not be saved is still used
+    if (!exact && __atomic_load_n(&tune_auto, __ATOMIC_RELAXED)) {
+        struct fir_tune_config measured = { 0, 0, 0 };
+        fir_tune(NULL, numtaps, &measured);
+        if (measured.block > 0) {
+            *config = measured;
+            return 1;
+        }
+    }
+    return e != NULL;
+}
+
+void fir_tune_set_auto(int enable) {
+    __atomic_store_n(&tune_auto, enable != 0, __ATOMIC_RELAXED);
+}
+
+int fir_tune_get_auto(void) {
+    return __atomic_load_n(&tune_auto, __ATOMIC_RELAXED);
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Time the streaming loop of fir_stream_process() with one configuration
+static double measure(const float* rtaps, int numtaps, const float* in, float* out, int n,
+                      float* buf, const struct fir_tune_config* c) {
+    const int hist = numtaps - 1;
+    // Mid-size filters run the blocked kernel, which only the block size
+    // affects
+    const int blocked = numtaps >= FIR_KERNEL_BLOCKED_MIN_TAPS && numtaps <= FIR_KERNEL_BLOCKED_MAX_TAPS;
+    double best = 1e30;
+    for (int run = 0; run < TUNE_RUNS; run++) {
+        double start = now();
+        for (int pos = 0; pos < n; pos += c->block) {
+            int len = n - pos < c->block ? n - pos : c->block;
+            memcpy(buf + hist, in + pos, len * sizeof(float));
+            if (blocked) {
+                fir_kernel_blocked(rtaps, numtaps, buf, out + pos, len);
+            } else {
+                fir_kernel_direct_tuned(rtaps, numtaps, buf, out + pos, len, c->unroll, c->prefetch);
+            }
+            memmove(buf, buf + len, hist * sizeof(float));
+        }
+        double t = now() - start;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+int fir_tune(const float* taps, int numtaps, struct fir_tune_config* best) {
+    if (numtaps <= 0) {
+        return -1;
+    }
+
+    const int max_block = tune_blocks[TUNE_BLOCKS - 1];
+    long long samples = TUNE_WORK / numtaps;
+    int n = samples < 4 * max_block ? 4 * max_block : samples > (1 << 20) ? (1 << 20) : (int)samples;
+
+    float* rtaps = (float*)malloc(numtaps * sizeof(float));
+    float* in = (float*)malloc(n * sizeof(float));
+    float* out = (float*)malloc(n * sizeof(float));
+    float* buf = (float*)calloc(numtaps - 1 + max_block, sizeof(float));
+    if (!rtaps || !in || !out || !buf) {
+        free(rtaps);
+        free(in);
+        free(out);
+        free(buf);
+        return -1;
+    }
+
+    // Without taps a lowpass-like stand-in is timed; the values do not
+    // affect the speed
+    unsigned seed = 1;
+    for (int k = 0; k < numtaps; k++) {
+        rtaps[k] = taps ? taps[numtaps - 1 - k] : 1.0f / numtaps;
+    }
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        in[i] = (float)(seed >> 8) / 16777216.0f - 0.5f;
+    }
+
+    struct fir_tune_config winner;
+    fir_tune_default(&winner);
+    double winner_time = measure(rtaps, numtaps, in, out, n, buf, &winner);
+
+    // The blocked kernel has no unroll or prefetch setting, so only the block
+    // size is swept for it
+    const int blocked = numtaps >= FIR_KERNEL_BLOCKED_MIN_TAPS && numtaps <= FIR_KERNEL_BLOCKED_MAX_TAPS;
+    const size_t unrolls = blocked ? 1 : sizeof(tune_unrolls) / sizeof(tune_unrolls[0]);
+    const size_t prefetches = blocked ? 1 : sizeof(tune_prefetches) / sizeof(tune_prefetches[0]);
+    for (int b = 0; b < TUNE_BLOCKS; b++) {
+        for (size_t u = 0; u < unrolls; u++) {
+            for (size_t p = 0; p < prefetches; p++) {
+                struct fir_tune_config c = { tune_blocks[b], tune_unrolls[u], tune_prefetches[p] };
+                double t = measure(rtaps, numtaps, in, out, n, buf, &c);
+                if (t < winner_time) {
+                    winner = c;
+                    winner_time = t;
+                }
+            }
+        }
+    }
+
+    free(rtaps);
+    free(in);
+    free(out);
+    free(buf);
+
+    if (best) {
+        *best = winner;
+    }
+
+    // The winner is kept for this process even if the file cannot be
+    // written, so the length is not measured again
+    pthread_mutex_lock(&tune_lock);
+    load_locked();
+    int result = add_entry(tune_model, numtaps, &winner);
+    if (save_locked(numtaps, &winner) != 0) {
+        result = -1;
+    }
+    pthread_mutex_unlock(&tune_lock);
+    return result;
+}
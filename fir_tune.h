@@ -0,0 +1,68 @@
+#ifndef FIR_TUNE_H
+#define FIR_TUNE_H
+
+// Autotuning of the streaming filter kernel.
+//
+// The fastest block size (samples per pass over the delay line), unroll
+// factor (outputs computed per pass over the taps) and prefetch distance
+// depend on the number of taps and on the caches of the machine. The tuner
+// times every combination for a filter on the running machine and stores
+// the winner in a local file, keyed by CPU model and number of taps.
+// Streams created with FIR_STREAM_TUNED apply the stored configuration of
+// the nearest number of taps (within a factor of 2); other streams use the
+// default and never read the file. The results are the
+// same for every configuration, apart from rounding for streams created
+// with FIR_STREAM_FFA, whose output pairs follow the block size.
+//
+// The file is $FIR_TUNE_FILE if set, otherwise ~/.firfilter_tune. Processes
+// tuning at the same time merge their results under a lock on the file's
+// name with ".lock" appended.
+
+struct fir_tune_config {
+    int block;      // Samples per pass over the delay line
+    int unroll;     // Outputs per pass over the taps (1, 2, 4 or 8)
+    int prefetch;   // Prefetch distance in samples, 0 for none
+};
+
+/**
+ * @brief Time every configuration for a filter, store the fastest and return it.
+ *
+ * Takes a few seconds. Filters of 32 to 512 taps run on a kernel with no unroll or prefetch setting, so for them only the block size
+ * is timed.
+ *
+ * @param taps Filter coefficients (only used for timing)
+ * @param numtaps Number of taps
+ * @param best Output configuration (may be NULL); set whenever the timing succeeded
+ * @return 0 on success, -1 on error (the configuration could not be measured or stored). A configuration that was measured but not
+ *         stored is still used by this process's FIR_STREAM_TUNED streams.
+ */
+int fir_tune(const float* taps, int numtaps, struct fir_tune_config* best);
+
+/**
+ * @brief Get the default configuration, used by streams created without FIR_STREAM_TUNED.
+ */
+void fir_tune_default(struct fir_tune_config* config);
+
+/**
+ * @brief Get the configuration FIR_STREAM_TUNED streams use for a number of taps.
+ *
+ * @param numtaps Number of taps
+ * @param config Output configuration: the stored one, or the default
+ * @return 1 if a stored configuration was found, 0 if the default is returned
+ */
+int fir_tune_lookup(int numtaps, struct fir_tune_config* config);
+
+/**
+ * @brief Enable or disable autotuning on creation.
+ *
+ * When enabled, creating a stream with FIR_STREAM_TUNED runs fir_tune() for filters whose number of taps has no stored configuration
+ * yet.
+ */
+void fir_tune_set_auto(int enable);
+
+/**
+ * @brief Check whether autotuning on creation is enabled.
+ */
+int fir_tune_get_auto(void);
+
+#endif
@@ -0,0 +1,208 @@
+#include "fir_wav.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_FLOAT 3
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+// Size field value of a chunk whose length is not known
+#define WAV_SIZE_UNKNOWN 0xFFFFFFFFu
+
+// Header sizes of the plain and the extensible format, up to the samples
+#define WAV_HEADER 44
+#define WAV_HEADER_EXTENSIBLE 68
+
+// Tail of the KSDATAFORMAT_SUBTYPE GUIDs after the 16-bit format tag
+static const unsigned char wav_guid_tail[14] = {
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+};
+
+static int read_full(int fd, unsigned char* data, size_t len) {
+    while (len > 0) {
+        ssize_t r = read(fd, data, len);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        data += r;
+        len -= r;
+    }
+    return 0;
+}
+
+static int write_full(int fd, const unsigned char* data, size_t len) {
+    while (len > 0) {
+        ssize_t r = write(fd, data, len);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        data += r;
+        len -= r;
+    }
+    return 0;
+}
+
+static unsigned get16(const unsigned char* p) {
+    return p[0] | (unsigned)p[1] << 8;
+}
+
+static uint32_t get32(const unsigned char* p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void put16(unsigned char* p, unsigned v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void put32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+int fir_wav_read_header(int fd, struct fir_wav_info* info) {
+    if (!info) {
+        return -1;
+    }
+
+    unsigned char riff[12];
+    if (read_full(fd, riff, 12) != 0 || memcmp(riff, "RIFF", 4) != 0 ||
+        memcmp(riff + 8, "WAVE", 4) != 0) {
+        return -1;
+    }
+
+    int have_fmt = 0;
+    unsigned block = 0;
+    for (;;) {
+        unsigned char chunk[8];
+        if (read_full(fd, chunk, 8) != 0) {
+            return -1;
+        }
+        uint32_t size = get32(chunk + 4);
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            unsigned char fmt[40];
+            if (size < 16 || size > sizeof(fmt) || read_full(fd, fmt, size + (size & 1)) != 0) {
+                return -1;
+            }
+            unsigned tag = get16(fmt);
+            if (tag == WAV_FORMAT_EXTENSIBLE && size >= 26) {
+                tag = get16(fmt + 24);
+            }
+            unsigned bits = get16(fmt + 14);
+            info->channels = (int)get16(fmt + 2);
+            info->rate = (int)get32(fmt + 4);
+            block = get16(fmt + 12);
+
+            if (tag == WAV_FORMAT_PCM && bits == 16) info->format = FIR_FORMAT_S16;
+            else if (tag == WAV_FORMAT_PCM && bits == 24) info->format = FIR_FORMAT_S24;
+            else if (tag == WAV_FORMAT_PCM && bits == 32) info->format = FIR_FORMAT_S32;
+            else if (tag == WAV_FORMAT_FLOAT && bits == 32) info->format = FIR_FORMAT_F32;
+            else return -1;
+
+            if (info->channels < 1 ||
+                block != (unsigned)info->channels * fir_format_size(info->format)) {
+                return -1;
+            }
+            have_fmt = 1;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!have_fmt) {
+                return -1;
+            }
+            // 0 is an empty file; only the marker means the size is unknown
+            info->frames = size == WAV_SIZE_UNKNOWN ? -1 : (long long)(size / block);
+            return 0;
+        } else {
+            // Skip other chunks by reading them, which also works on pipes
+            unsigned char skip[256];
+            uint64_t left = (uint64_t)size + (size & 1);
+            while (left > 0) {
+                size_t len = left < sizeof(skip) ? (size_t)left : sizeof(skip);
+                if (read_full(fd, skip, len) != 0) {
+                    return -1;
+                }
+                left -= len;
+            }
+        }
+    }
+}
+
+// WAVE_FORMAT_EXTENSIBLE is required for more than 2 channels and for
+// integer samples of more than 16 bits
+static int header_size(const struct fir_wav_info* info) {
+    return info->channels > 2 || (info->format != FIR_FORMAT_F32 && fir_format_size(info->format) > 2)
+               ? WAV_HEADER_EXTENSIBLE : WAV_HEADER;
+}
+
+// Size of the data chunk, or the unknown marker if it does not fit
+static uint32_t data_size(const struct fir_wav_info* info) {
+    long long bytes = info->frames * info->channels * fir_format_size(info->format);
+    if (info->frames < 0 || bytes > (long long)(WAV_SIZE_UNKNOWN - (header_size(info) - 8))) {
+        return WAV_SIZE_UNKNOWN;
+    }
+    return (uint32_t)bytes;
+}
+
+// Value of the RIFF size field: everything after it
+static uint32_t riff_size(const struct fir_wav_info* info) {
+    uint32_t size = data_size(info);
+    return size == WAV_SIZE_UNKNOWN ? size : (uint32_t)(header_size(info) - 8) + size;
+}
+
+int fir_wav_write_header(int fd, const struct fir_wav_info* info) {
+    if (!info || info->channels < 1 || info->rate <= 0 || fir_format_size(info->format) < 0) {
+        return -1;
+    }
+
+    const int sample = fir_format_size(info->format);
+    const int len = header_size(info);
+    const unsigned tag = info->format == FIR_FORMAT_F32 ? WAV_FORMAT_FLOAT : WAV_FORMAT_PCM;
+    unsigned char h[WAV_HEADER_EXTENSIBLE];
+    memcpy(h, "RIFF", 4);
+    put32(h + 4, riff_size(info));
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put32(h + 16, len - 28);
+    put16(h + 20, len == WAV_HEADER ? tag : WAV_FORMAT_EXTENSIBLE);
+    put16(h + 22, info->channels);
+    put32(h + 24, info->rate);
+    put32(h + 28, (uint32_t)info->rate * info->channels * sample);
+    put16(h + 32, info->channels * sample);
+    put16(h + 34, 8 * sample);
+    if (len == WAV_HEADER_EXTENSIBLE) {
+        // All bits valid, no speaker positions assigned, then the subformat
+        put16(h + 36, 22);
+        put16(h + 38, 8 * sample);
+        put32(h + 40, 0);
+        put16(h + 44, tag);
+        memcpy(h + 46, wav_guid_tail, sizeof(wav_guid_tail));
+    }
+    memcpy(h + len - 8, "data", 4);
+    put32(h + len - 4, data_size(info));
+    return write_full(fd, h, len);
+}
+
+int fir_wav_finish(int fd, const struct fir_wav_info* info) {
+    if (!info || info->frames < 0) {
+        return -1;
+    }
+
+    // pwrite() on a file opened for appending writes at the end instead
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0) {
+        return -1;
+    }
+    if (flags & O_APPEND) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    unsigned char riff[4];
+    unsigned char data[4];
+    put32(riff, riff_size(info));
+    put32(data, data_size(info));
+    if (pwrite(fd, riff, 4, 4) != 4 || pwrite(fd, data, 4, header_size(info) - 4) != 4) {
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+#ifndef FIR_WAV_H
+#define FIR_WAV_H
+
+#include "fir_format.h"
+
+// Minimal WAV container support.
+//
+// Reads and writes the header of PCM (16, 24 or 32 bit) and 32-bit float
+// WAV files on a file descriptor; the samples follow as raw interleaved
+// frames in the given format. Headers are read sequentially, so the input
+// can be a pipe. More than 2 channels or integer samples of more than 16
+// bits are written as WAVE_FORMAT_EXTENSIBLE, as the format requires.
+
+struct fir_wav_info {
+    int channels;
+    int rate;                       // Sampling frequency in Hz
+    enum fir_sample_format format;
+    long long frames;               // Number of frames, or -1 if unknown (streamed, size 0xFFFFFFFF)
+};
+
+/**
+ * @brief Read a WAV header, leaving fd at the first sample.
+ *
+ * @param fd File descriptor to read from
+ * @param info Output stream parameters
+ * @return 0 on success, -1 on error or unsupported format
+ */
+int fir_wav_read_header(int fd, struct fir_wav_info* info);
+
+/**
+ * @brief Write a WAV header.
+ *
+ * If info->frames is -1 the sizes are written as unknown (as used for
+ * streaming); fir_wav_finish() can fill them in later on a seekable file.
+ *
+ * @param fd File descriptor to write to
+ * @param info Stream parameters
+ * @return 0 on success, -1 on error
+ */
+int fir_wav_write_header(int fd, const struct fir_wav_info* info);
+
+/**
+ * @brief Fill in the sizes of a header written with fir_wav_write_header().
+ *
+ * @param fd File descriptor the header was written to at offset 0 (must be seekable and not opened with O_APPEND)
+ * @param info Stream parameters as passed to fir_wav_write_header(), with the final number of frames
+ * @return 0 on success, -1 on error with errno set (e.g. ESPIPE if fd is a pipe)
+ */
+int fir_wav_finish(int fd, const struct fir_wav_info* info);
+
+#endif